@@ -44,6 +44,11 @@
 
 
 
+/* number of threads used to extract the exif dates */
+#define THUNAR_SBR_EXIF_MAX_THREADS (4)
+
+
+
 /* Property identifiers */
 enum
 {
@@ -69,8 +74,12 @@ static gchar  *thunar_sbr_get_time_string           (guint64
                                                      const gchar               *custom_format);
 #ifdef HAVE_EXIF
 static guint64 thunar_sbr_get_time_from_string      (const gchar               *string);
+static void    thunar_sbr_exif_job_run              (gpointer                   data,
+                                                     gpointer                   user_data);
+static gboolean thunar_sbr_exif_job_finished        (gpointer                   data);
 #endif
-static guint64 thunar_sbr_get_time                  (ThunarxFileInfo           *file,
+static guint64 thunar_sbr_get_time                  (ThunarSbrDateRenamer      *date_renamer,
+                                                     ThunarxFileInfo           *file,
                                                      ThunarSbrDateMode          mode);
 static gchar  *thunar_sbr_date_renamer_process      (ThunarxRenamer            *renamer,
                                                      ThunarxFileInfo           *file,
@@ -91,8 +100,36 @@ struct _ThunarSbrDateRenamer
   guint               offset;
   ThunarSbrOffsetMode offset_mode;
   gchar              *format;
+
+#ifdef HAVE_EXIF
+  /* cache of the exif dates, filename -> ThunarSbrExifEntry */
+  GHashTable         *exif_cache;
+
+  /* the pool extracting the exif dates of uncached files */
+  GThreadPool        *exif_pool;
+  guint               exif_n_pending;
+#endif
 };
 
+#ifdef HAVE_EXIF
+typedef struct
+{
+  guint64  mtime;
+  guint64  size;
+  guint64  file_time;
+  guint    pending : 1;
+} ThunarSbrExifEntry;
+
+typedef struct
+{
+  ThunarSbrDateRenamer *date_renamer;
+  gchar                *filename;
+  guint64               mtime;
+  guint64               size;
+  guint64               file_time;
+} ThunarSbrExifJob;
+#endif
+
 
 
 THUNARX_DEFINE_TYPE (ThunarSbrDateRenamer, thunar_sbr_date_renamer, THUNARX_TYPE_RENAMER);
@@ -184,6 +221,10 @@ thunar_sbr_date_renamer_init (ThunarSbrDateRenamer *date_renamer)
   GtkAdjustment  *adjustment;
   guint           n;
 
+#ifdef HAVE_EXIF
+  date_renamer->exif_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+#endif
+
   vbox = gtk_vbox_new (FALSE, 6);
   gtk_box_pack_start (GTK_BOX (date_renamer), vbox, TRUE, TRUE, 0);
   gtk_widget_show (vbox);
@@ -278,6 +319,13 @@ thunar_sbr_date_renamer_finalize (GObject *object)
   /* release the format */
   g_free (date_renamer->format);
 
+#ifdef HAVE_EXIF
+  /* jobs hold a reference on the renamer, so the pool is idle here */
+  if (date_renamer->exif_pool != NULL)
+    g_thread_pool_free (date_renamer->exif_pool, TRUE, FALSE);
+  g_hash_table_destroy (date_renamer->exif_cache);
+#endif
+
   (*G_OBJECT_CLASS (thunar_sbr_date_renamer_parent_class)->finalize) (object);
 }
 
@@ -424,22 +472,225 @@ thunar_sbr_get_time_from_string (const gchar *string)
   /* return the local time */
   return mktime (&tm);
 }
+
+
+
+static ExifData*
+thunar_sbr_exif_data_new_from_file (const gchar *filename)
+{
+  ExifData *exif_data = NULL;
+  guchar    header[4];
+  guchar   *segment;
+  FILE     *fp;
+  gsize     length;
+  guint     n;
+
+  fp = fopen (filename, "rb");
+  if (G_UNLIKELY (fp == NULL))
+    return NULL;
+
+  /* check for the jpeg start of image marker */
+  if (fread (header, 1, 2, fp) != 2 || header[0] != 0xff || header[1] != 0xd8)
+    {
+      /* not a jpeg file, let libexif figure out the format */
+      fclose (fp);
+      return exif_data_new_from_file (filename);
+    }
+
+  /* walk the segment headers until we find the APP1 segment with the
+   * exif data, so only that segment is read and not the whole image */
+  for (n = 0; n < 32 && exif_data == NULL; ++n)
+    {
+      /* read the marker and the segment length */
+      if (fread (header, 1, 4, fp) != 4 || header[0] != 0xff)
+        break;
+
+      /* the image data starts here, no exif data in this file */
+      if (header[1] == 0xda || header[1] == 0xd9)
+        break;
+
+      length = (header[2] << 8) | header[3];
+      if (G_UNLIKELY (length < 2))
+        break;
+      length -= 2;
+
+      if (header[1] == 0xe1 && length > 6)
+        {
+          /* read the segment, APP1 is also used for xmp data */
+          segment = g_malloc (length);
+          if (fread (segment, 1, length, fp) == length && memcmp (segment, "Exif\0\0", 6) == 0)
+            exif_data = exif_data_new_from_data (segment, length);
+          g_free (segment);
+        }
+      else if (fseek (fp, length, SEEK_CUR) != 0)
+        {
+          break;
+        }
+    }
+
+  fclose (fp);
+
+  return exif_data;
+}
+
+
+
+static guint64
+thunar_sbr_get_exif_time (const gchar *filename)
+{
+  ExifEntry *exif_entry;
+  ExifData  *exif_data;
+  guint64    file_time = 0;
+  gchar      exif_buffer[128];
+
+  /* try to load the exif data for the file */
+  exif_data = thunar_sbr_exif_data_new_from_file (filename);
+  if (G_LIKELY (exif_data != NULL))
+    {
+      /* lookup the entry for the tag, fallback on less common ones */
+      exif_entry = exif_data_get_entry (exif_data, EXIF_TAG_DATE_TIME);
+
+      if (exif_entry == NULL)
+        exif_entry = exif_data_get_entry (exif_data, EXIF_TAG_DATE_TIME_ORIGINAL);
+
+      if (exif_entry == NULL)
+        exif_entry = exif_data_get_entry (exif_data, EXIF_TAG_DATE_TIME_DIGITIZED);
+
+      if (G_LIKELY (exif_entry != NULL))
+        {
+          /* determine the value */
+          if (exif_entry_get_value (exif_entry, exif_buffer, sizeof (exif_buffer)) != NULL)
+            file_time = thunar_sbr_get_time_from_string (exif_buffer);
+        }
+
+      /* cleanup */
+      exif_data_free (exif_data);
+    }
+
+  return file_time;
+}
+
+
+
+static void
+thunar_sbr_exif_job_run (gpointer data,
+                         gpointer user_data)
+{
+  ThunarSbrExifJob *job = data;
+
+  /* runs in a worker thread, only touches the job */
+  job->file_time = thunar_sbr_get_exif_time (job->filename);
+
+  /* hand the result back to the main thread */
+  g_idle_add (thunar_sbr_exif_job_finished, job);
+}
+
+
+
+static gboolean
+thunar_sbr_exif_job_finished (gpointer data)
+{
+  ThunarSbrDateRenamer *date_renamer;
+  ThunarSbrExifEntry   *entry;
+  ThunarSbrExifJob     *job = data;
+
+  GDK_THREADS_ENTER ();
+
+  date_renamer = job->date_renamer;
+
+  /* store the result, unless the file changed in the meantime */
+  entry = g_hash_table_lookup (date_renamer->exif_cache, job->filename);
+  if (entry != NULL && entry->pending && entry->mtime == job->mtime && entry->size == job->size)
+    {
+      entry->file_time = job->file_time;
+      entry->pending = FALSE;
+    }
+
+  /* update the preview once all pending files are scanned */
+  if (--date_renamer->exif_n_pending == 0)
+    {
+      thunarx_renamer_set_busy (THUNARX_RENAMER (date_renamer), FALSE);
+      if (date_renamer->mode == THUNAR_SBR_DATE_MODE_TAKEN)
+        thunarx_renamer_changed (THUNARX_RENAMER (date_renamer));
+    }
+
+  g_object_unref (G_OBJECT (date_renamer));
+  g_free (job->filename);
+  g_slice_free (ThunarSbrExifJob, job);
+
+  GDK_THREADS_LEAVE ();
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_sbr_date_renamer_lookup_exif (ThunarSbrDateRenamer *date_renamer,
+                                     const gchar          *filename,
+                                     GFileInfo            *file_info,
+                                     guint64              *file_time_return)
+{
+  ThunarSbrExifEntry *entry;
+  ThunarSbrExifJob   *job;
+  guint64             mtime;
+  guint64             size;
+
+  mtime = g_file_info_get_attribute_uint64 (file_info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+  size = g_file_info_get_attribute_uint64 (file_info, G_FILE_ATTRIBUTE_STANDARD_SIZE);
+
+  /* check if we already know the date of this file */
+  entry = g_hash_table_lookup (date_renamer->exif_cache, filename);
+  if (entry != NULL && entry->mtime == mtime && entry->size == size)
+    {
+      *file_time_return = entry->file_time;
+      return;
+    }
+
+  /* (re)create the entry for the file */
+  if (entry == NULL)
+    {
+      entry = g_new0 (ThunarSbrExifEntry, 1);
+      g_hash_table_insert (date_renamer->exif_cache, g_strdup (filename), entry);
+    }
+  entry->mtime = mtime;
+  entry->size = size;
+  entry->file_time = 0;
+  entry->pending = TRUE;
+
+  /* allocate the pool on demand */
+  if (G_UNLIKELY (date_renamer->exif_pool == NULL))
+    {
+      date_renamer->exif_pool = g_thread_pool_new (thunar_sbr_exif_job_run, NULL,
+                                                   THUNAR_SBR_EXIF_MAX_THREADS, FALSE, NULL);
+    }
+
+  /* scan the file in the background */
+  job = g_slice_new0 (ThunarSbrExifJob);
+  job->date_renamer = g_object_ref (G_OBJECT (date_renamer));
+  job->filename = g_strdup (filename);
+  job->mtime = mtime;
+  job->size = size;
+  if (date_renamer->exif_n_pending++ == 0)
+    thunarx_renamer_set_busy (THUNARX_RENAMER (date_renamer), TRUE);
+  g_thread_pool_push (date_renamer->exif_pool, job, NULL);
+
+  *file_time_return = 0;
+}
 #endif
 
 
 
 static guint64
-thunar_sbr_get_time (ThunarxFileInfo   *file,
-                     ThunarSbrDateMode  mode)
+thunar_sbr_get_time (ThunarSbrDateRenamer *date_renamer,
+                     ThunarxFileInfo      *file,
+                     ThunarSbrDateMode     mode)
 {
 
   GFileInfo *file_info;
   guint64    file_time = 0;
 #ifdef HAVE_EXIF
   gchar     *uri, *filename;
-  ExifEntry *exif_entry;
-  ExifData  *exif_data;
-  gchar     exif_buffer[128];
 #endif
 
   switch (mode)
@@ -480,29 +731,11 @@ thunar_sbr_get_time (ThunarxFileInfo   *file,
           filename = g_filename_from_uri (uri, NULL, NULL);
           if (G_LIKELY (filename != NULL))
             {
-              /* try to load the exif data for the file */
-              exif_data = exif_data_new_from_file (filename);
-              if (G_LIKELY (exif_data != NULL))
-                {
-                  /* lookup the entry for the tag, fallback on less common ones */
-                  exif_entry = exif_data_get_entry (exif_data, EXIF_TAG_DATE_TIME);
-
-                  if (exif_entry == NULL)
-                    exif_entry = exif_data_get_entry (exif_data, EXIF_TAG_DATE_TIME_ORIGINAL);
-
-                  if (exif_entry == NULL)
-                    exif_entry = exif_data_get_entry (exif_data, EXIF_TAG_DATE_TIME_DIGITIZED);
-
-                  if (G_LIKELY (exif_entry != NULL))
-                    {
-                      /* determine the value */
-                      if (exif_entry_get_value (exif_entry, exif_buffer, sizeof (exif_buffer)) != NULL)
-                        file_time = thunar_sbr_get_time_from_string (exif_buffer);
-                    }
-
-                  /* cleanup */
-                  exif_data_free (exif_data);
-                }
+              /* lookup the cached date, files not scanned yet are queued and
+               * the renamer emits "changed" when their dates are known */
+              file_info = thunarx_file_info_get_file_info (file);
+              thunar_sbr_date_renamer_lookup_exif (date_renamer, filename, file_info, &file_time);
+              g_object_unref (file_info);
 
               /* cleanup */
               g_free (filename);
@@ -548,7 +781,7 @@ thunar_sbr_date_renamer_process (ThunarxRenamer  *renamer,
     return g_strdup (text);
 
   /* get the file time */
-  file_time = thunar_sbr_get_time (file, date_renamer->mode);
+  file_time = thunar_sbr_get_time (date_renamer, file, date_renamer->mode);
   if (file_time == 0)
     return g_strdup (text);
 
@@ -68,7 +68,30 @@ static gchar *thunar_sbr_replace_renamer_process      (ThunarxRenamer
 #ifdef HAVE_PCRE
 static gchar *thunar_sbr_replace_renamer_pcre_exec    (ThunarSbrReplaceRenamer      *replace_renamer,
                                                        const gchar                  *text);
+static void   thunar_sbr_replace_renamer_pcre_free    (ThunarSbrReplaceRenamer      *replace_renamer);
 static void   thunar_sbr_replace_renamer_pcre_update  (ThunarSbrReplaceRenamer      *replace_renamer);
+static void   thunar_sbr_replace_renamer_pcre_parse   (ThunarSbrReplaceRenamer      *replace_renamer);
+#endif
+
+
+
+#ifdef HAVE_PCRE
+/* Replacement token types */
+typedef enum
+{
+  TSRR_TOKEN_LITERAL,    /* text from the literals buffer */
+  TSRR_TOKEN_SUBPATTERN, /* \<num>, $<num>, \& and $& */
+  TSRR_TOKEN_LAST,       /* \+ and $+ */
+  TSRR_TOKEN_BEFORE,     /* \` and $` */
+  TSRR_TOKEN_AFTER,      /* \' and $' */
+} TsrrTokenType;
+
+typedef struct
+{
+  TsrrTokenType type;
+  gint          offset; /* literal offset or subpattern index */
+  gint          length; /* literal length */
+} TsrrToken;
 #endif
 
 
@@ -90,10 +113,17 @@ struct _ThunarSbrReplaceRenamer
   /* TRUE if PCRE is available and supports UTF-8 */
   gint           regexp_supported;
 
-  /* PCRE compiled pattern */
+  /* PCRE compiled pattern, its study data and the output vector */
 #ifdef HAVE_PCRE
   pcre          *pcre_pattern;
+  pcre_extra    *pcre_extra;
   gint           pcre_capture_count;
+  gint          *pcre_ovec;
+  gint           pcre_ovec_len;
+
+  /* the replacement, parsed into tokens */
+  GArray        *pcre_tokens;
+  GString       *pcre_literals;
 #endif
 };
 
@@ -191,6 +221,10 @@ thunar_sbr_replace_renamer_init (ThunarSbrReplaceRenamer *replace_renamer)
   /* check if PCRE supports UTF-8 */
   if (pcre_config (PCRE_CONFIG_UTF8, &replace_renamer->regexp_supported) != 0)
     replace_renamer->regexp_supported = FALSE;
+
+  /* allocate the replacement tokens */
+  replace_renamer->pcre_tokens = g_array_new (FALSE, FALSE, sizeof (TsrrToken));
+  replace_renamer->pcre_literals = g_string_new (NULL);
 #endif
 
   table = gtk_table_new (2, 3, FALSE);
@@ -265,8 +299,11 @@ thunar_sbr_replace_renamer_finalize (GObject *object)
 
   /* release the PCRE pattern (if any) */
 #ifdef HAVE_PCRE
-  if (G_UNLIKELY (replace_renamer->pcre_pattern != NULL))
-    pcre_free (replace_renamer->pcre_pattern);
+  thunar_sbr_replace_renamer_pcre_free (replace_renamer);
+
+  /* release the replacement tokens */
+  g_array_free (replace_renamer->pcre_tokens, TRUE);
+  g_string_free (replace_renamer->pcre_literals, TRUE);
 #endif
 
   /* release the strings */
@@ -444,45 +481,136 @@ static gchar*
 thunar_sbr_replace_renamer_pcre_exec (ThunarSbrReplaceRenamer *replace_renamer,
                                       const gchar             *subject)
 {
-  const gchar *r;
-  GString     *result;
-  gint         second;
-  gint         first;
-  gint         idx;
-  gint        *ovec;
-  gint         olen;
-  gint         rc;
-
-  /* guess an initial ovec size */
-  olen = (replace_renamer->pcre_capture_count + 10) * 3;
-  ovec = g_new0 (gint, olen);
-
-  /* try to match the subject (increasing ovec on-demand) */
-  for (rc = 0; rc <= 0; )
+  const TsrrToken *token;
+  GString         *result;
+  gint            *ovec = replace_renamer->pcre_ovec;
+  gint             length;
+  gint             second;
+  gint             first;
+  guint            n;
+  gint             rc;
+
+  /* try to match the subject, the ovec is large enough for all subpatterns */
+  length = strlen (subject);
+  rc = pcre_exec (replace_renamer->pcre_pattern, replace_renamer->pcre_extra, subject, length,
+                  0, PCRE_NOTEMPTY, ovec, replace_renamer->pcre_ovec_len);
+  if (G_UNLIKELY (rc < 0))
     {
-      /* try to exec, will return 0 if the ovec is too small */
-      rc = pcre_exec (replace_renamer->pcre_pattern, NULL, subject, strlen (subject), 0, PCRE_NOTEMPTY, ovec, olen);
-      if (G_UNLIKELY (rc < 0))
-        {
-          /* no match or error */
-          g_free (ovec);
-          return g_strdup (subject);
-        }
-      else if (rc == 0)
-        {
-          /* ovec too small, try to increase */
-          olen += 18;
-          ovec = g_realloc (ovec, olen * sizeof (gint));
-        }
+      /* no match or error */
+      return g_strdup (subject);
+    }
+  else if (G_UNLIKELY (rc == 0))
+    {
+      /* shouldn't happen, but just to be sure */
+      rc = replace_renamer->pcre_ovec_len / 3;
     }
 
   /* allocate a string for the result */
-  result = g_string_sized_new (32);
+  result = g_string_sized_new (length + replace_renamer->pcre_literals->len + 1);
 
   /* append the text before the match */
   g_string_append_len (result, subject, ovec[0]);
 
   /* apply the replacement */
+  for (n = 0; n < replace_renamer->pcre_tokens->len; ++n)
+    {
+      token = &g_array_index (replace_renamer->pcre_tokens, TsrrToken, n);
+      switch (token->type)
+        {
+        case TSRR_TOKEN_LITERAL:
+          g_string_append_len (result, replace_renamer->pcre_literals->str + token->offset, token->length);
+          continue;
+
+        case TSRR_TOKEN_SUBPATTERN:
+          /* \<num> and $<num> is replaced with the <num>th subpattern */
+          if (G_UNLIKELY (token->offset >= rc))
+            continue;
+          first = ovec[2 * token->offset];
+          second = ovec[2 * token->offset + 1];
+          break;
+
+        case TSRR_TOKEN_LAST:
+          /* \+ and $+ is replaced with the last subpattern */
+          if (G_UNLIKELY (rc <= 1))
+            continue;
+          first = ovec[(rc - 1) * 2];
+          second = ovec[(rc - 1) * 2 + 1];
+          break;
+
+        case TSRR_TOKEN_BEFORE:
+          /* \` and $` is replaced with the text before the whole match */
+          first = 0;
+          second = ovec[0];
+          break;
+
+        case TSRR_TOKEN_AFTER:
+          /* \' and $' is replaced with the text after the whole match */
+          first = ovec[1];
+          second = length - 1;
+          break;
+
+        default:
+          g_assert_not_reached ();
+          continue;
+        }
+
+      /* substitute the string (unset subpatterns are -1) */
+      if (G_LIKELY (first >= 0 && second > first))
+        g_string_append_len (result, subject + first, second - first);
+    }
+
+  /* append the text after the match */
+  g_string_append (result, subject + ovec[1]);
+
+  /* return the new name */
+  return g_string_free (result, FALSE);
+}
+
+
+
+static void
+thunar_sbr_replace_renamer_pcre_free (ThunarSbrReplaceRenamer *replace_renamer)
+{
+  /* release the study data */
+  if (G_LIKELY (replace_renamer->pcre_extra != NULL))
+    {
+#ifdef PCRE_STUDY_JIT_COMPILE
+      pcre_free_study (replace_renamer->pcre_extra);
+#else
+      pcre_free (replace_renamer->pcre_extra);
+#endif
+      replace_renamer->pcre_extra = NULL;
+    }
+
+  /* release the pattern */
+  if (G_LIKELY (replace_renamer->pcre_pattern != NULL))
+    {
+      pcre_free (replace_renamer->pcre_pattern);
+      replace_renamer->pcre_pattern = NULL;
+    }
+
+  /* release the output vector */
+  g_free (replace_renamer->pcre_ovec);
+  replace_renamer->pcre_ovec = NULL;
+  replace_renamer->pcre_ovec_len = 0;
+}
+
+
+
+static void
+thunar_sbr_replace_renamer_pcre_parse (ThunarSbrReplaceRenamer *replace_renamer)
+{
+  TsrrToken    token;
+  const gchar *r;
+  gint         length;
+  guint        n;
+
+  g_array_set_size (replace_renamer->pcre_tokens, 0);
+  g_string_truncate (replace_renamer->pcre_literals, 0);
+
+  if (G_UNLIKELY (replace_renamer->replacement == NULL))
+    return;
+
   for (r = replace_renamer->replacement; *r != '\0'; r = g_utf8_next_char (r))
     {
       if (G_UNLIKELY ((r[0] == '\\' || r[0] == '$') && r[1] != '\0'))
@@ -490,75 +618,58 @@ thunar_sbr_replace_renamer_pcre_exec (ThunarSbrReplaceRenamer *replace_renamer,
           /* skip the first char ($ or \) */
           r += 1;
 
-          /* default to no subst */
-          first = 0;
-          second = 0;
-
           /* check the char after the \ or $ */
-          if (r[0] == '+' && rc > 1)
-            {
-              /* \+ and $+ is replaced with the last subpattern */
-              first = ovec[(rc - 1) * 2];
-              second = ovec[(rc - 1) * 2 + 1];
-            }
+          if (r[0] == '+')
+            token.type = TSRR_TOKEN_LAST;
           else if (r[0] == '&')
             {
-              /* \& and $& is replaced with the first subpattern (the whole match) */
-              first = ovec[0];
-              second = ovec[1];
+              /* \& and $& is the first subpattern (the whole match) */
+              token.type = TSRR_TOKEN_SUBPATTERN;
+              token.offset = 0;
             }
           else if (r[0] == '`')
-            {
-              /* \` and $` is replaced with the text before the whole match */
-              first = 0;
-              second = ovec[0];
-            }
+            token.type = TSRR_TOKEN_BEFORE;
           else if (r[0] == '\'')
-            {
-              /* \' and $' is replaced with the text after the whole match */
-              first = ovec[1];
-              second = strlen (subject) - 1;
-            }
+            token.type = TSRR_TOKEN_AFTER;
           else if (g_ascii_isdigit (r[0]))
             {
-              /* \<num> and $<num> is replaced with the <num>th subpattern */
-              idx = (r[0] - '0');
-              if (G_LIKELY (idx >= 0 && idx < rc))
-                {
-                  first = ovec[2 * idx];
-                  second = ovec[2 * idx + 1];
-                }
+              token.type = TSRR_TOKEN_SUBPATTERN;
+              token.offset = (r[0] - '0');
             }
-          else if (r[-1] == r[0])
+          else if (r[-1] != r[0])
             {
-              /* just add the $ or \ char */
-              g_string_append_c (result, r[0]);
+              /* just ignore the $ or \ char */
               continue;
             }
           else
             {
-              /* just ignore the $ or \ char */
+              /* $$ and \\ add the $ or \ char, handled below */
+              token.type = TSRR_TOKEN_LITERAL;
+            }
+
+          if (token.type != TSRR_TOKEN_LITERAL)
+            {
+              g_array_append_val (replace_renamer->pcre_tokens, token);
               continue;
             }
+        }
 
-          /* substitute the string */
-          g_string_append_len (result, subject + first, second - first);
+      /* append the unichar to the previous literal token (if any) */
+      length = g_utf8_next_char (r) - r;
+      n = replace_renamer->pcre_tokens->len;
+      if (n > 0 && g_array_index (replace_renamer->pcre_tokens, TsrrToken, n - 1).type == TSRR_TOKEN_LITERAL)
+        {
+          g_array_index (replace_renamer->pcre_tokens, TsrrToken, n - 1).length += length;
         }
       else
         {
-          /* just append the unichar */
-          g_string_append_unichar (result, g_utf8_get_char (r));
+          token.type = TSRR_TOKEN_LITERAL;
+          token.offset = replace_renamer->pcre_literals->len;
+          token.length = length;
+          g_array_append_val (replace_renamer->pcre_tokens, token);
         }
+      g_string_append_len (replace_renamer->pcre_literals, r, length);
     }
-
-  /* append the text after the match */
-  g_string_append (result, subject + ovec[1]);
-
-  /* release the output vector */
-  g_free (ovec);
-
-  /* return the new name */
-  return g_string_free (result, FALSE);
 }
 
 
@@ -567,6 +678,7 @@ static void
 thunar_sbr_replace_renamer_pcre_update (ThunarSbrReplaceRenamer *replace_renamer)
 {
   const gchar *error_message = NULL;
+  const gchar *study_error = NULL;
   GdkColor     back;
   GdkColor     text;
   gchar       *tooltip;
@@ -574,13 +686,12 @@ thunar_sbr_replace_renamer_pcre_update (ThunarSbrReplaceRenamer *replace_renamer
   glong        offset;
   gint         error_offset = -1;
 
+  /* release the previous pattern (if any) */
+  thunar_sbr_replace_renamer_pcre_free (replace_renamer);
+
   /* pre-compile the pattern if regexp is enabled */
   if (G_UNLIKELY (replace_renamer->regexp))
     {
-      /* release the previous pattern (if any) */
-      if (G_LIKELY (replace_renamer->pcre_pattern != NULL))
-        pcre_free (replace_renamer->pcre_pattern);
-
       /* try to compile the new pattern */
       replace_renamer->pcre_pattern = pcre_compile (replace_renamer->pattern, (replace_renamer->case_sensitive ? 0 : PCRE_CASELESS) | PCRE_UTF8,
                                                     &error_message, &error_offset, 0);
@@ -594,6 +705,23 @@ thunar_sbr_replace_renamer_pcre_update (ThunarSbrReplaceRenamer *replace_renamer
               replace_renamer->pcre_pattern = NULL;
             }
         }
+
+      if (G_LIKELY (replace_renamer->pcre_pattern != NULL))
+        {
+          /* study (and JIT compile if supported) the pattern, as it is
+           * matched against every file name. Failing to do so is not
+           * an error, the pattern just runs slower then.
+           */
+#ifdef PCRE_STUDY_JIT_COMPILE
+          replace_renamer->pcre_extra = pcre_study (replace_renamer->pcre_pattern, PCRE_STUDY_JIT_COMPILE, &study_error);
+#else
+          replace_renamer->pcre_extra = pcre_study (replace_renamer->pcre_pattern, 0, &study_error);
+#endif
+
+          /* allocate an output vector that fits all subpatterns */
+          replace_renamer->pcre_ovec_len = (replace_renamer->pcre_capture_count + 1) * 3;
+          replace_renamer->pcre_ovec = g_new0 (gint, replace_renamer->pcre_ovec_len);
+        }
     }
 
   /* check if there was an error compiling the pattern */
@@ -866,6 +994,11 @@ thunar_sbr_replace_renamer_set_replacement (ThunarSbrReplaceRenamer *replace_ren
       g_free (replace_renamer->replacement);
       replace_renamer->replacement = g_strdup (replacement);
 
+#ifdef HAVE_PCRE
+      /* pre-parse the replacement */
+      thunar_sbr_replace_renamer_pcre_parse (replace_renamer);
+#endif
+
       /* update the renamer */
       thunarx_renamer_changed (THUNARX_RENAMER (replace_renamer));
 
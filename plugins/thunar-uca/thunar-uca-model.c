@@ -62,6 +62,9 @@
 #define _PATH_BSHELL "/bin/sh"
 #endif
 
+/* number of flags in ThunarUcaTypes */
+#define THUNAR_UCA_N_TYPES 6
+
 
 
 typedef struct _ThunarUcaModelItem ThunarUcaModelItem;
@@ -126,6 +129,8 @@ static gboolean           thunar_uca_model_load_from_file   (ThunarUcaModel
                                                              GError              **error);
 static void               thunar_uca_model_item_reset       (ThunarUcaModelItem   *item);
 static void               thunar_uca_model_item_free        (gpointer              data);
+static void               thunar_uca_model_invalidate_buckets (ThunarUcaModel     *uca_model);
+static void               thunar_uca_model_build_buckets    (ThunarUcaModel       *uca_model);
 static void               start_element_handler             (GMarkupParseContext  *context,
                                                              const gchar          *element_name,
                                                              const gchar         **attribute_names,
@@ -155,6 +160,14 @@ struct _ThunarUcaModel
 
   GList          *items;
   gint            stamp;
+
+  /* items per ThunarUcaTypes flag, in model order, so
+   * thunar_uca_model_match() only needs to look at the
+   * items that apply to the selected files. the buckets
+   * are rebuilt lazily after the items changed.
+   */
+  GPtrArray      *buckets[THUNAR_UCA_N_TYPES];
+  gboolean        buckets_valid;
 };
 
 struct _ThunarUcaModelItem
@@ -171,6 +184,9 @@ struct _ThunarUcaModelItem
 
   /* derived attributes */
   guint          multiple_selection : 1;
+  guint          match_all : 1;
+  GPatternSpec **pattern_specs;
+  gint           position;
 };
 
 typedef XFCE_GENERIC_STACK(ParserState) ParserStack;
@@ -281,6 +297,9 @@ thunar_uca_model_finalize (GObject *object)
   /* release all items */
   g_list_free_full (uca_model->items, thunar_uca_model_item_free);
 
+  /* release the type buckets */
+  thunar_uca_model_invalidate_buckets (uca_model);
+
   (*G_OBJECT_CLASS (thunar_uca_model_parent_class)->finalize) (object);
 }
 
@@ -608,6 +627,16 @@ thunar_uca_model_load_from_file (ThunarUcaModel *uca_model,
 static void
 thunar_uca_model_item_reset (ThunarUcaModelItem *item)
 {
+  guint n;
+
+  /* release the compiled patterns */
+  if (item->pattern_specs != NULL)
+    {
+      for (n = 0; item->pattern_specs[n] != NULL; ++n)
+        g_pattern_spec_free (item->pattern_specs[n]);
+      g_free (item->pattern_specs);
+    }
+
   /* release the previous values... */
   g_strfreev (item->patterns);
   g_free (item->description);
@@ -635,6 +664,54 @@ thunar_uca_model_item_free (gpointer data)
 
 
 
+static void
+thunar_uca_model_invalidate_buckets (ThunarUcaModel *uca_model)
+{
+  guint n;
+
+  for (n = 0; n < THUNAR_UCA_N_TYPES; ++n)
+    {
+      if (uca_model->buckets[n] != NULL)
+        {
+          g_ptr_array_free (uca_model->buckets[n], TRUE);
+          uca_model->buckets[n] = NULL;
+        }
+    }
+
+  uca_model->buckets_valid = FALSE;
+}
+
+
+
+static void
+thunar_uca_model_build_buckets (ThunarUcaModel *uca_model)
+{
+  ThunarUcaModelItem *item;
+  GList              *lp;
+  guint               n;
+  gint                i;
+
+  thunar_uca_model_invalidate_buckets (uca_model);
+
+  for (n = 0; n < THUNAR_UCA_N_TYPES; ++n)
+    uca_model->buckets[n] = g_ptr_array_new ();
+
+  /* sort the items into the buckets of their types */
+  for (i = 0, lp = uca_model->items; lp != NULL; ++i, lp = lp->next)
+    {
+      item = lp->data;
+      item->position = i;
+
+      for (n = 0; n < THUNAR_UCA_N_TYPES; ++n)
+        if ((item->types & (1 << n)) != 0)
+          g_ptr_array_add (uca_model->buckets[n], item);
+    }
+
+  uca_model->buckets_valid = TRUE;
+}
+
+
+
 static void
 start_element_handler (GMarkupParseContext *context,
                        const gchar         *element_name,
@@ -1075,18 +1152,26 @@ thunar_uca_model_match (ThunarUcaModel *uca_model,
   typedef struct
   {
     gchar          *name;
-    ThunarUcaTypes  types;
+    gchar          *name_reversed;
+    guint           name_length;
   } ThunarUcaFile;
 
   ThunarUcaModelItem *item;
+  ThunarUcaTypes      types;
+  ThunarUcaTypes      file_types = 0;
   ThunarUcaFile      *files;
+  GHashTable         *names;
+  GPtrArray          *bucket = NULL;
   GFile              *location;
   gchar              *mime_type;
+  gchar              *name;
   gboolean            matches;
   GList              *paths = NULL;
   GList              *lp;
   gint                n_files;
-  gint                i, m, n;
+  gint                n_names;
+  guint               i, m;
+  gint                n;
 
   g_return_val_if_fail (THUNAR_UCA_IS_MODEL (uca_model), NULL);
   g_return_val_if_fail (file_infos != NULL, NULL);
@@ -1095,10 +1180,12 @@ thunar_uca_model_match (ThunarUcaModel *uca_model,
   if (G_UNLIKELY (uca_model->items == NULL))
     return NULL;
 
-  /* determine the ThunarUcaFile's for the given file_infos */
+  /* determine the types and the distinct names of the given file_infos,
+   * since identical names in a selection always give the same result */
   n_files = g_list_length (file_infos);
   files = g_new (ThunarUcaFile, n_files);
-  for (lp = file_infos, n = 0; lp != NULL; lp = lp->next, ++n)
+  names = g_hash_table_new (g_str_hash, g_str_equal);
+  for (lp = file_infos, n_names = 0; lp != NULL; lp = lp->next)
     {
       location = thunarx_file_info_get_location (lp->data);
 
@@ -1106,6 +1193,12 @@ thunar_uca_model_match (ThunarUcaModel *uca_model,
         {
           /* cannot handle non-local files */
           g_object_unref (location);
+          for (n = 0; n < n_names; ++n)
+            {
+              g_free (files[n].name);
+              g_free (files[n].name_reversed);
+            }
+          g_hash_table_destroy (names);
           g_free (files);
           return NULL;
         }
@@ -1113,34 +1206,53 @@ thunar_uca_model_match (ThunarUcaModel *uca_model,
       g_object_unref (location);
 
       mime_type = thunarx_file_info_get_mime_type (lp->data);
-
-      files[n].name = thunarx_file_info_get_name (lp->data);
-      files[n].types = types_from_mime_type (mime_type);
-
-      if (G_UNLIKELY (files[n].types == 0))
-        files[n].types = THUNAR_UCA_TYPE_OTHER_FILES;
-
+      types = types_from_mime_type (mime_type);
+      file_types |= (types != 0) ? types : THUNAR_UCA_TYPE_OTHER_FILES;
       g_free (mime_type);
+
+      name = thunarx_file_info_get_name (lp->data);
+      if (g_hash_table_lookup (names, name) == NULL)
+        {
+          g_hash_table_insert (names, name, name);
+          files[n_names].name = name;
+          files[n_names].name_length = strlen (name);
+          files[n_names].name_reversed = g_utf8_strreverse (name, files[n_names].name_length);
+          n_names++;
+        }
+      else
+        {
+          g_free (name);
+        }
     }
+  g_hash_table_destroy (names);
+
+  /* only look at the items in the smallest bucket of the selected types */
+  if (!uca_model->buckets_valid)
+    thunar_uca_model_build_buckets (uca_model);
+  for (m = 0; m < THUNAR_UCA_N_TYPES; ++m)
+    if ((file_types & (1 << m)) != 0
+        && (bucket == NULL || uca_model->buckets[m]->len < bucket->len))
+      bucket = uca_model->buckets[m];
 
   /* lookup the matching items */
-  for (i = 0, lp = uca_model->items; lp != NULL; ++i, lp = lp->next)
+  for (i = 0; bucket != NULL && i < bucket->len; ++i)
     {
       /* check if we can just ignore this item */
-      item = (ThunarUcaModelItem *) lp->data;
+      item = g_ptr_array_index (bucket, i);
       if (!item->multiple_selection && n_files > 1)
         continue;
 
+      /* verify that we support all types of files */
+      if ((file_types & ~item->types) != 0)
+        continue;
+
       /* match the specified files */
-      for (n = 0; n < n_files; ++n)
+      for (n = 0; n < n_names && !item->match_all; ++n)
         {
-          /* verify that we support this type of file */
-          if ((files[n].types & item->types) == 0)
-            break;
-
           /* atleast on pattern must match the file name */
-          for (m = 0, matches = FALSE; item->patterns[m] != NULL && !matches; ++m)
-            matches = g_pattern_match_simple (item->patterns[m], files[n].name);
+          for (m = 0, matches = FALSE; item->pattern_specs[m] != NULL && !matches; ++m)
+            matches = g_pattern_match (item->pattern_specs[m], files[n].name_length,
+                                       files[n].name, files[n].name_reversed);
 
           /* no need to continue if none of the patterns match */
           if (!matches)
@@ -1148,16 +1260,19 @@ thunar_uca_model_match (ThunarUcaModel *uca_model,
         }
 
       /* add the path if all files match one of the patterns */
-      if (G_UNLIKELY (n == n_files))
-        paths = g_list_append (paths, gtk_tree_path_new_from_indices (i, -1));
+      if (G_UNLIKELY (item->match_all || n == n_names))
+        paths = g_list_prepend (paths, gtk_tree_path_new_from_indices (item->position, -1));
     }
 
   /* cleanup */
-  for (n = 0; n < n_files; ++n)
-    g_free (files[n].name);
+  for (n = 0; n < n_names; ++n)
+    {
+      g_free (files[n].name);
+      g_free (files[n].name_reversed);
+    }
   g_free (files);
 
-  return paths;
+  return g_list_reverse (paths);
 }
 
 
@@ -1183,6 +1298,7 @@ thunar_uca_model_append (ThunarUcaModel *uca_model,
   /* append the new item */
   item = g_new0 (ThunarUcaModelItem, 1);
   uca_model->items = g_list_append (uca_model->items, item);
+  thunar_uca_model_invalidate_buckets (uca_model);
 
   /* determine the tree iter of the new item */
   iter->stamp = uca_model->stamp;
@@ -1236,6 +1352,7 @@ thunar_uca_model_exchange (ThunarUcaModel *uca_model,
   item = list_a->data;
   list_a->data = list_b->data;
   list_b->data = item;
+  thunar_uca_model_invalidate_buckets (uca_model);
 
   /* notify listeners about the new order */
   path = gtk_tree_path_new ();
@@ -1270,6 +1387,7 @@ thunar_uca_model_remove (ThunarUcaModel *uca_model,
   item = ((GList *) iter->user_data)->data;
   uca_model->items = g_list_delete_link (uca_model->items, iter->user_data);
   thunar_uca_model_item_free (item);
+  thunar_uca_model_invalidate_buckets (uca_model);
 
   /* notify listeners */
   gtk_tree_model_row_deleted (GTK_TREE_MODEL (uca_model), path);
@@ -1349,6 +1467,19 @@ thunar_uca_model_update (ThunarUcaModel *uca_model,
     }
   item->patterns[n] = NULL;
 
+  /* compile the patterns once, instead of for every match */
+  item->pattern_specs = g_new (GPatternSpec *, n + 1);
+  for (m = 0; m < n; ++m)
+    {
+      item->pattern_specs[m] = g_pattern_spec_new (item->patterns[m]);
+      if (strcmp (item->patterns[m], "*") == 0)
+        item->match_all = TRUE;
+    }
+  item->pattern_specs[n] = NULL;
+
+  /* the item may have moved to other type buckets */
+  thunar_uca_model_invalidate_buckets (uca_model);
+
   /* check if this item will work for multiple files */
   item->multiple_selection = (command != NULL && (strstr (command, "%F") != NULL
                                                || strstr (command, "%D") != NULL
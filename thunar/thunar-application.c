@@ -53,6 +53,7 @@
 #include <thunar/thunar-gobject-extensions.h>
 #include <thunar/thunar-io-jobs.h>
 #include <thunar/thunar-preferences.h>
+#include <thunar/thunar-search-index.h>
 #include <thunar/thunar-private.h>
 #include <thunar/thunar-progress-dialog.h>
 #include <thunar/thunar-renamer-dialog.h>
@@ -160,6 +161,7 @@ static gboolean       thunar_application_show_dialogs           (gpointer
 static void           thunar_application_show_dialogs_destroy   (gpointer                user_data);
 static GtkWidget     *thunar_application_get_progress_dialog    (ThunarApplication      *application);
 static void           thunar_application_process_files          (ThunarApplication      *application);
+static void           thunar_application_search_index_changed   (ThunarApplication      *application);
 
 
 
@@ -180,6 +182,8 @@ struct _ThunarApplication
   ThunarThumbnailCache  *thumbnail_cache;
   ThunarThumbnailer     *thumbnailer;
 
+  ThunarSearchIndex     *search_index;
+
   ThunarDBusService     *dbus_service;
 
   gboolean               daemon;
@@ -314,6 +318,11 @@ thunar_application_startup (GApplication *gapp)
   /* connect to the session manager */
   application->session_client = thunar_session_client_new (opt_sm_client_id);
 
+  /* start the file name index if enabled */
+  g_signal_connect_swapped (G_OBJECT (application->preferences), "notify::misc-search-index",
+                            G_CALLBACK (thunar_application_search_index_changed), application);
+  thunar_application_search_index_changed (application);
+
   G_APPLICATION_CLASS (thunar_application_parent_class)->startup (gapp);
 }
 
@@ -366,6 +375,16 @@ thunar_application_shutdown (GApplication *gapp)
   if (application->thumbnail_cache != NULL)
     g_object_unref (G_OBJECT (application->thumbnail_cache));
 
+  /* stop the file name index */
+  g_signal_handlers_disconnect_by_func (G_OBJECT (application->preferences),
+                                        thunar_application_search_index_changed,
+                                        application);
+  if (application->search_index != NULL)
+    {
+      thunar_search_index_set_default (NULL);
+      g_object_unref (G_OBJECT (application->search_index));
+    }
+
   /* disconnect from the preferences */
   g_object_unref (G_OBJECT (application->preferences));
 
@@ -1404,6 +1423,32 @@ thunar_application_process_files (ThunarApplication *application)
 
 
 
+static void
+thunar_application_search_index_changed (ThunarApplication *application)
+{
+  gboolean misc_search_index;
+
+  _thunar_return_if_fail (THUNAR_IS_APPLICATION (application));
+
+  g_object_get (G_OBJECT (application->preferences), "misc-search-index", &misc_search_index, NULL);
+
+  /* start or stop the background indexer */
+  if (misc_search_index && application->search_index == NULL)
+    {
+      application->search_index = thunar_search_index_new ();
+      thunar_search_index_set_default (application->search_index);
+    }
+  else if (!misc_search_index && application->search_index != NULL)
+    {
+      /* the jobs can't take new references once it's not the default */
+      thunar_search_index_set_default (NULL);
+      g_object_unref (G_OBJECT (application->search_index));
+      application->search_index = NULL;
+    }
+}
+
+
+
 /**
  * thunar_application_process_filenames:
  * @application       : a #ThunarApplication.
@@ -59,16 +59,20 @@ typedef enum
   THUNAR_DBUS_TRANSFER_MODE_LINK_INTO,
 } ThunarDBusTransferMode;
 
+typedef struct _ThunarDBusRequest ThunarDBusRequest;
+
+/* performs a method call once its files are loaded */
+typedef void (*ThunarDBusRequestFunc)     (ThunarDBusRequest     *request,
+                                           GError               **error);
+
+/* the generated functions to complete a method call without results */
+typedef void (*ThunarDBusRequestComplete) (ThunarDBusFileManager *object,
+                                           GDBusMethodInvocation *invocation);
+
 
 static void     thunar_dbus_service_finalize                    (GObject                *object);
 static gboolean thunar_dbus_service_connect_trash_bin           (ThunarDBusService      *dbus_service,
                                                                  GError                **error);
-static gboolean thunar_dbus_service_parse_uri_and_display       (ThunarDBusService      *dbus_service,
-                                                                 const gchar            *uri,
-                                                                 const gchar            *display,
-                                                                 ThunarFile            **file_return,
-                                                                 GdkScreen             **screen_return,
-                                                                 GError                **error);
 static gboolean thunar_dbus_service_transfer_files              (ThunarDBusTransferMode  transfer_mode,
                                                                  const gchar            *working_directory,
                                                                  const gchar * const    *source_filenames,
@@ -222,6 +226,71 @@ static gboolean thunar_dbus_service_terminate                   (ThunarDBusThuna
 
 
 
+static ThunarDBusRequest *thunar_dbus_service_request_new                          (ThunarDBusFileManager     *object,
+                                                                                    GDBusMethodInvocation     *invocation,
+                                                                                    const gchar               *display,
+                                                                                    const gchar               *startup_id,
+                                                                                    ThunarDBusRequestFunc      func,
+                                                                                    ThunarDBusRequestComplete  complete);
+static void               thunar_dbus_service_request_add_uri                      (ThunarDBusRequest         *request,
+                                                                                    const gchar               *uri);
+static void               thunar_dbus_service_request_resolve                      (ThunarDBusRequest         *request);
+static void               thunar_dbus_service_request_file_ready                   (GFile                     *location,
+                                                                                    ThunarFile                *file,
+                                                                                    GError                    *error,
+                                                                                    gpointer                   user_data);
+static void               thunar_dbus_service_request_finish                       (ThunarDBusRequest         *request);
+static void               thunar_dbus_service_display_chooser_dialog_ready         (ThunarDBusRequest         *request,
+                                                                                    GError                   **error);
+static void               thunar_dbus_service_display_folder_ready                 (ThunarDBusRequest         *request,
+                                                                                    GError                   **error);
+static void               thunar_dbus_service_display_folder_and_select_ready      (ThunarDBusRequest         *request,
+                                                                                    GError                   **error);
+static void               thunar_dbus_service_display_folder_and_select_file_ready (GFile                     *location,
+                                                                                    ThunarFile                *file,
+                                                                                    GError                    *error,
+                                                                                    gpointer                   user_data);
+static void               thunar_dbus_service_display_file_properties_ready        (ThunarDBusRequest         *request,
+                                                                                    GError                   **error);
+static void               thunar_dbus_service_launch_ready                         (ThunarDBusRequest         *request,
+                                                                                    GError                   **error);
+static void               thunar_dbus_service_execute_ready                        (ThunarDBusRequest         *request,
+                                                                                    GError                   **error);
+static void               thunar_dbus_service_rename_file_ready                    (ThunarDBusRequest         *request,
+                                                                                    GError                   **error);
+static void               thunar_dbus_service_create_file_ready                    (ThunarDBusRequest         *request,
+                                                                                    GError                   **error);
+static void               thunar_dbus_service_create_file_from_template_ready      (ThunarDBusRequest         *request,
+                                                                                    GError                   **error);
+static void               thunar_dbus_service_unlink_files_ready                   (ThunarDBusRequest         *request,
+                                                                                    GError                   **error);
+
+
+
+struct _ThunarDBusRequest
+{
+  ThunarDBusFileManager     *object;
+  GDBusMethodInvocation     *invocation;
+  ThunarDBusRequestFunc      func;
+  ThunarDBusRequestComplete  complete;
+
+  GdkScreen                 *screen;
+  gchar                     *startup_id;
+  GError                    *error;
+
+  /* the locations still to load and the loaded files */
+  GList                     *locations;
+  GList                     *files;
+
+  /* method specific arguments */
+  gchar                     *argument;
+  gchar                     *working_directory;
+  GList                     *argument_files;
+  gboolean                   open;
+};
+
+
+
 struct _ThunarDBusServiceClass
 {
   GObjectClass __parent__;
@@ -367,28 +436,107 @@ thunar_dbus_service_connect_trash_bin (ThunarDBusService *dbus_service,
 
 
 
-static gboolean
-thunar_dbus_service_parse_uri_and_display (ThunarDBusService *dbus_service,
-                                           const gchar       *uri,
-                                           const gchar       *display,
-                                           ThunarFile       **file_return,
-                                           GdkScreen        **screen_return,
-                                           GError           **error)
+static ThunarDBusRequest *
+thunar_dbus_service_request_new (ThunarDBusFileManager     *object,
+                                 GDBusMethodInvocation     *invocation,
+                                 const gchar               *display,
+                                 const gchar               *startup_id,
+                                 ThunarDBusRequestFunc      func,
+                                 ThunarDBusRequestComplete  complete)
+{
+  ThunarDBusRequest *request;
+
+  request = g_slice_new0 (ThunarDBusRequest);
+  request->object = g_object_ref (object);
+  request->invocation = invocation;
+  request->func = func;
+  request->complete = complete;
+  request->startup_id = g_strdup (startup_id);
+
+  /* try to open the display, the error is reported when resolving */
+  request->screen = thunar_gdk_screen_open (display, &request->error);
+
+  return request;
+}
+
+
+
+static void
+thunar_dbus_service_request_add_uri (ThunarDBusRequest *request,
+                                     const gchar       *uri)
+{
+  request->locations = g_list_append (request->locations, g_file_new_for_commandline_arg (uri));
+}
+
+
+
+static void
+thunar_dbus_service_request_resolve (ThunarDBusRequest *request)
 {
-  /* try to open the display */
-  *screen_return = thunar_gdk_screen_open (display, error);
-  if (G_UNLIKELY (*screen_return == NULL))
-    return FALSE;
-
-  /* try to determine the file for the URI */
-  *file_return = thunar_file_get_for_uri (uri, error);
-  if (G_UNLIKELY (*file_return == NULL))
+  GFile *location;
+
+  if (G_UNLIKELY (request->error != NULL))
     {
-      g_object_unref (G_OBJECT (*screen_return));
-      return FALSE;
+      thunar_dbus_service_request_finish (request);
+      return;
     }
 
-  return TRUE;
+  if (request->locations != NULL)
+    {
+      /* load the next file, without blocking the main loop on slow mounts */
+      location = request->locations->data;
+      request->locations = g_list_delete_link (request->locations, request->locations);
+      thunar_file_get_async (location, NULL, thunar_dbus_service_request_file_ready, request);
+      g_object_unref (location);
+    }
+  else
+    {
+      /* all files are loaded, perform the method call */
+      (*request->func) (request, &request->error);
+      thunar_dbus_service_request_finish (request);
+    }
+}
+
+
+
+static void
+thunar_dbus_service_request_file_ready (GFile      *location,
+                                        ThunarFile *file,
+                                        GError     *error,
+                                        gpointer    user_data)
+{
+  ThunarDBusRequest *request = user_data;
+
+  if (G_UNLIKELY (error != NULL))
+    request->error = g_error_copy (error);
+  else
+    request->files = g_list_append (request->files, g_object_ref (file));
+
+  thunar_dbus_service_request_resolve (request);
+}
+
+
+
+static void
+thunar_dbus_service_request_finish (ThunarDBusRequest *request)
+{
+  /* return the result of the method call */
+  if (request->error != NULL)
+    g_dbus_method_invocation_take_error (request->invocation, request->error);
+  else
+    (*request->complete) (request->object, request->invocation);
+
+  /* cleanup */
+  g_list_free_full (request->locations, g_object_unref);
+  thunar_g_file_list_free (request->files);
+  g_list_free_full (request->argument_files, g_object_unref);
+  if (request->screen != NULL)
+    g_object_unref (request->screen);
+  g_object_unref (request->object);
+  g_free (request->startup_id);
+  g_free (request->argument);
+  g_free (request->working_directory);
+  g_slice_free (ThunarDBusRequest, request);
 }
 
 
@@ -416,29 +564,28 @@ thunar_dbus_service_display_chooser_dialog (ThunarDBusFileManager  *object,
                                             const gchar            *startup_id,
                                             ThunarDBusService      *dbus_service)
 {
-  ThunarFile *file;
-  GdkScreen  *screen;
-  GError     *error = NULL;
+  ThunarDBusRequest *request;
 
   /* parse uri and display parameters */
-  if (!thunar_dbus_service_parse_uri_and_display (dbus_service, uri, display, &file, &screen, &error))
-    goto out;
+  request = thunar_dbus_service_request_new (object, invocation, display, startup_id,
+                                             thunar_dbus_service_display_chooser_dialog_ready,
+                                             thunar_dbus_file_manager_complete_display_chooser_dialog);
+  request->open = open;
+  thunar_dbus_service_request_add_uri (request, uri);
+  thunar_dbus_service_request_resolve (request);
 
-  /* popup the chooser dialog */
-  /* TODO use the startup id! */
-  thunar_show_chooser_dialog (screen, file, open);
+  return TRUE;
+}
 
-  /* cleanup */
-  g_object_unref (G_OBJECT (screen));
-  g_object_unref (G_OBJECT (file));
 
-out:
-  if (error)
-    g_dbus_method_invocation_take_error (invocation, error);
-  else
-    thunar_dbus_file_manager_complete_display_chooser_dialog (object, invocation);
 
-  return TRUE;
+static void
+thunar_dbus_service_display_chooser_dialog_ready (ThunarDBusRequest  *request,
+                                                  GError            **error)
+{
+  /* popup the chooser dialog */
+  /* TODO use the startup id! */
+  thunar_show_chooser_dialog (request->screen, request->files->data, request->open);
 }
 
 
@@ -451,31 +598,30 @@ thunar_dbus_service_display_folder (ThunarDBusFileManager  *object,
                                     const gchar            *startup_id,
                                     ThunarDBusService      *dbus_service)
 {
-  ThunarApplication *application;
-  ThunarFile        *file;
-  GdkScreen         *screen;
-  GError            *error = NULL;
+  ThunarDBusRequest *request;
 
   /* parse uri and display parameters */
-  if (!thunar_dbus_service_parse_uri_and_display (dbus_service, uri, display, &file, &screen, &error))
-    return FALSE;
+  request = thunar_dbus_service_request_new (object, invocation, display, startup_id,
+                                             thunar_dbus_service_display_folder_ready,
+                                             thunar_dbus_file_manager_complete_display_folder);
+  thunar_dbus_service_request_add_uri (request, uri);
+  thunar_dbus_service_request_resolve (request);
 
-  /* popup a new window for the folder */
-  application = thunar_application_get ();
-  thunar_application_open_window (application, file, screen, startup_id);
-  g_object_unref (G_OBJECT (application));
+  return TRUE;
+}
 
-  /* cleanup */
-  g_object_unref (G_OBJECT (screen));
-  g_object_unref (G_OBJECT (file));
 
-out:
-  if (error)
-    g_dbus_method_invocation_take_error (invocation, error);
-  else
-    thunar_dbus_file_manager_complete_display_folder (object, invocation);
 
-  return TRUE;
+static void
+thunar_dbus_service_display_folder_ready (ThunarDBusRequest  *request,
+                                          GError            **error)
+{
+  ThunarApplication *application;
+
+  /* popup a new window for the folder */
+  application = thunar_application_get ();
+  thunar_application_open_window (application, request->files->data, request->screen, request->startup_id);
+  g_object_unref (G_OBJECT (application));
 }
 
 
@@ -489,60 +635,80 @@ thunar_dbus_service_display_folder_and_select (ThunarDBusFileManager  *object,
                                                const gchar            *startup_id,
                                                ThunarDBusService      *dbus_service)
 {
-  ThunarApplication *application;
-  ThunarFile        *file;
-  ThunarFile        *folder;
-  GdkScreen         *screen;
-  GtkWidget         *window;
-  GFile             *path;
+  ThunarDBusRequest *request;
   GError            *error = NULL;
 
   /* verify that filename is valid */
   if (G_UNLIKELY (filename == NULL || *filename == '\0' || strchr (filename, '/') != NULL))
     {
       g_set_error (&error, G_FILE_ERROR, G_FILE_ERROR_INVAL, _("Invalid filename \"%s\""), filename);
-      goto out;
+      g_dbus_method_invocation_take_error (invocation, error);
+      return TRUE;
     }
 
   /* parse uri and display parameters */
-  if (!thunar_dbus_service_parse_uri_and_display (dbus_service, uri, display, &folder, &screen, &error))
-    goto out;
+  request = thunar_dbus_service_request_new (object, invocation, display, startup_id,
+                                             thunar_dbus_service_display_folder_and_select_ready,
+                                             thunar_dbus_file_manager_complete_display_folder_and_select);
+  request->argument = g_strdup (filename);
+  thunar_dbus_service_request_add_uri (request, uri);
+  thunar_dbus_service_request_resolve (request);
+
+  return TRUE;
+}
+
+
+
+static void
+thunar_dbus_service_display_folder_and_select_ready (ThunarDBusRequest  *request,
+                                                     GError            **error)
+{
+  ThunarApplication *application;
+  GtkWidget         *window;
+  GWeakRef          *window_ref;
+  GFile             *path;
 
   /* popup a new window for the folder */
   application = thunar_application_get ();
-  window = thunar_application_open_window (application, folder, screen, startup_id);
+  window = thunar_application_open_window (application, request->files->data, request->screen, request->startup_id);
   g_object_unref (application);
 
   /* determine the path for the filename relative to the folder */
-  path = g_file_resolve_relative_path (thunar_file_get_file (folder), filename);
+  path = g_file_resolve_relative_path (thunar_file_get_file (request->files->data), request->argument);
   if (G_LIKELY (path != NULL))
     {
-      /* try to determine the file for the path */
-      file = thunar_file_get (path, NULL);
-      if (G_LIKELY (file != NULL))
-        {
-          /* tell the window to scroll to the given file and select it */
-          thunar_window_scroll_to_file (THUNAR_WINDOW (window), file, TRUE, TRUE, 0.5f, 0.5f);
-
-          /* release the file reference */
-          g_object_unref (file);
-        }
+      /* select the file once it is loaded, the window may be gone by then */
+      window_ref = g_slice_new0 (GWeakRef);
+      g_weak_ref_init (window_ref, window);
+      thunar_file_get_async (path, NULL, thunar_dbus_service_display_folder_and_select_file_ready, window_ref);
 
       /* release the path */
       g_object_unref (path);
     }
+}
 
-  /* cleanup */
-  g_object_unref (screen);
-  g_object_unref (folder);
 
-out:
-  if (error)
-    g_dbus_method_invocation_take_error (invocation, error);
-  else
-    thunar_dbus_file_manager_complete_display_folder_and_select (object, invocation);
 
-  return TRUE;
+static void
+thunar_dbus_service_display_folder_and_select_file_ready (GFile      *location,
+                                                          ThunarFile *file,
+                                                          GError     *error,
+                                                          gpointer    user_data)
+{
+  GWeakRef  *window_ref = user_data;
+  GtkWidget *window;
+
+  window = g_weak_ref_get (window_ref);
+  if (G_LIKELY (window != NULL))
+    {
+      /* tell the window to scroll to the given file and select it */
+      if (G_LIKELY (error == NULL))
+        thunar_window_scroll_to_file (THUNAR_WINDOW (window), file, TRUE, TRUE, 0.5f, 0.5f);
+      g_object_unref (window);
+    }
+
+  g_weak_ref_clear (window_ref);
+  g_slice_free (GWeakRef, window_ref);
 }
 
 
@@ -555,39 +721,38 @@ thunar_dbus_service_display_file_properties (ThunarDBusFileManager  *object,
                                              const gchar            *startup_id,
                                              ThunarDBusService      *dbus_service)
 {
-  ThunarApplication *application;
-  ThunarFile        *file;
-  GdkScreen         *screen;
-  GtkWidget         *dialog;
-  GError            *error = NULL;
+  ThunarDBusRequest *request;
 
   /* parse uri and display parameters */
-  if (!thunar_dbus_service_parse_uri_and_display (dbus_service, uri, display, &file, &screen, &error))
-    goto out;
+  request = thunar_dbus_service_request_new (object, invocation, display, startup_id,
+                                             thunar_dbus_service_display_file_properties_ready,
+                                             thunar_dbus_file_manager_complete_display_file_properties);
+  thunar_dbus_service_request_add_uri (request, uri);
+  thunar_dbus_service_request_resolve (request);
+
+  return TRUE;
+}
+
+
+
+static void
+thunar_dbus_service_display_file_properties_ready (ThunarDBusRequest  *request,
+                                                   GError            **error)
+{
+  ThunarApplication *application;
+  GtkWidget         *dialog;
 
   /* popup the file properties dialog */
   dialog = thunar_properties_dialog_new (NULL);
-  gtk_window_set_screen (GTK_WINDOW (dialog), screen);
-  gtk_window_set_startup_id (GTK_WINDOW (dialog), startup_id);
-  thunar_properties_dialog_set_file (THUNAR_PROPERTIES_DIALOG (dialog), file);
+  gtk_window_set_screen (GTK_WINDOW (dialog), request->screen);
+  gtk_window_set_startup_id (GTK_WINDOW (dialog), request->startup_id);
+  thunar_properties_dialog_set_file (THUNAR_PROPERTIES_DIALOG (dialog), request->files->data);
   gtk_window_present (GTK_WINDOW (dialog));
 
   /* let the application take control over the dialog */
   application = thunar_application_get ();
   thunar_application_take_window (application, GTK_WINDOW (dialog));
   g_object_unref (G_OBJECT (application));
-
-  /* cleanup */
-  g_object_unref (G_OBJECT (screen));
-  g_object_unref (G_OBJECT (file));
-
-out:
-  if (error)
-    g_dbus_method_invocation_take_error (invocation, error);
-  else
-    thunar_dbus_file_manager_complete_display_file_properties (object, invocation);
-
-  return TRUE;
 }
 
 
@@ -600,27 +765,26 @@ thunar_dbus_service_launch (ThunarDBusFileManager  *object,
                             const gchar            *startup_id,
                             ThunarDBusService      *dbus_service)
 {
-  ThunarFile *file;
-  GdkScreen  *screen;
-  GError     *error = NULL;
+  ThunarDBusRequest *request;
 
   /* parse uri and display parameters */
-  if (thunar_dbus_service_parse_uri_and_display (dbus_service, uri, display, &file, &screen, &error))
-    {
-      /* try to launch the file on the given screen */
-      thunar_file_launch (file, screen, startup_id, &error);
+  request = thunar_dbus_service_request_new (object, invocation, display, startup_id,
+                                             thunar_dbus_service_launch_ready,
+                                             thunar_dbus_file_manager_complete_launch);
+  thunar_dbus_service_request_add_uri (request, uri);
+  thunar_dbus_service_request_resolve (request);
 
-      /* cleanup */
-      g_object_unref (G_OBJECT (screen));
-      g_object_unref (G_OBJECT (file));
-    }
+  return TRUE;
+}
 
-  if (error)
-    g_dbus_method_invocation_take_error (invocation, error);
-  else
-    thunar_dbus_file_manager_complete_launch (object, invocation);
 
-  return TRUE;
+
+static void
+thunar_dbus_service_launch_ready (ThunarDBusRequest  *request,
+                                  GError            **error)
+{
+  /* try to launch the file on the given screen */
+  thunar_file_launch (request->files->data, request->screen, request->startup_id, error);
 }
 
 
@@ -635,54 +799,56 @@ thunar_dbus_service_execute (ThunarDBusFileManager  *object,
                              const gchar            *startup_id,
                              ThunarDBusService      *dbus_service)
 {
-  ThunarFile *file;
-  GdkScreen  *screen;
-  GError     *error = NULL;
-  GFile      *working_dir;
-  GList      *file_list = NULL;
-  gchar      *tmp_working_dir = NULL;
-  gchar      *old_working_dir = NULL;
-  guint       n;
+  ThunarDBusRequest *request;
+  gchar             *tmp_working_dir = NULL;
+  gchar             *old_working_dir = NULL;
+  guint              n;
 
   /* parse uri and display parameters */
-  if (thunar_dbus_service_parse_uri_and_display (dbus_service, uri, display, &file, &screen, &error))
-    {
-      if (working_directory != NULL && *working_directory != '\0')
-        old_working_dir = thunar_util_change_working_directory (working_directory);
+  request = thunar_dbus_service_request_new (object, invocation, display, startup_id,
+                                             thunar_dbus_service_execute_ready,
+                                             thunar_dbus_file_manager_complete_execute);
+  request->working_directory = g_strdup (working_directory);
+  thunar_dbus_service_request_add_uri (request, uri);
 
-      for (n = 0; files != NULL && files[n] != NULL; ++n)
-        file_list = g_list_prepend (file_list, g_file_new_for_commandline_arg (files[n]));
+  /* the files are relative to the working directory */
+  if (working_directory != NULL && *working_directory != '\0')
+    old_working_dir = thunar_util_change_working_directory (working_directory);
 
-      file_list = g_list_reverse (file_list);
-
-      if (old_working_dir != NULL)
-        {
-          tmp_working_dir = thunar_util_change_working_directory (old_working_dir);
-          g_free (tmp_working_dir);
-          g_free (old_working_dir);
-        }
+  for (n = 0; files != NULL && files[n] != NULL; ++n)
+    request->argument_files = g_list_prepend (request->argument_files, g_file_new_for_commandline_arg (files[n]));
 
-      /* try to launch the file on the given screen */
-      working_dir = g_file_new_for_commandline_arg (working_directory);
-      thunar_file_execute (file, working_dir, screen, file_list, startup_id, &error);
-      g_object_unref (working_dir);
+  request->argument_files = g_list_reverse (request->argument_files);
 
-      /* cleanup */
-      g_list_free_full (file_list, g_object_unref);
-      g_object_unref (screen);
-      g_object_unref (file);
+  if (old_working_dir != NULL)
+    {
+      tmp_working_dir = thunar_util_change_working_directory (old_working_dir);
+      g_free (tmp_working_dir);
+      g_free (old_working_dir);
     }
 
-  if (error)
-    g_dbus_method_invocation_take_error (invocation, error);
-  else
-    thunar_dbus_file_manager_complete_launch (object, invocation);
+  thunar_dbus_service_request_resolve (request);
 
   return TRUE;
 }
 
 
 
+static void
+thunar_dbus_service_execute_ready (ThunarDBusRequest  *request,
+                                   GError            **error)
+{
+  GFile *working_dir;
+
+  /* try to launch the file on the given screen */
+  working_dir = g_file_new_for_commandline_arg (request->working_directory);
+  thunar_file_execute (request->files->data, working_dir, request->screen,
+                       request->argument_files, request->startup_id, error);
+  g_object_unref (working_dir);
+}
+
+
+
 static gboolean
 thunar_dbus_service_display_preferences_dialog (ThunarDBusFileManager  *object,
                                                 GDBusMethodInvocation  *invocation,
@@ -997,31 +1163,30 @@ thunar_dbus_service_rename_file (ThunarDBusFileManager  *object,
                                  const gchar            *startup_id,
                                  ThunarDBusService      *dbus_service)
 {
-  ThunarApplication *application;
-  ThunarFile        *file;
-  GdkScreen         *screen;
-  GError            *error = NULL;
+  ThunarDBusRequest *request;
 
   /* parse uri and display parameters */
-  if (!thunar_dbus_service_parse_uri_and_display (dbus_service, uri, display, &file, &screen, &error))
-    goto out;
+  request = thunar_dbus_service_request_new (object, invocation, display, startup_id,
+                                             thunar_dbus_service_rename_file_ready,
+                                             thunar_dbus_file_manager_complete_rename_file);
+  thunar_dbus_service_request_add_uri (request, uri);
+  thunar_dbus_service_request_resolve (request);
 
-  /* popup a new window for the folder */
-  application = thunar_application_get ();
-  thunar_application_rename_file (application, file, screen, startup_id);
-  g_object_unref (G_OBJECT (application));
+  return TRUE;
+}
 
-  /* cleanup */
-  g_object_unref (G_OBJECT (screen));
-  g_object_unref (G_OBJECT (file));
 
-out:
-  if (error)
-    g_dbus_method_invocation_take_error (invocation, error);
-  else
-    thunar_dbus_file_manager_complete_rename_file (object, invocation);
 
-  return TRUE;
+static void
+thunar_dbus_service_rename_file_ready (ThunarDBusRequest  *request,
+                                       GError            **error)
+{
+  ThunarApplication *application;
+
+  /* popup a new window for the folder */
+  application = thunar_application_get ();
+  thunar_application_rename_file (application, request->files->data, request->screen, request->startup_id);
+  g_object_unref (G_OBJECT (application));
 }
 
 
@@ -1035,35 +1200,36 @@ thunar_dbus_service_create_file (ThunarDBusFileManager  *object,
                                  const gchar            *startup_id,
                                  ThunarDBusService      *dbus_service)
 {
-  ThunarApplication *application;
-  ThunarFile        *file;
-  GdkScreen         *screen;
-  GError            *error = NULL;
-
-  /* parse uri and display parameters */
-  if (!thunar_dbus_service_parse_uri_and_display (dbus_service, parent_directory, display, &file, &screen, &error))
-    goto out;
+  ThunarDBusRequest *request;
 
   /* fall back to plain text file if no content type is provided */
   if (content_type == NULL || *content_type == '\0')
     content_type = "text/plain";
 
-  /* popup a new window for the folder */
-  application = thunar_application_get ();
-  thunar_application_create_file (application, file, content_type, screen, startup_id);
-  g_object_unref (G_OBJECT (application));
+  /* parse uri and display parameters */
+  request = thunar_dbus_service_request_new (object, invocation, display, startup_id,
+                                             thunar_dbus_service_create_file_ready,
+                                             thunar_dbus_file_manager_complete_create_file);
+  request->argument = g_strdup (content_type);
+  thunar_dbus_service_request_add_uri (request, parent_directory);
+  thunar_dbus_service_request_resolve (request);
 
-  /* cleanup */
-  g_object_unref (G_OBJECT (screen));
-  g_object_unref (G_OBJECT (file));
+  return TRUE;
+}
 
-out:
-  if (error)
-    g_dbus_method_invocation_take_error (invocation, error);
-  else
-    thunar_dbus_file_manager_complete_create_file (object, invocation);
 
-  return TRUE;
+
+static void
+thunar_dbus_service_create_file_ready (ThunarDBusRequest  *request,
+                                       GError            **error)
+{
+  ThunarApplication *application;
+
+  /* popup a new window for the folder */
+  application = thunar_application_get ();
+  thunar_application_create_file (application, request->files->data, request->argument,
+                                  request->screen, request->startup_id);
+  g_object_unref (G_OBJECT (application));
 }
 
 
@@ -1077,37 +1243,32 @@ thunar_dbus_service_create_file_from_template (ThunarDBusFileManager  *object,
                                                const gchar            *startup_id,
                                                ThunarDBusService      *dbus_service)
 {
-  ThunarApplication *application;
-  ThunarFile        *file;
-  ThunarFile        *template_file;
-  GdkScreen         *screen;
-  GError            *error = NULL;
+  ThunarDBusRequest *request;
 
-  /* parse uri and display parameters */
-  if (!thunar_dbus_service_parse_uri_and_display (dbus_service, parent_directory, display, &file, &screen, &error))
-    goto out;
+  /* parse uri and display parameters, and the template URI */
+  request = thunar_dbus_service_request_new (object, invocation, display, startup_id,
+                                             thunar_dbus_service_create_file_from_template_ready,
+                                             thunar_dbus_file_manager_complete_create_file_from_template);
+  thunar_dbus_service_request_add_uri (request, parent_directory);
+  thunar_dbus_service_request_add_uri (request, template_uri);
+  thunar_dbus_service_request_resolve (request);
 
-  /* try to determine the file for the template URI */
-  template_file = thunar_file_get_for_uri (template_uri, &error);
-  if(template_file == NULL)
-    goto out;
+  return TRUE;
+}
 
-  /* popup a new window for the folder */
-  application = thunar_application_get ();
-  thunar_application_create_file_from_template (application, file, template_file, screen, startup_id);
-  g_object_unref (G_OBJECT (application));
 
-  /* cleanup */
-  g_object_unref (G_OBJECT (screen));
-  g_object_unref (G_OBJECT (file));
 
-out:
-  if (error)
-    g_dbus_method_invocation_take_error (invocation, error);
-  else
-    thunar_dbus_file_manager_complete_create_file_from_template (object, invocation);
+static void
+thunar_dbus_service_create_file_from_template_ready (ThunarDBusRequest  *request,
+                                                     GError            **error)
+{
+  ThunarApplication *application;
 
-  return TRUE;
+  /* popup a new window for the folder */
+  application = thunar_application_get ();
+  thunar_application_create_file_from_template (application, request->files->data, request->files->next->data,
+                                                request->screen, request->startup_id);
+  g_object_unref (G_OBJECT (application));
 }
 
 
@@ -1382,12 +1543,8 @@ thunar_dbus_service_unlink_files (ThunarDBusFileManager  *object,
                                   const gchar            *startup_id,
                                   ThunarDBusService      *dbus_service)
 {
-  ThunarApplication *application;
-  ThunarFile        *thunar_file;
-  GFile             *file;
-  GdkScreen         *screen;
+  ThunarDBusRequest *request;
   GError            *err = NULL;
-  GList             *file_list = NULL;
   gchar             *filename;
   gchar             *new_working_dir = NULL;
   gchar             *old_working_dir = NULL;
@@ -1397,71 +1554,62 @@ thunar_dbus_service_unlink_files (ThunarDBusFileManager  *object,
   if (filenames == NULL || *filenames == NULL)
     {
       g_set_error (&err, G_FILE_ERROR, G_FILE_ERROR_INVAL, _("At least one filename must be specified"));
-      goto out;
+      g_dbus_method_invocation_take_error (invocation, err);
+      return TRUE;
     }
 
-  /* try to open the screen for the display name */
-  screen = thunar_gdk_screen_open (display, &err);
-  if (screen != NULL)
-    {
-      /* change the working directory if necessary */
-      if (!exo_str_is_empty (working_directory))
-        old_working_dir = thunar_util_change_working_directory (working_directory);
+  request = thunar_dbus_service_request_new (object, invocation, display, startup_id,
+                                             thunar_dbus_service_unlink_files_ready,
+                                             thunar_dbus_file_manager_complete_unlink_files);
 
-      /* try to parse the specified filenames */
-      for (n = 0; err == NULL && filenames[n] != NULL; ++n)
-        {
-          /* decode the filename (D-BUS uses UTF-8) */
-          filename = g_filename_from_utf8 (filenames[n], -1, NULL, NULL, &err);
-          if (filename != NULL)
-            {
-              /* determine the path for the filename */
-              file = g_file_new_for_commandline_arg (filename);
-              thunar_file = thunar_file_get (file, &err);
+  /* change the working directory if necessary */
+  if (!exo_str_is_empty (working_directory))
+    old_working_dir = thunar_util_change_working_directory (working_directory);
 
-              if (thunar_file != NULL)
-                file_list = g_list_append (file_list, thunar_file);
-
-              g_object_unref (file);
-            }
-
-          /* cleanup */
-          g_free (filename);
-        }
-
-      /* switch back to the previous working directory */
-      if (!exo_str_is_empty (working_directory))
-        {
-          new_working_dir = thunar_util_change_working_directory (old_working_dir);
-          g_free (old_working_dir);
-          g_free (new_working_dir);
-        }
-
-      /* check if we succeeded */
-      if (err == NULL && file_list != NULL)
+  /* try to parse the specified filenames */
+  for (n = 0; request->error == NULL && filenames[n] != NULL; ++n)
+    {
+      /* decode the filename (D-BUS uses UTF-8) */
+      filename = g_filename_from_utf8 (filenames[n], -1, NULL, NULL, &request->error);
+      if (filename != NULL)
         {
-          /* tell the application to move the specified files to the trash */
-          application = thunar_application_get ();
-          thunar_application_unlink_files (application, screen, file_list, TRUE);
-          g_object_unref (application);
+          /* determine the path for the filename */
+          request->locations = g_list_append (request->locations, g_file_new_for_commandline_arg (filename));
         }
 
       /* cleanup */
-      thunar_g_file_list_free (file_list);
-      g_object_unref (screen);
+      g_free (filename);
     }
 
-out:
-  if (err)
-    g_dbus_method_invocation_take_error (invocation, err);
-  else
-    thunar_dbus_file_manager_complete_unlink_files (object, invocation);
+  /* switch back to the previous working directory */
+  if (!exo_str_is_empty (working_directory))
+    {
+      new_working_dir = thunar_util_change_working_directory (old_working_dir);
+      g_free (old_working_dir);
+      g_free (new_working_dir);
+    }
+
+  thunar_dbus_service_request_resolve (request);
 
   return TRUE;
 }
 
 
 
+static void
+thunar_dbus_service_unlink_files_ready (ThunarDBusRequest  *request,
+                                        GError            **error)
+{
+  ThunarApplication *application;
+
+  /* tell the application to move the specified files to the trash */
+  application = thunar_application_get ();
+  thunar_application_unlink_files (application, request->screen, request->files, TRUE);
+  g_object_unref (application);
+}
+
+
+
 static gboolean
 thunar_dbus_service_terminate (ThunarDBusThunar       *object,
                                GDBusMethodInvocation  *invocation,
@@ -33,6 +33,7 @@
 #endif
 
 #include <thunar/thunar-dialogs.h>
+#include <thunar/thunar-gio-extensions.h>
 #include <thunar/thunar-icon-factory.h>
 #include <thunar/thunar-io-jobs.h>
 #include <thunar/thunar-job.h>
@@ -794,10 +795,10 @@ thunar_dialogs_show_insecure_program (gpointer     parent,
   if (response == GTK_RESPONSE_APPLY)
     {
       /* try to query information about the file */
-      info = g_file_query_info (thunar_file_get_file (file),
-                                G_FILE_ATTRIBUTE_UNIX_MODE,
-                                G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
-                                NULL, &err);
+      info = thunar_g_file_query_info (thunar_file_get_file (file),
+                                       G_FILE_ATTRIBUTE_UNIX_MODE,
+                                       G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                       NULL, &err);
 
       if (G_LIKELY (info != NULL))
         {
@@ -60,6 +60,7 @@
 #include <thunar/thunar-exec.h>
 #include <thunar/thunar-file.h>
 #include <thunar/thunar-file-monitor.h>
+#include <thunar/thunar-folder.h>
 #include <thunar/thunar-gio-extensions.h>
 #include <thunar/thunar-gobject-extensions.h>
 #include <thunar/thunar-private.h>
@@ -113,26 +114,58 @@ static void               thunar_file_watch_reconnect          (ThunarFile
 static gboolean           thunar_file_load                     (ThunarFile             *file,
                                                                 GCancellable           *cancellable,
                                                                 GError                **error);
+static void               thunar_file_collate_append           (GString                *key,
+                                                                const gchar            *text,
+                                                                gboolean                count_zeros);
+static void               thunar_file_collate_key              (ThunarFile             *file);
+static void               thunar_file_reload_with_info         (ThunarFile             *file,
+                                                                GFileInfo              *info);
+static void               thunar_file_reload_siblings          (GFile                  *parent,
+                                                                GList                  *file_list);
+static gboolean           thunar_file_reload_queue_idle        (gpointer                user_data);
 static gboolean           thunar_file_is_readable              (const ThunarFile       *file);
 static gboolean           thunar_file_same_filesystem          (const ThunarFile       *file_a,
                                                                 const ThunarFile       *file_b);
 
 
 
-G_LOCK_DEFINE_STATIC (file_cache_mutex);
 G_LOCK_DEFINE_STATIC (file_content_type_mutex);
 G_LOCK_DEFINE_STATIC (file_rename_mutex);
+G_LOCK_DEFINE_STATIC (file_reload_mutex);
 
 
 
 static ThunarUserManager *user_manager;
-static GHashTable        *file_cache;
+static GHashTable        *file_reload_queue;
+static guint              file_reload_idle_id;
 static guint32            effective_user_id;
 static GQuark             thunar_file_watch_quark;
 static guint              file_signals[LAST_SIGNAL];
 
 
 
+/* number of independently locked parts of the file cache (power of two) */
+#define THUNAR_FILE_CACHE_N_SHARDS (16)
+
+/* minimum number of files in a folder to reload by enumerating the folder */
+#define THUNAR_FILE_RELOAD_BATCH_MIN (16)
+
+/* enumerate the folder only if at least 1/n of its files are reloaded,
+ * a few changed files in a huge folder are cheaper to query one by one */
+#define THUNAR_FILE_RELOAD_BATCH_RATIO (4)
+
+/* bytes of the collation key: the separator ends a part of the key,
+ * numbers start with the number marker, so they sort before text like
+ * in g_utf8_collate_key_for_filename(), and the locale collation keys
+ * of the text in between end with the text marker. Bytes of those keys
+ * up to the escape byte are stored as the escape byte and byte + 1 */
+#define THUNAR_FILE_COLLATE_SEPARATOR (0x01)
+#define THUNAR_FILE_COLLATE_NUMBER    (0x02)
+#define THUNAR_FILE_COLLATE_TEXT_END  (0x03)
+#define THUNAR_FILE_COLLATE_ESCAPE    (0x04)
+
+
+
 #define FLAG_SET_THUMB_STATE(file,new_state) G_STMT_START{ (file)->flags = ((file)->flags & ~THUNAR_FILE_FLAG_THUMB_MASK) | (new_state); }G_STMT_END
 #define FLAG_GET_THUMB_STATE(file)           ((file)->flags & THUNAR_FILE_FLAG_THUMB_MASK)
 #define FLAG_SET(file,flag)                  G_STMT_START{ ((file)->flags |= (flag)); }G_STMT_END
@@ -175,9 +208,13 @@ struct _ThunarFile
   gchar                *basename;
   gchar                *thumbnail_path;
 
-  /* sorting */
+  /* sorting, the case sensitive part of the key starts at
+   * the collate_key_case offset, 0 if the name has no case
+   * sensitive part of its own; the key is only (re)built in
+   * thunar_file_info_reload(), comparators never modify it, so
+   * it can be read from the sort threads */
   gchar                *collate_key;
-  gchar                *collate_key_nocase;
+  guint                 collate_key_case;
 
   /* flags for thumbnail state etc */
   ThunarFileFlags       flags;
@@ -221,20 +258,129 @@ G_DEFINE_TYPE_WITH_CODE (ThunarFile, thunar_file, G_TYPE_OBJECT,
     G_IMPLEMENT_INTERFACE (THUNARX_TYPE_FILE_INFO, thunar_file_info_init))
 
 
-static GWeakRef*
-weak_ref_new (GObject *obj)
+/* The ThunarFile cache is split into shards by the hash of the
+ * GFile, each with its own lock, so lookups from different threads
+ * rarely wait for each other. Every entry stores the hash of its
+ * GFile, which avoids most g_file_equal() calls on collisions.
+ */
+typedef struct
+{
+  GFile    *gfile;
+  guint     hash;
+  GWeakRef  ref;
+} ThunarFileCacheEntry;
+
+typedef struct
+{
+  GMutex      lock;
+  GHashTable *entries;
+} ThunarFileCacheShard;
+
+static ThunarFileCacheShard file_cache[THUNAR_FILE_CACHE_N_SHARDS];
+
+
+
+static guint
+thunar_file_cache_entry_hash (gconstpointer data)
 {
-  GWeakRef *ref;
-  ref = g_slice_new (GWeakRef);
-  g_weak_ref_init (ref, obj);
-  return ref;
+  return ((const ThunarFileCacheEntry *) data)->hash;
 }
 
+
+
+static gboolean
+thunar_file_cache_entry_equal (gconstpointer a,
+                               gconstpointer b)
+{
+  const ThunarFileCacheEntry *entry_a = a;
+  const ThunarFileCacheEntry *entry_b = b;
+
+  return entry_a->hash == entry_b->hash
+      && (entry_a->gfile == entry_b->gfile || g_file_equal (entry_a->gfile, entry_b->gfile));
+}
+
+
+
 static void
-weak_ref_free (GWeakRef *ref)
+thunar_file_cache_entry_free (gpointer data)
 {
-  g_weak_ref_clear (ref);
-  g_slice_free (GWeakRef, ref);
+  ThunarFileCacheEntry *entry = data;
+
+  g_weak_ref_clear (&entry->ref);
+  g_object_unref (entry->gfile);
+  g_slice_free (ThunarFileCacheEntry, entry);
+}
+
+
+
+static ThunarFileCacheShard*
+thunar_file_cache_shard_lock (guint hash)
+{
+  ThunarFileCacheShard *shard = &file_cache[hash & (THUNAR_FILE_CACHE_N_SHARDS - 1)];
+
+  g_mutex_lock (&shard->lock);
+
+  /* allocate the shard table on-demand, entries are both key and value */
+  if (G_UNLIKELY (shard->entries == NULL))
+    {
+      shard->entries = g_hash_table_new_full (thunar_file_cache_entry_hash,
+                                              thunar_file_cache_entry_equal,
+                                              NULL, thunar_file_cache_entry_free);
+    }
+
+  return shard;
+}
+
+
+
+static void
+thunar_file_cache_insert (ThunarFile *file)
+{
+  ThunarFileCacheShard *shard;
+  ThunarFileCacheEntry *entry;
+
+  entry = g_slice_new (ThunarFileCacheEntry);
+  entry->gfile = g_object_ref (file->gfile);
+  entry->hash = g_file_hash (file->gfile);
+  g_weak_ref_init (&entry->ref, file);
+
+  /* replace any previous entry for the same location */
+  shard = thunar_file_cache_shard_lock (entry->hash);
+  g_hash_table_replace (shard->entries, entry, entry);
+  g_mutex_unlock (&shard->lock);
+}
+
+
+
+static void
+thunar_file_cache_remove (GFile      *gfile,
+                          ThunarFile *file)
+{
+  ThunarFileCacheShard *shard;
+  ThunarFileCacheEntry *entry;
+  ThunarFileCacheEntry  key;
+  ThunarFile           *cached_file = NULL;
+
+  key.gfile = gfile;
+  key.hash = g_file_hash (gfile);
+
+  shard = thunar_file_cache_shard_lock (key.hash);
+
+  /* only drop the entry if it belongs to file (or a finalized file),
+   * another thread might have inserted a new file for the location */
+  entry = g_hash_table_lookup (shard->entries, &key);
+  if (entry != NULL)
+    {
+      cached_file = g_weak_ref_get (&entry->ref);
+      if (cached_file == NULL || cached_file == file)
+        g_hash_table_remove (shard->entries, entry);
+    }
+
+  g_mutex_unlock (&shard->lock);
+
+  /* release the reference outside the lock, it might be the last one */
+  if (cached_file != NULL)
+    g_object_unref (cached_file);
 }
 
 
@@ -249,12 +395,13 @@ thunar_file_atexit_foreach (gpointer key,
                             gpointer value,
                             gpointer user_data)
 {
+  GFile *gfile = ((ThunarFileCacheEntry *) key)->gfile;
   gchar *uri;
 
-  uri = g_file_get_uri (key);
+  uri = g_file_get_uri (gfile);
   g_print ("--> %s\n", uri);
-  if (G_OBJECT (key)->ref_count > 2)
-    g_print ("    GFile (%u)\n", G_OBJECT (key)->ref_count - 2);
+  if (G_OBJECT (gfile)->ref_count > 2)
+    g_print ("    GFile (%u)\n", G_OBJECT (gfile)->ref_count - 2);
   g_free (uri);
 }
 
@@ -263,22 +410,26 @@ thunar_file_atexit_foreach (gpointer key,
 static void
 thunar_file_atexit (void)
 {
-  G_LOCK (file_cache_mutex);
+  guint n, n_leaked = 0;
 
-  if (file_cache == NULL || g_hash_table_size (file_cache) == 0)
-    {
-      G_UNLOCK (file_cache_mutex);
-      return;
-    }
+  for (n = 0; n < THUNAR_FILE_CACHE_N_SHARDS; ++n)
+    if (file_cache[n].entries != NULL)
+      n_leaked += g_hash_table_size (file_cache[n].entries);
 
-  g_print ("--- Leaked a total of %u ThunarFile objects:\n",
-           g_hash_table_size (file_cache));
+  if (n_leaked == 0)
+    return;
 
-  g_hash_table_foreach (file_cache, thunar_file_atexit_foreach, NULL);
+  g_print ("--- Leaked a total of %u ThunarFile objects:\n", n_leaked);
 
-  g_print ("\n");
+  for (n = 0; n < THUNAR_FILE_CACHE_N_SHARDS; ++n)
+    {
+      g_mutex_lock (&file_cache[n].lock);
+      if (file_cache[n].entries != NULL)
+        g_hash_table_foreach (file_cache[n].entries, thunar_file_atexit_foreach, NULL);
+      g_mutex_unlock (&file_cache[n].lock);
+    }
 
-  G_UNLOCK (file_cache_mutex);
+  g_print ("\n");
 }
 #endif
 #endif
@@ -287,13 +438,13 @@ thunar_file_atexit (void)
 
 #if DUMP_FILE_CACHE
 static void
-thunar_file_cache_dump_foreach (gpointer gfile,
+thunar_file_cache_dump_foreach (gpointer key,
                                 gpointer value,
                                 gpointer user_data)
 {
   gchar *name;
 
-  name = g_file_get_parse_name (G_FILE (gfile));
+  name = g_file_get_parse_name (((ThunarFileCacheEntry *) key)->gfile);
   g_print ("    %s\n", name);
   g_free (name);
 }
@@ -303,19 +454,19 @@ thunar_file_cache_dump_foreach (gpointer gfile,
 static gboolean
 thunar_file_cache_dump (gpointer user_data)
 {
-  G_LOCK (file_cache_mutex);
-
-  if (file_cache != NULL)
-    {
-      g_print ("--- %d ThunarFile objects in cache:\n",
-               g_hash_table_size (file_cache));
+  guint n;
 
-      g_hash_table_foreach (file_cache, thunar_file_cache_dump_foreach, NULL);
+  g_print ("--- ThunarFile objects in cache:\n");
 
-      g_print ("\n");
+  for (n = 0; n < THUNAR_FILE_CACHE_N_SHARDS; ++n)
+    {
+      g_mutex_lock (&file_cache[n].lock);
+      if (file_cache[n].entries != NULL)
+        g_hash_table_foreach (file_cache[n].entries, thunar_file_cache_dump_foreach, NULL);
+      g_mutex_unlock (&file_cache[n].lock);
     }
 
-  G_UNLOCK (file_cache_mutex);
+  g_print ("\n");
 
   return TRUE;
 }
@@ -434,9 +585,7 @@ thunar_file_finalize (GObject *object)
 #endif
 
   /* drop the entry from the cache */
-  G_LOCK (file_cache_mutex);
-  g_hash_table_remove (file_cache, file->gfile);
-  G_UNLOCK (file_cache_mutex);
+  thunar_file_cache_remove (file->gfile, file);
 
   /* release file info */
   if (file->info != NULL)
@@ -449,13 +598,12 @@ thunar_file_finalize (GObject *object)
   g_free (file->content_type);
   g_free (file->icon_name);
 
-  /* free display name and basename */
-  g_free (file->display_name);
+  /* free display name and basename, the display name might be the basename */
+  if (file->display_name != file->basename)
+    g_free (file->display_name);
   g_free (file->basename);
 
-  /* free collate keys */
-  if (file->collate_key_nocase != file->collate_key)
-    g_free (file->collate_key_nocase);
+  /* free collate key */
   g_free (file->collate_key);
 
   /* free the thumbnail path */
@@ -557,9 +705,9 @@ thunar_file_info_get_filesystem_info (ThunarxFileInfo *file_info)
 {
   _thunar_return_val_if_fail (THUNAR_IS_FILE (file_info), NULL);
 
-  return g_file_query_filesystem_info (THUNAR_FILE (file_info)->gfile, 
-                                       THUNARX_FILESYSTEM_INFO_NAMESPACE,
-                                       NULL, NULL);
+  return thunar_g_file_query_filesystem_info (THUNAR_FILE (file_info)->gfile,
+                                              THUNARX_FILESYSTEM_INFO_NAMESPACE,
+                                              NULL, NULL);
 }
 
 
@@ -736,20 +884,14 @@ thunar_file_monitor_moved (ThunarFile *file,
   /* need to re-register the monitor handle for the new uri */
   thunar_file_watch_reconnect (file);
 
-  G_LOCK (file_cache_mutex);
-
   /* drop the previous entry from the cache */
-  g_hash_table_remove (file_cache, previous_file);
+  thunar_file_cache_remove (previous_file, file);
 
   /* drop the reference on the previous file */
   g_object_unref (previous_file);
 
   /* insert the new entry */
-  g_hash_table_insert (file_cache,
-                       g_object_ref (file->gfile),
-                       weak_ref_new (G_OBJECT (file)));
-
-  G_UNLOCK (file_cache_mutex);
+  thunar_file_cache_insert (file);
 }
 
 
@@ -929,8 +1071,9 @@ thunar_file_info_clear (ThunarFile *file)
   g_free (file->custom_icon_name);
   file->custom_icon_name = NULL;
 
-  /* free display name and basename */
-  g_free (file->display_name);
+  /* free display name and basename, the display name might be the basename */
+  if (file->display_name != file->basename)
+    g_free (file->display_name);
   file->display_name = NULL;
 
   g_free (file->basename);
@@ -942,11 +1085,7 @@ thunar_file_info_clear (ThunarFile *file)
   g_free (file->icon_name);
   file->icon_name = NULL;
 
-  /* free collate keys */
-  if (file->collate_key_nocase != file->collate_key)
-    g_free (file->collate_key_nocase);
-  file->collate_key_nocase = NULL;
-
+  /* free collate key */
   g_free (file->collate_key);
   file->collate_key = NULL;
 
@@ -972,7 +1111,6 @@ thunar_file_info_reload (ThunarFile   *file,
   gchar       *p;
   const gchar *display_name;
   gboolean     is_secure = FALSE;
-  gchar       *casefold;
   gchar       *path;
 
   _thunar_return_if_fail (THUNAR_IS_FILE (file));
@@ -1071,6 +1209,8 @@ thunar_file_info_reload (ThunarFile   *file,
             {
               if (strcmp (display_name, "/") == 0)
                 file->display_name = g_strdup (_("File System"));
+              else if (strcmp (display_name, file->basename) == 0)
+                file->display_name = file->basename;
               else
                 file->display_name = g_strdup (display_name);
             }
@@ -1081,19 +1221,119 @@ thunar_file_info_reload (ThunarFile   *file,
         file->display_name = thunar_g_file_get_display_name (file->gfile);
     }
 
-  /* create case sensitive collation key */
-  file->collate_key = g_utf8_collate_key_for_filename (file->display_name, -1);
+  /* create the collation key, compared for every name sort */
+  thunar_file_collate_key (file);
+}
+
+
+
+static void
+thunar_file_collate_append (GString     *key,
+                            const gchar *text,
+                            gboolean     count_zeros)
+{
+  const gchar *digits;
+  const gchar *end;
+  const gchar *p;
+  gsize        n_zeros;
+  gchar       *text_key;
+  gchar       *t;
+
+  for (p = text; *p != '\0'; p = end)
+    {
+      if (g_ascii_isdigit (*p))
+        {
+          /* numbers compare by their number of significant digits
+           * first and then by the digits, so "file9" sorts before
+           * "file10"; the length bytes are never a marker */
+          for (n_zeros = 0; *p == '0'; ++p, ++n_zeros);
+          for (digits = p; g_ascii_isdigit (*p); ++p);
+          end = p;
+
+          /* a number of only zeros is 0 */
+          if (digits == end)
+            {
+              digits -= 1;
+              n_zeros -= 1;
+            }
+
+          g_string_append_c (key, THUNAR_FILE_COLLATE_NUMBER);
+          g_string_append_c (key, (gchar) (MIN (end - digits, 254) + 1));
+          g_string_append_len (key, digits, end - digits);
+
+          /* leading zeros only break ties */
+          if (count_zeros)
+            g_string_append_c (key, (gchar) (MIN (n_zeros, 253) + 2));
+        }
+      else
+        {
+          /* the text up to the next number sorts like the locale says */
+          for (end = p; *end != '\0' && !g_ascii_isdigit (*end); ++end);
+          text_key = g_utf8_collate_key (p, end - p);
+
+          for (t = text_key; *t != '\0'; ++t)
+            {
+              if (G_UNLIKELY ((guchar) *t <= THUNAR_FILE_COLLATE_ESCAPE))
+                {
+                  g_string_append_c (key, THUNAR_FILE_COLLATE_ESCAPE);
+                  g_string_append_c (key, *t + 1);
+                }
+              else
+                {
+                  g_string_append_c (key, *t);
+                }
+            }
+          g_string_append_c (key, THUNAR_FILE_COLLATE_TEXT_END);
+
+          g_free (text_key);
+        }
+    }
+
+  g_string_append_c (key, THUNAR_FILE_COLLATE_SEPARATOR);
+}
+
+
+
+static void
+thunar_file_collate_key (ThunarFile *file)
+{
+  GString     *key;
+  gchar       *casefold;
+  const gchar *original_path;
+
+  _thunar_return_if_fail (file->display_name != NULL);
 
-  /* lowercase the display name */
   casefold = g_utf8_casefold (file->display_name, -1);
 
-  /* if the lowercase name is equal, only peek the already hash key */
-  if (casefold != NULL && strcmp (casefold, file->display_name) != 0)
-    file->collate_key_nocase = g_utf8_collate_key_for_filename (casefold, -1);
-  else
-    file->collate_key_nocase = file->collate_key;
+  key = g_string_sized_new (8 * strlen (file->display_name) + 8);
+
+  /* the key is a sequence of separated parts, each only compared
+   * if the parts before are equal: the lowercase name and the case
+   * sensitive name, both made of the locale collation keys of the
+   * text and the numbers in between */
+  thunar_file_collate_append (key, casefold, FALSE);
+  file->collate_key_case = key->len;
+  thunar_file_collate_append (key, file->display_name, TRUE);
+
+  /* most names are lowercase without numbers, store their key only
+   * once, the first part is then also the case sensitive part */
+  if (key->len == 2 * file->collate_key_case
+      && memcmp (key->str, key->str + file->collate_key_case, file->collate_key_case) == 0)
+    {
+      g_string_truncate (key, file->collate_key_case);
+      file->collate_key_case = 0;
+    }
+
+  /* files in the trash can have the same name */
+  original_path = thunar_file_get_original_path (file);
+  if (G_UNLIKELY (original_path != NULL))
+    g_string_append (key, original_path);
+
+  /* the string has room for the largest keys, only keep the
+   * bytes of the key, it lives as long as the file */
+  file->collate_key = g_strndup (key->str, key->len);
+  g_string_free (key, TRUE);
 
-  /* cleanup */
   g_free (casefold);
 }
 
@@ -1116,40 +1356,52 @@ thunar_file_get_async_finish (GObject      *object,
   /* finish querying the file information */
   file_info = g_file_query_info_finish (location, result, &error);
 
-  /* allocate a new file object */
-  file = g_object_new (THUNAR_TYPE_FILE, NULL);
-  file->gfile = g_object_ref (location);
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    {
+      /* don't cache a file without information */
+      file = NULL;
+    }
+  else if ((file = thunar_file_cache_lookup (location)) != NULL)
+    {
+      /* another lookup was faster, use its file */
+      if (file_info != NULL)
+        g_object_unref (file_info);
+      g_clear_error (&error);
+    }
+  else
+    {
+      /* allocate a new file object */
+      file = g_object_new (THUNAR_TYPE_FILE, NULL);
+      file->gfile = g_object_ref (location);
 
-  /* reset the file */
-  thunar_file_info_clear (file);
+      /* reset the file */
+      thunar_file_info_clear (file);
 
-  /* set the file information */
-  file->info = file_info;
+      /* set the file information */
+      file->info = file_info;
 
-  /* update the file from the information */
-  thunar_file_info_reload (file, data->cancellable);
+      /* update the file from the information */
+      thunar_file_info_reload (file, data->cancellable);
 
-  /* update the mounted info */
-  if (error != NULL
-      && error->domain == G_IO_ERROR
-      && error->code == G_IO_ERROR_NOT_MOUNTED)
-   {
-      FLAG_UNSET (file, THUNAR_FILE_FLAG_IS_MOUNTED);
-      g_clear_error (&error);
-   }
+      /* update the mounted info */
+      if (error != NULL
+          && error->domain == G_IO_ERROR
+          && error->code == G_IO_ERROR_NOT_MOUNTED)
+       {
+          FLAG_UNSET (file, THUNAR_FILE_FLAG_IS_MOUNTED);
+          g_clear_error (&error);
+       }
 
-  /* insert the file into the cache */
-  G_LOCK (file_cache_mutex);
-  g_hash_table_insert (file_cache,
-                       g_object_ref (file->gfile),
-                       weak_ref_new (G_OBJECT (file)));
-  G_UNLOCK (file_cache_mutex);
+      /* insert the file into the cache */
+      thunar_file_cache_insert (file);
+    }
 
   /* pass the loaded file and possible errors to the return function */
   (data->func) (location, file, error, data->user_data);
 
   /* release the file, see description in ThunarFileGetFunc */
-  g_object_unref (file);
+  if (G_LIKELY (file != NULL))
+    g_object_unref (file);
 
   /* free the error, if there is any */
   if (error != NULL)
@@ -1193,10 +1445,10 @@ thunar_file_load (ThunarFile   *file,
   thunar_file_info_clear (file);
 
   /* query a new file info */
-  file->info = g_file_query_info (file->gfile,
-                                  THUNARX_FILE_INFO_NAMESPACE,
-                                  G_FILE_QUERY_INFO_NONE,
-                                  cancellable, &err);
+  file->info = thunar_g_file_query_info (file->gfile,
+                                         THUNARX_FILE_INFO_NAMESPACE,
+                                         G_FILE_QUERY_INFO_NONE,
+                                         cancellable, &err);
 
   /* update the file from the information */
   thunar_file_info_reload (file, cancellable);
@@ -1260,16 +1512,8 @@ thunar_file_get (GFile   *gfile,
 
       if (thunar_file_load (file, NULL, error))
         {
-          /* setup lock until the file is inserted */
-          G_LOCK (file_cache_mutex);
-
           /* insert the file into the cache */
-          g_hash_table_insert (file_cache,
-                               g_object_ref (file->gfile),
-                               weak_ref_new (G_OBJECT (file)));
-
-          /* done inserting in the cache */
-          G_UNLOCK (file_cache_mutex);
+          thunar_file_cache_insert (file);
         }
       else
         {
@@ -1339,16 +1583,8 @@ thunar_file_get_with_info (GFile     *gfile,
       if (not_mounted)
         FLAG_UNSET (file, THUNAR_FILE_FLAG_IS_MOUNTED);
 
-      /* setup lock until the file is inserted */
-      G_LOCK (file_cache_mutex);
-
       /* insert the file into the cache */
-      g_hash_table_insert (file_cache,
-                           g_object_ref (file->gfile),
-                           weak_ref_new (G_OBJECT (file)));
-
-      /* done inserting in the cache */
-      G_UNLOCK (file_cache_mutex);
+      thunar_file_cache_insert (file);
     }
 
   return file;
@@ -1393,6 +1629,17 @@ thunar_file_get_for_uri (const gchar *uri,
 
 /**
  * thunar_file_get_async:
+ * @location    : a #GFile.
+ * @cancellable : a #GCancellable or %NULL.
+ * @func        : the #ThunarFileGetFunc to call with the file.
+ * @user_data   : data to pass to @func.
+ *
+ * Looks up the #ThunarFile referred to by @location like thunar_file_get(),
+ * but without blocking on the file information. If the file is cached,
+ * @func is called before this function returns.
+ *
+ * If @cancellable is cancelled before the information is loaded, @func
+ * is called with a %NULL file and a %G_IO_ERROR_CANCELLED error.
  **/
 void
 thunar_file_get_async (GFile            *location,
@@ -2440,10 +2687,10 @@ thunar_file_get_content_type (ThunarFile *file)
       else
         {
           /* async load the content-type */
-          info = g_file_query_info (file->gfile,
-                                    G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE,
-                                    G_FILE_QUERY_INFO_NONE,
-                                    NULL, &err);
+          info = thunar_g_file_query_info (file->gfile,
+                                           G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE,
+                                           G_FILE_QUERY_INFO_NONE,
+                                           NULL, &err);
 
           if (G_LIKELY (info != NULL))
             {
@@ -3650,7 +3897,7 @@ thunar_file_get_preview_type (const ThunarFile *file)
   _thunar_return_val_if_fail (THUNAR_IS_FILE (file), G_FILESYSTEM_PREVIEW_TYPE_NEVER);
   _thunar_return_val_if_fail (G_IS_FILE (file->gfile), G_FILESYSTEM_PREVIEW_TYPE_NEVER);
 
-  info = g_file_query_filesystem_info (file->gfile, G_FILE_ATTRIBUTE_FILESYSTEM_USE_PREVIEW, NULL, NULL);
+  info = thunar_g_file_query_filesystem_info (file->gfile, G_FILE_ATTRIBUTE_FILESYSTEM_USE_PREVIEW, NULL, NULL);
   if (G_LIKELY (info != NULL))
     {
       preview = g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_FILESYSTEM_USE_PREVIEW);
@@ -3783,9 +4030,10 @@ thunar_file_get_icon_name (ThunarFile          *file,
            || g_file_has_uri_scheme (file->gfile, "network"))
     {
       /* query the icon (computer:// and network:// backend) */
-      fileinfo = g_file_query_info (file->gfile,
-                                    G_FILE_ATTRIBUTE_STANDARD_ICON,
-                                    G_FILE_QUERY_INFO_NONE, NULL, NULL);
+      fileinfo = thunar_g_file_query_info (file->gfile,
+                                           G_FILE_ATTRIBUTE_STANDARD_ICON,
+                                           G_FILE_QUERY_INFO_NONE,
+                                           NULL, NULL);
       if (G_LIKELY (fileinfo != NULL))
         {
           /* take the icon from the info */
@@ -3969,20 +4217,199 @@ thunar_file_reload (ThunarFile *file)
 
 
  
+static void
+thunar_file_reload_with_info (ThunarFile *file,
+                              GFileInfo  *info)
+{
+  _thunar_return_if_fail (THUNAR_IS_FILE (file));
+  _thunar_return_if_fail (G_IS_FILE_INFO (info));
+
+  /* clear file pxmap cache */
+  thunar_icon_factory_clear_pixmap_cache (file);
+
+  /* reset the file and set the new info */
+  thunar_file_info_clear (file);
+  file->info = g_object_ref (info);
+
+  /* update the file from the information */
+  thunar_file_info_reload (file, NULL);
+
+  /* ... and tell others */
+  thunar_file_changed (file);
+}
+
+
+
+static void
+thunar_file_reload_siblings (GFile *parent,
+                             GList *file_list)
+{
+  GFileEnumerator *enumerator;
+  GHashTableIter   iter;
+  GHashTable      *names;
+  GFileInfo       *info;
+  ThunarFile      *file;
+  GList           *lp;
+
+  /* lookup table for the files by their basename */
+  names = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  for (lp = file_list; lp != NULL; lp = lp->next)
+    g_hash_table_insert (names, g_file_get_basename (THUNAR_FILE (lp->data)->gfile), lp->data);
+
+  /* query the information of all files with a single enumeration */
+  enumerator = g_file_enumerate_children (parent, THUNARX_FILE_INFO_NAMESPACE,
+                                          G_FILE_QUERY_INFO_NONE, NULL, NULL);
+  if (G_LIKELY (enumerator != NULL))
+    {
+      while (g_hash_table_size (names) > 0)
+        {
+          info = g_file_enumerator_next_file (enumerator, NULL, NULL);
+          if (G_UNLIKELY (info == NULL))
+            break;
+
+          /* check if we're supposed to reload this file */
+          file = g_hash_table_lookup (names, g_file_info_get_name (info));
+          if (file != NULL)
+            {
+              g_hash_table_remove (names, g_file_info_get_name (info));
+              thunar_file_reload_with_info (file, info);
+            }
+
+          g_object_unref (info);
+        }
+
+      g_object_unref (enumerator);
+    }
+
+  /* reload the files we did not find, this will also
+   * destroy the files that no longer exist */
+  g_hash_table_iter_init (&iter, names);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer) &file))
+    thunar_file_reload (file);
+
+  g_hash_table_destroy (names);
+}
+
+
+
+/**
+ * thunar_file_reload_list:
+ * @file_list : a #GList of #ThunarFile<!---->s.
+ *
+ * Reloads all files in @file_list like thunar_file_reload().
+ * If @file_list contains a large part of the files in a loaded
+ * folder, their information is queried with a single enumeration
+ * of the folder instead of one query per file.
+ **/
+void
+thunar_file_reload_list (GList *file_list)
+{
+  GHashTableIter  iter;
+  GHashTable     *parents;
+  ThunarFile     *parent_file;
+  GFile          *parent;
+  GList          *siblings;
+  GList          *lp;
+  guint           n_siblings;
+  gint            n_files;
+
+  /* group the files by their parent folder */
+  parents = g_hash_table_new_full (g_file_hash, (GEqualFunc) g_file_equal, g_object_unref, NULL);
+  for (lp = file_list; lp != NULL; lp = lp->next)
+    {
+      /* the root folder has no siblings */
+      parent = g_file_get_parent (THUNAR_FILE (lp->data)->gfile);
+      if (G_UNLIKELY (parent == NULL))
+        {
+          thunar_file_reload (lp->data);
+          continue;
+        }
+
+      /* keep a reference, a reload might destroy the file */
+      siblings = g_hash_table_lookup (parents, parent);
+      siblings = g_list_prepend (siblings, g_object_ref (lp->data));
+      g_hash_table_replace (parents, parent, siblings);
+    }
+
+  g_hash_table_iter_init (&iter, parents);
+  while (g_hash_table_iter_next (&iter, (gpointer) &parent, (gpointer) &siblings))
+    {
+      /* compare with the size of the folder, if we know it */
+      n_siblings = g_list_length (siblings);
+      n_files = -1;
+      if (n_siblings >= THUNAR_FILE_RELOAD_BATCH_MIN)
+        {
+          parent_file = thunar_file_cache_lookup (parent);
+          if (G_LIKELY (parent_file != NULL))
+            {
+              n_files = thunar_folder_count_files (parent_file);
+              g_object_unref (parent_file);
+            }
+        }
+
+      if (n_files >= 0 && n_siblings * THUNAR_FILE_RELOAD_BATCH_RATIO >= (guint) n_files)
+        {
+          thunar_file_reload_siblings (parent, siblings);
+        }
+      else
+        {
+          for (lp = siblings; lp != NULL; lp = lp->next)
+            thunar_file_reload (lp->data);
+        }
+
+      g_list_free_full (siblings, g_object_unref);
+    }
+
+  g_hash_table_destroy (parents);
+}
+
+
+
+static gboolean
+thunar_file_reload_queue_idle (gpointer user_data)
+{
+  GHashTable *queue;
+  GList      *file_list;
+
+  /* take the queued files */
+  G_LOCK (file_reload_mutex);
+  queue = file_reload_queue;
+  file_reload_queue = NULL;
+  file_reload_idle_id = 0;
+  G_UNLOCK (file_reload_mutex);
+
+  if (G_LIKELY (queue != NULL))
+    {
+      /* reload them at once, the queue keeps the references */
+      file_list = g_hash_table_get_keys (queue);
+      thunar_file_reload_list (file_list);
+      g_list_free (file_list);
+
+      g_hash_table_destroy (queue);
+    }
+
+  return FALSE;
+}
+
+
+
 /**
  * thunar_file_reload_idle:
  * @file : a #ThunarFile instance.
  *
  * Schedules a reload of the @file by calling thunar_file_reload
- * when idle.
+ * when idle. Files that are scheduled multiple times are reloaded
+ * only once, and files that are scheduled in the same folder are
+ * reloaded together using thunar_file_reload_list().
  *
+ * This function may be called from any thread.
  **/
 void
 thunar_file_reload_idle (ThunarFile *file)
 {
   _thunar_return_if_fail (THUNAR_IS_FILE (file));
 
-  g_idle_add ((GSourceFunc) thunar_file_reload, file);
+  thunar_file_reload_idle_unref (g_object_ref (file));
 }
 
 
@@ -3991,20 +4418,30 @@ thunar_file_reload_idle (ThunarFile *file)
  * thunar_file_reload_idle_unref:
  * @file : a #ThunarFile instance.
  *
- * Schedules a reload of the @file by calling thunar_file_reload
- * when idle. When scheduled function returns @file object will be
- * unreferenced.
- *
+ * Schedules a reload of the @file like thunar_file_reload_idle()
+ * and takes over the caller's reference on @file, which is released
+ * after the reload.
  **/
 void
 thunar_file_reload_idle_unref (ThunarFile *file)
 {
   _thunar_return_if_fail (THUNAR_IS_FILE (file));
 
-  g_idle_add_full (G_PRIORITY_DEFAULT_IDLE,
-                   (GSourceFunc) thunar_file_reload,
-                   file,
-                   (GDestroyNotify) g_object_unref);
+  G_LOCK (file_reload_mutex);
+
+  if (file_reload_queue == NULL)
+    file_reload_queue = g_hash_table_new_full (g_direct_hash, g_direct_equal, g_object_unref, NULL);
+
+  /* the queue owns the reference, drop it if the file is already queued */
+  if (g_hash_table_lookup_extended (file_reload_queue, file, NULL, NULL))
+    g_object_unref (file);
+  else
+    g_hash_table_insert (file_reload_queue, file, NULL);
+
+  if (file_reload_idle_id == 0)
+    file_reload_idle_id = g_idle_add (thunar_file_reload_queue_idle, NULL);
+
+  G_UNLOCK (file_reload_mutex);
 }
 
 
@@ -4061,7 +4498,8 @@ thunar_file_compare_by_name (const ThunarFile *file_a,
                              const ThunarFile *file_b,
                              gboolean          case_sensitive)
 {
-  gint result = 0;
+  const guchar *key_a;
+  const guchar *key_b;
 
 #ifdef G_ENABLE_DEBUG
   /* probably too expensive to do the instance check every time
@@ -4069,24 +4507,27 @@ thunar_file_compare_by_name (const ThunarFile *file_a,
    */
   _thunar_return_val_if_fail (THUNAR_IS_FILE (file_a), 0);
   _thunar_return_val_if_fail (THUNAR_IS_FILE (file_b), 0);
+  _thunar_return_val_if_fail (file_a->collate_key != NULL, 0);
+  _thunar_return_val_if_fail (file_b->collate_key != NULL, 0);
 #endif
 
-  /* case insensitive checking */
+  /* compare the case insensitive parts of the keys, they end
+   * with the separator, which sorts before all other bytes */
   if (G_LIKELY (!case_sensitive))
-    result = strcmp (file_a->collate_key_nocase, file_b->collate_key_nocase);
-
-  /* fall-back to case sensitive */
-  if (result == 0)
-    result = strcmp (file_a->collate_key, file_b->collate_key);
-
-  /* this happens in the trash */
-  if (result == 0)
     {
-      result = g_strcmp0 (thunar_file_get_original_path (file_a),
-                          thunar_file_get_original_path (file_b));
+      for (key_a = (const guchar *) file_a->collate_key, key_b = (const guchar *) file_b->collate_key;
+           *key_a == *key_b; ++key_a, ++key_b)
+        if (*key_a == THUNAR_FILE_COLLATE_SEPARATOR)
+          break;
+
+      if (*key_a != *key_b)
+        return (*key_a < *key_b) ? -1 : 1;
     }
 
-  return result;
+  /* fall back to the case sensitive parts and the original path
+   * in the trash, either of them may be shared with the first part */
+  return strcmp (file_a->collate_key + file_a->collate_key_case,
+                 file_b->collate_key + file_b->collate_key_case);
 }
 
 
@@ -4138,30 +4579,24 @@ thunar_file_same_filesystem (const ThunarFile *file_a,
 ThunarFile *
 thunar_file_cache_lookup (const GFile *file)
 {
-  GWeakRef   *ref;
-  ThunarFile *cached_file;
+  ThunarFileCacheShard *shard;
+  ThunarFileCacheEntry *entry;
+  ThunarFileCacheEntry  key;
+  ThunarFile           *cached_file = NULL;
 
   _thunar_return_val_if_fail (G_IS_FILE (file), NULL);
 
-  G_LOCK (file_cache_mutex);
+  /* hash outside the lock */
+  key.gfile = (GFile *) file;
+  key.hash = g_file_hash (file);
 
-  /* allocate the ThunarFile cache on-demand */
-  if (G_UNLIKELY (file_cache == NULL))
-    {
-      file_cache = g_hash_table_new_full (g_file_hash, 
-                                          (GEqualFunc) g_file_equal, 
-                                          (GDestroyNotify) g_object_unref, 
-                                          (GDestroyNotify) weak_ref_free);
-    }
-
-  ref = g_hash_table_lookup (file_cache, file);
+  shard = thunar_file_cache_shard_lock (key.hash);
 
-  if (ref == NULL)
-    cached_file = NULL;
-  else
-    cached_file = g_weak_ref_get (ref);
+  entry = g_hash_table_lookup (shard->entries, &key);
+  if (entry != NULL)
+    cached_file = g_weak_ref_get (&entry->ref);
 
-  G_UNLOCK (file_cache_mutex);
+  g_mutex_unlock (&shard->lock);
 
   return cached_file;
 }
@@ -240,6 +240,7 @@ void              thunar_file_watch                      (ThunarFile
 void              thunar_file_unwatch                    (ThunarFile              *file);
 
 gboolean          thunar_file_reload                     (ThunarFile              *file);
+void              thunar_file_reload_list                (GList                   *file_list);
 void              thunar_file_reload_idle                (ThunarFile              *file);
 void              thunar_file_reload_idle_unref          (ThunarFile              *file);
 void              thunar_file_reload_parent              (ThunarFile              *file);
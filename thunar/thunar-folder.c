@@ -28,9 +28,16 @@
 #include <thunar/thunar-io-jobs.h>
 #include <thunar/thunar-job.h>
 #include <thunar/thunar-private.h>
+#include <thunar/thunar-search-index.h>
 
 #define DEBUG_FILE_CHANGES FALSE
 
+/* maximum number of recently used folders kept loaded and monitored */
+#define THUNAR_FOLDER_CACHE_MAX_FOLDERS (8)
+
+/* maximum number of files in the recently used folders */
+#define THUNAR_FOLDER_CACHE_MAX_FILES   (50000)
+
 
 
 /* property identifiers */
@@ -72,6 +79,11 @@ static gboolean thunar_folder_files_ready                 (ThunarJob
                                                            ThunarFolder           *folder);
 static void     thunar_folder_finished                    (ExoJob                 *job,
                                                            ThunarFolder           *folder);
+static gboolean thunar_folder_search_files_ready          (ThunarJob              *job,
+                                                           GList                  *files,
+                                                           ThunarFolder           *folder);
+static void     thunar_folder_search_finished             (ExoJob                 *job,
+                                                           ThunarFolder           *folder);
 static void     thunar_folder_file_changed                (ThunarFileMonitor      *file_monitor,
                                                            ThunarFile             *file,
                                                            ThunarFolder           *folder);
@@ -83,6 +95,10 @@ static void     thunar_folder_monitor                     (GFileMonitor
                                                            GFile                  *other_file,
                                                            GFileMonitorEvent       event_type,
                                                            gpointer                user_data);
+static void     thunar_folder_cache_remove                (ThunarFolder           *folder);
+static void     thunar_folder_cache_error                 (ThunarFolder           *folder,
+                                                           const GError           *error);
+static void     thunar_folder_cache_trim                  (void);
 
 
 
@@ -104,21 +120,25 @@ struct _ThunarFolder
 {
   GObject __parent__;
 
-  ThunarJob         *job;
+  ThunarJob            *job;
 
-  ThunarFile        *corresponding_file;
-  GList             *new_files;
-  GList             *files;
-  gboolean           reload_info;
+  ThunarFile           *corresponding_file;
+  GList                *new_files;
+  GList                *files;
+  guint                 n_files;
+  gboolean              reload_info;
 
-  GList             *content_type_ptr;
-  guint              content_type_idle_id;
+  GList                *content_type_ptr;
+  guint                 content_type_idle_id;
 
-  guint              in_destruction : 1;
+  guint                 in_destruction : 1;
 
-  ThunarFileMonitor *file_monitor;
+  ThunarFileMonitor    *file_monitor;
 
-  GFileMonitor      *monitor;
+  GFileMonitor         *monitor;
+
+  /* the criteria for a search folder, see thunar_folder_new_for_search() */
+  ThunarSearchCriteria *search;
 };
 
 
@@ -126,6 +146,12 @@ struct _ThunarFolder
 static guint  folder_signals[LAST_SIGNAL];
 static GQuark thunar_folder_quark;
 
+/* the recently used folders, most recent first. the cache holds a
+ * reference on the folders, so they stay loaded and monitored and
+ * going back to a folder does not have to list it again.
+ */
+static GQueue folder_cache = G_QUEUE_INIT;
+
 
 
 G_DEFINE_TYPE (ThunarFolder, thunar_folder, G_TYPE_OBJECT)
@@ -295,18 +321,24 @@ thunar_folder_finalize (GObject *object)
   if (G_UNLIKELY (folder->job != NULL))
     {
       g_signal_handlers_disconnect_matched (folder->job, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, folder);
+      if (folder->search != NULL)
+        exo_job_cancel (EXO_JOB (folder->job));
       g_object_unref (folder->job);
       folder->job = NULL;
     }
 
-  /* disconnect from the corresponding file */
+  /* disconnect from the corresponding file, search folders are not connected */
   if (G_LIKELY (folder->corresponding_file != NULL))
     {
       /* drop the reference */
-      g_object_set_qdata (G_OBJECT (folder->corresponding_file), thunar_folder_quark, NULL);
+      if (G_LIKELY (folder->search == NULL))
+        g_object_set_qdata (G_OBJECT (folder->corresponding_file), thunar_folder_quark, NULL);
       g_object_unref (G_OBJECT (folder->corresponding_file));
     }
 
+  /* release the search criteria */
+  thunar_search_criteria_free (folder->search);
+
   /* stop metadata collector */
   if (folder->content_type_idle_id != 0)
     g_source_remove (folder->content_type_idle_id);
@@ -494,6 +526,7 @@ thunar_folder_finished (ExoJob       *job,
 
             /* add to the internal files list */
             folder->files = g_list_prepend (folder->files, lp->data);
+            folder->n_files++;
             g_object_ref (G_OBJECT (lp->data));
           }
 
@@ -524,6 +557,7 @@ thunar_folder_finished (ExoJob       *job,
 
               /* remove from the internal files list */
               folder->files = g_list_remove (folder->files, file);
+              folder->n_files--;
             }
         }
 
@@ -545,6 +579,7 @@ thunar_folder_finished (ExoJob       *job,
     {
       /* just use the new files for the files list */
       folder->files = folder->new_files;
+      folder->n_files = g_list_length (folder->files);
       folder->new_files = NULL;
 
       if (folder->files != NULL)
@@ -557,8 +592,8 @@ thunar_folder_finished (ExoJob       *job,
   /* schedule a reload of the file information of all files if requested */
   if (folder->reload_info)
     {
-      for (lp = folder->files; lp != NULL; lp = lp->next)
-        thunar_file_reload (lp->data);
+      /* reload all files with a single enumeration of the folder */
+      thunar_file_reload_list (folder->files);
 
       /* reload folder information too */
       thunar_file_reload (folder->corresponding_file);
@@ -582,6 +617,53 @@ thunar_folder_finished (ExoJob       *job,
 
   /* tell the consumers that we have loaded the directory */
   g_object_notify (G_OBJECT (folder), "loading");
+
+  /* the folder may have grown past the cache limit, this can
+   * drop the last reference on the folder, so do it last */
+  thunar_folder_cache_trim ();
+}
+
+
+
+static gboolean
+thunar_folder_search_files_ready (ThunarJob    *job,
+                                  GList        *files,
+                                  ThunarFolder *folder)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_FOLDER (folder), FALSE);
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
+  _thunar_return_val_if_fail (folder->search != NULL, FALSE);
+
+  /* show the matches right away, the search may take a while */
+  g_signal_emit (G_OBJECT (folder), folder_signals[FILES_ADDED], 0, files);
+
+  /* take over the list of matches */
+  folder->n_files += g_list_length (files);
+  folder->files = g_list_concat (files, folder->files);
+
+  return TRUE;
+}
+
+
+
+static void
+thunar_folder_search_finished (ExoJob       *job,
+                               ThunarFolder *folder)
+{
+  _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
+  _thunar_return_if_fail (THUNAR_IS_JOB (job));
+  _thunar_return_if_fail (folder->content_type_idle_id == 0);
+
+  /* the search is done */
+  g_signal_handlers_disconnect_matched (folder->job, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, folder);
+  g_object_unref (folder->job);
+  folder->job = NULL;
+
+  /* restart the content type idle loader */
+  thunar_folder_content_type_loader (folder);
+
+  /* tell the consumers that we have searched the folder */
+  g_object_notify (G_OBJECT (folder), "loading");
 }
 
 
@@ -595,8 +677,9 @@ thunar_folder_file_changed (ThunarFileMonitor *file_monitor,
   _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
   _thunar_return_if_fail (THUNAR_IS_FILE_MONITOR (file_monitor));
 
-  /* check if the corresponding file changed... */
-  if (G_UNLIKELY (folder->corresponding_file == file))
+  /* check if the corresponding file changed, a search
+   * folder is not searched again for every change... */
+  if (G_UNLIKELY (folder->corresponding_file == file && folder->search == NULL))
     {
       /* ...and if so, reload the folder */
       thunar_folder_reload (folder, FALSE);
@@ -636,6 +719,7 @@ thunar_folder_file_destroyed (ThunarFileMonitor *file_monitor,
 
           /* remove the file from our list */
           folder->files = g_list_delete_link (folder->files, lp);
+          folder->n_files--;
 
           /* tell everybody that the file is gone */
           files.data = file; files.next = files.prev = NULL;
@@ -734,6 +818,12 @@ thunar_folder_monitor (GFileMonitor     *monitor,
   /* check on which file the event occurred */
   if (!g_file_equal (event_file, thunar_file_get_file (folder->corresponding_file)))
     {
+      /* let the file name index know about added and removed files */
+      if (event_type == G_FILE_MONITOR_EVENT_CREATED
+          || event_type == G_FILE_MONITOR_EVENT_DELETED
+          || event_type == G_FILE_MONITOR_EVENT_MOVED)
+        thunar_search_index_folder_changed (thunar_file_get_file (folder->corresponding_file));
+
       /* check if we already ship the file */
       for (lp = folder->files; lp != NULL; lp = lp->next)
         if (g_file_equal (event_file, thunar_file_get_file (lp->data)))
@@ -752,6 +842,7 @@ thunar_folder_monitor (GFileMonitor     *monitor,
             {
               /* prepend it to our internal list */
               folder->files = g_list_prepend (folder->files, file);
+              folder->n_files++;
 
               /* tell others about the new file */
               list.data = file; list.next = list.prev = NULL;
@@ -785,7 +876,7 @@ thunar_folder_monitor (GFileMonitor     *monitor,
                   file = thunar_file_get(other_file, NULL);
                   if (file != NULL && THUNAR_IS_FILE (file))
                     {
-                      thunar_file_reload (file);
+                      thunar_file_reload_idle (file);
 
                       /* if source and target folders are different, also tell
                          the target folder to reload for the changes */
@@ -796,7 +887,7 @@ thunar_folder_monitor (GFileMonitor     *monitor,
                               !g_file_equal (thunar_file_get_file(folder->corresponding_file),
                                              thunar_file_get_file(other_parent)))
                             {
-                              thunar_file_reload (other_parent);
+                              thunar_file_reload_idle (other_parent);
                               g_object_unref (other_parent);
                             }
                         }
@@ -807,20 +898,26 @@ thunar_folder_monitor (GFileMonitor     *monitor,
                 }
 
               /* reload the folder of the source file */
-              thunar_file_reload (folder->corresponding_file);
+              thunar_file_reload_idle (folder->corresponding_file);
             }
           else
             {
 #if DEBUG_FILE_CHANGES
               thunar_file_infos_equal (lp->data, event_file);
 #endif
-              thunar_file_reload (lp->data);
+              /* coalesce reloads of many changed files in this folder */
+              thunar_file_reload_idle (lp->data);
             }
         }
 
       /* check if we need to restart the collector */
       if (restart)
         thunar_folder_content_type_loader (folder);
+
+      /* check if the new file exceeds the cache limit, this
+       * can drop the last reference on the folder */
+      if (lp == NULL && event_type != G_FILE_MONITOR_EVENT_DELETED)
+        thunar_folder_cache_trim ();
     }
   else
     {
@@ -839,6 +936,60 @@ thunar_folder_monitor (GFileMonitor     *monitor,
 
 
 
+static void
+thunar_folder_cache_remove (ThunarFolder *folder)
+{
+  GList *lp;
+
+  _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
+
+  lp = g_queue_find (&folder_cache, folder);
+  if (G_LIKELY (lp != NULL))
+    {
+      g_queue_delete_link (&folder_cache, lp);
+
+      /* drop the reference of the cache */
+      g_signal_handlers_disconnect_by_func (G_OBJECT (folder), thunar_folder_cache_remove, NULL);
+      g_signal_handlers_disconnect_by_func (G_OBJECT (folder), thunar_folder_cache_error, NULL);
+      g_object_unref (G_OBJECT (folder));
+    }
+}
+
+
+
+static void
+thunar_folder_cache_error (ThunarFolder *folder,
+                           const GError *error)
+{
+  /* don't keep folders that failed to load */
+  thunar_folder_cache_remove (folder);
+}
+
+
+
+static void
+thunar_folder_cache_trim (void)
+{
+  GList *lp;
+  GList *lnext;
+  guint  n_folders;
+  guint  n_files;
+
+  /* drop the least recently used folders to limit the number
+   * of directory monitors and the memory of the cached files,
+   * but always keep the most recently used folder */
+  for (lp = folder_cache.head, n_folders = 0, n_files = 0; lp != NULL; lp = lnext)
+    {
+      lnext = lp->next;
+      n_files += THUNAR_FOLDER (lp->data)->n_files;
+      if (++n_folders > THUNAR_FOLDER_CACHE_MAX_FOLDERS
+          || (n_folders > 1 && n_files > THUNAR_FOLDER_CACHE_MAX_FILES))
+        thunar_folder_cache_remove (lp->data);
+    }
+}
+
+
+
 /**
  * thunar_folder_get_for_file:
  * @file : a #ThunarFile.
@@ -897,6 +1048,82 @@ thunar_folder_get_for_file (ThunarFile *file)
 
 
 
+/**
+ * thunar_folder_touch:
+ * @folder : a #ThunarFolder.
+ *
+ * Remembers @folder as recently used, so it stays loaded and
+ * monitored for a while after the user navigated away from it.
+ * Only to be used for folders the user opened in a view.
+ **/
+void
+thunar_folder_touch (ThunarFolder *folder)
+{
+  GList *lp;
+
+  _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
+  _thunar_return_if_fail (folder->search == NULL);
+
+  lp = g_queue_find (&folder_cache, folder);
+  if (G_LIKELY (lp != NULL))
+    {
+      /* move the folder to the front */
+      g_queue_unlink (&folder_cache, lp);
+      g_queue_push_head_link (&folder_cache, lp);
+    }
+  else
+    {
+      /* keep the folder alive while it's in the cache */
+      g_queue_push_head (&folder_cache, g_object_ref (G_OBJECT (folder)));
+      g_signal_connect (G_OBJECT (folder), "destroy", G_CALLBACK (thunar_folder_cache_remove), NULL);
+      g_signal_connect (G_OBJECT (folder), "error", G_CALLBACK (thunar_folder_cache_error), NULL);
+    }
+
+  thunar_folder_cache_trim ();
+}
+
+
+
+/**
+ * thunar_folder_new_for_search:
+ * @file     : a #ThunarFile referring to a directory.
+ * @criteria : the #ThunarSearchCriteria to search for.
+ *
+ * Allocates a #ThunarFolder whose files are the files
+ * below @file that match @criteria. The matches are added
+ * while the search runs, and the folder is "loading" until
+ * the search is done. thunar_folder_reload() searches again.
+ *
+ * Search folders are neither shared nor monitored, every
+ * call returns a new folder.
+ *
+ * The caller is responsible to free the returned object
+ * using g_object_unref() when no longer needed.
+ *
+ * Return value: the newly allocated #ThunarFolder.
+ **/
+ThunarFolder*
+thunar_folder_new_for_search (ThunarFile                 *file,
+                              const ThunarSearchCriteria *criteria)
+{
+  ThunarFolder *folder;
+
+  _thunar_return_val_if_fail (THUNAR_IS_FILE (file), NULL);
+  _thunar_return_val_if_fail (thunar_file_is_directory (file), NULL);
+  _thunar_return_val_if_fail (criteria != NULL, NULL);
+
+  /* allocate the new instance */
+  folder = g_object_new (THUNAR_TYPE_FOLDER, "corresponding-file", file, NULL);
+  folder->search = g_boxed_copy (THUNAR_TYPE_SEARCH_CRITERIA, criteria);
+
+  /* start the search */
+  thunar_folder_reload (folder, FALSE);
+
+  return folder;
+}
+
+
+
 /**
  * thunar_folder_get_corresponding_file:
  * @folder : a #ThunarFolder instance.
@@ -954,6 +1181,36 @@ thunar_folder_get_loading (const ThunarFolder *folder)
 
 
 
+/**
+ * thunar_folder_count_files:
+ * @file : a #ThunarFile referring to a directory.
+ *
+ * Returns the number of files in the folder for @file,
+ * if the folder is already open. The folder is not opened
+ * by this function.
+ *
+ * Return value: the number of files in the folder of
+ *               @file or -1 if not known.
+ **/
+gint
+thunar_folder_count_files (ThunarFile *file)
+{
+  ThunarFolder *folder;
+
+  _thunar_return_val_if_fail (THUNAR_IS_FILE (file), -1);
+
+  if (G_UNLIKELY (thunar_folder_quark == 0))
+    return -1;
+
+  folder = g_object_get_qdata (G_OBJECT (file), thunar_folder_quark);
+  if (folder == NULL)
+    return -1;
+
+  return folder->n_files;
+}
+
+
+
 /**
  * thunar_folder_reload:
  * @folder : a #ThunarFolder instance.
@@ -966,6 +1223,8 @@ void
 thunar_folder_reload (ThunarFolder *folder,
                       gboolean      reload_info)
 {
+  GList *files;
+
   _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
 
   /* reload file info too? */
@@ -980,6 +1239,10 @@ thunar_folder_reload (ThunarFolder *folder,
     {
       /* disconnect from the job */
       g_signal_handlers_disconnect_matched (folder->job, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, folder);
+
+      /* don't let a previous search continue in the background */
+      if (folder->search != NULL)
+        exo_job_cancel (EXO_JOB (folder->job));
       g_object_unref (folder->job);
       folder->job = NULL;
     }
@@ -997,11 +1260,33 @@ thunar_folder_reload (ThunarFolder *folder,
   thunar_g_file_list_free (folder->new_files);
   folder->new_files = NULL;
 
-  /* start a new job */
-  folder->job = thunar_io_jobs_list_directory (thunar_file_get_file (folder->corresponding_file));
-  g_signal_connect (folder->job, "error", G_CALLBACK (thunar_folder_error), folder);
-  g_signal_connect (folder->job, "finished", G_CALLBACK (thunar_folder_finished), folder);
-  g_signal_connect (folder->job, "files-ready", G_CALLBACK (thunar_folder_files_ready), folder);
+  if (G_UNLIKELY (folder->search != NULL))
+    {
+      /* the matches are added while the search runs, so drop the old ones */
+      files = folder->files;
+      folder->files = NULL;
+      folder->n_files = 0;
+      if (files != NULL)
+        {
+          g_signal_emit (G_OBJECT (folder), folder_signals[FILES_REMOVED], 0, files);
+          thunar_g_file_list_free (files);
+        }
+
+      /* start a new search */
+      folder->job = thunar_io_jobs_search_directory (thunar_file_get_file (folder->corresponding_file),
+                                                     folder->search);
+      g_signal_connect (folder->job, "error", G_CALLBACK (thunar_folder_error), folder);
+      g_signal_connect (folder->job, "finished", G_CALLBACK (thunar_folder_search_finished), folder);
+      g_signal_connect (folder->job, "files-ready", G_CALLBACK (thunar_folder_search_files_ready), folder);
+    }
+  else
+    {
+      /* start a new job */
+      folder->job = thunar_io_jobs_list_directory (thunar_file_get_file (folder->corresponding_file));
+      g_signal_connect (folder->job, "error", G_CALLBACK (thunar_folder_error), folder);
+      g_signal_connect (folder->job, "finished", G_CALLBACK (thunar_folder_finished), folder);
+      g_signal_connect (folder->job, "files-ready", G_CALLBACK (thunar_folder_files_ready), folder);
+    }
 
   /* tell all consumers that we're loading */
   g_object_notify (G_OBJECT (folder), "loading");
@@ -21,6 +21,7 @@
 #define __THUNAR_FOLDER_H__
 
 #include <thunar/thunar-file.h>
+#include <thunar/thunar-search-criteria.h>
 
 G_BEGIN_DECLS;
 
@@ -37,14 +38,20 @@ typedef struct _ThunarFolder      ThunarFolder;
 GType         thunar_folder_get_type               (void) G_GNUC_CONST;
 
 ThunarFolder *thunar_folder_get_for_file           (ThunarFile         *file);
+ThunarFolder *thunar_folder_new_for_search         (ThunarFile                 *file,
+                                                    const ThunarSearchCriteria *criteria);
 
 ThunarFile   *thunar_folder_get_corresponding_file (const ThunarFolder *folder);
 GList        *thunar_folder_get_files              (const ThunarFolder *folder);
 gboolean      thunar_folder_get_loading            (const ThunarFolder *folder);
 
+gint          thunar_folder_count_files            (ThunarFile         *file);
+
 void          thunar_folder_reload                 (ThunarFolder       *folder,
                                                     gboolean            reload_info);
 
+void          thunar_folder_touch                  (ThunarFolder       *folder);
+
 G_END_DECLS;
 
 #endif /* !__THUNAR_FOLDER_H__ */
@@ -40,6 +40,47 @@
 
 
 
+/* file queries on the main thread taking longer than this many
+ * microseconds are logged, they block the user interface */
+#define THUNAR_G_FILE_WATCHDOG (100 * 1000)
+
+
+
+static gint64
+thunar_g_file_watchdog_start (void)
+{
+  /* only time queries that block the main loop */
+  if (!g_main_context_is_owner (g_main_context_default ()))
+    return 0;
+
+  return g_get_monotonic_time ();
+}
+
+
+
+static void
+thunar_g_file_watchdog_stop (GFile       *file,
+                             const gchar *what,
+                             gint64       start_time)
+{
+  gint64 elapsed;
+  gchar *uri;
+
+  if (start_time == 0)
+    return;
+
+  elapsed = g_get_monotonic_time () - start_time;
+  if (G_UNLIKELY (elapsed > THUNAR_G_FILE_WATCHDOG))
+    {
+      uri = g_file_get_uri (file);
+      g_message ("Querying the %s of \"%s\" blocked the main thread for %" G_GINT64_FORMAT " ms",
+                 what, uri, elapsed / 1000);
+      g_free (uri);
+    }
+}
+
+
+
 GFile *
 thunar_g_file_new_for_home (void)
 {
@@ -131,6 +172,72 @@ thunar_g_file_is_home (GFile *file)
 
 
 
+/**
+ * thunar_g_file_query_info:
+ * @file        : a #GFile.
+ * @attributes  : the attributes to query.
+ * @flags       : #GFileQueryInfoFlags.
+ * @cancellable : a #GCancellable or %NULL.
+ * @error       : return location for errors or %NULL.
+ *
+ * Same as g_file_query_info(), but queries that block the
+ * main thread for a noticeable time are logged.
+ *
+ * Return value: a #GFileInfo or %NULL on error.
+ **/
+GFileInfo *
+thunar_g_file_query_info (GFile               *file,
+                          const gchar         *attributes,
+                          GFileQueryInfoFlags  flags,
+                          GCancellable        *cancellable,
+                          GError             **error)
+{
+  GFileInfo *info;
+  gint64     start_time;
+
+  _thunar_return_val_if_fail (G_IS_FILE (file), NULL);
+
+  start_time = thunar_g_file_watchdog_start ();
+  info = g_file_query_info (file, attributes, flags, cancellable, error);
+  thunar_g_file_watchdog_stop (file, "information", start_time);
+
+  return info;
+}
+
+
+
+/**
+ * thunar_g_file_query_filesystem_info:
+ * @file        : a #GFile.
+ * @attributes  : the attributes to query.
+ * @cancellable : a #GCancellable or %NULL.
+ * @error       : return location for errors or %NULL.
+ *
+ * Same as g_file_query_filesystem_info(), but queries that
+ * block the main thread for a noticeable time are logged.
+ *
+ * Return value: a #GFileInfo or %NULL on error.
+ **/
+GFileInfo *
+thunar_g_file_query_filesystem_info (GFile         *file,
+                                     const gchar   *attributes,
+                                     GCancellable  *cancellable,
+                                     GError       **error)
+{
+  GFileInfo *info;
+  gint64     start_time;
+
+  _thunar_return_val_if_fail (G_IS_FILE (file), NULL);
+
+  start_time = thunar_g_file_watchdog_start ();
+  info = g_file_query_filesystem_info (file, attributes, cancellable, error);
+  thunar_g_file_watchdog_stop (file, "file system information", start_time);
+
+  return info;
+}
+
+
+
 GKeyFile *
 thunar_g_file_query_key_file (GFile              *file,
                               GCancellable       *cancellable,
@@ -387,9 +494,9 @@ thunar_g_file_get_free_space (GFile   *file,
 
   _thunar_return_val_if_fail (G_IS_FILE (file), FALSE);
 
-  filesystem_info = g_file_query_filesystem_info (file,
-                                                  THUNARX_FILESYSTEM_INFO_NAMESPACE,
-                                                  NULL, NULL);
+  filesystem_info = thunar_g_file_query_filesystem_info (file,
+                                                         THUNARX_FILESYSTEM_INFO_NAMESPACE,
+                                                         NULL, NULL);
 
   if (filesystem_info != NULL)
     {
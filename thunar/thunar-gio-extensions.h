@@ -35,6 +35,16 @@ gboolean  thunar_g_file_is_root                  (GFile                *file);
 gboolean  thunar_g_file_is_trashed               (GFile                *file);
 gboolean  thunar_g_file_is_home                  (GFile                *file);
 
+GFileInfo *thunar_g_file_query_info            (GFile                *file,
+                                                 const gchar          *attributes,
+                                                 GFileQueryInfoFlags   flags,
+                                                 GCancellable         *cancellable,
+                                                 GError              **error);
+GFileInfo *thunar_g_file_query_filesystem_info (GFile                *file,
+                                                 const gchar          *attributes,
+                                                 GCancellable         *cancellable,
+                                                 GError              **error);
+
 GKeyFile *thunar_g_file_query_key_file           (GFile                *file,
                                                   GCancellable         *cancellable,
                                                   GError              **error);
@@ -57,8 +57,17 @@ static void            thunar_history_set_current_directory  (ThunarNavigator
                                                               ThunarFile           *current_directory);
 static void            thunar_history_go_back                (ThunarHistory        *history,
                                                               GFile                *goto_file);
+static void            thunar_history_go_back_ready          (GFile                *goto_file,
+                                                              ThunarFile           *directory,
+                                                              GError               *error,
+                                                              gpointer              user_data);
 static void            thunar_history_go_forward             (ThunarHistory        *history,
                                                               GFile                *goto_file);
+static void            thunar_history_go_forward_ready       (GFile                *goto_file,
+                                                              ThunarFile           *directory,
+                                                              GError               *error,
+                                                              gpointer              user_data);
+static void            thunar_history_cancel_load            (ThunarHistory        *history);
 static void            thunar_history_action_back            (GtkAction            *action,
                                                               ThunarHistory        *history);
 static void            thunar_history_action_back_nth        (GtkWidget            *item,
@@ -93,6 +102,9 @@ struct _ThunarHistory
 
   GSList         *back_list;
   GSList         *forward_list;
+
+  /* checking the directory to go back or forward to */
+  GCancellable   *load_cancellable;
 };
 
 
@@ -179,6 +191,9 @@ thunar_history_dispose (GObject *object)
 {
   ThunarHistory *history = THUNAR_HISTORY (object);
 
+  /* stop going back or forward */
+  thunar_history_cancel_load (history);
+
   /* disconnect from the current directory */
   thunar_navigator_set_current_directory (THUNAR_NAVIGATOR (history), NULL);
 
@@ -203,6 +218,8 @@ thunar_history_finalize (GObject *object)
   g_signal_handlers_disconnect_matched (G_OBJECT (history->action_back), G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, history);
   g_object_unref (G_OBJECT (history->action_back));
 
+  _thunar_assert (history->load_cancellable == NULL);
+
   /* release the "forward" and "back" lists */
   g_slist_free_full (history->forward_list, g_object_unref);
   g_slist_free_full (history->back_list, g_object_unref);
@@ -302,6 +319,9 @@ thunar_history_set_current_directory (ThunarNavigator *navigator,
   if (G_UNLIKELY (current_directory == history->current_directory))
     return;
 
+  /* a directory is opened elsewhere, so don't go back or forward anymore */
+  thunar_history_cancel_load (history);
+
   /* if the new directory is the first one in the forward history, we
    * just move forward one step instead of clearing the whole forward
    * history */
@@ -371,21 +391,56 @@ thunar_history_error_not_found (GFile    *goto_file,
 
 
 
+static void
+thunar_history_cancel_load (ThunarHistory *history)
+{
+  if (history->load_cancellable != NULL)
+    {
+      g_cancellable_cancel (history->load_cancellable);
+      g_object_unref (history->load_cancellable);
+      history->load_cancellable = NULL;
+    }
+}
+
+
+
 static void
 thunar_history_go_back (ThunarHistory  *history,
                         GFile          *goto_file)
 {
-  GFile      *gfile;
-  GSList     *lp;
-  GSList     *lnext;
-  ThunarFile *directory;
-
   _thunar_return_if_fail (THUNAR_IS_HISTORY (history));
   _thunar_return_if_fail (G_IS_FILE (goto_file));
 
+  /* check if the directory still exists, without blocking on slow mounts */
+  thunar_history_cancel_load (history);
+  history->load_cancellable = g_cancellable_new ();
+  thunar_file_get_async (goto_file, history->load_cancellable, thunar_history_go_back_ready, history);
+}
+
+
+
+static void
+thunar_history_go_back_ready (GFile      *goto_file,
+                              ThunarFile *directory,
+                              GError     *error,
+                              gpointer    user_data)
+{
+  ThunarHistory *history;
+  GFile         *gfile;
+  GSList        *lp;
+  GSList        *lnext;
+
+  /* going back or forward was cancelled, the history might be gone */
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    return;
+
+  history = THUNAR_HISTORY (user_data);
+
+  g_object_unref (history->load_cancellable);
+  history->load_cancellable = NULL;
+
   /* check if the directory still exists */
-  directory = thunar_file_get (goto_file, NULL);
-  if (directory == NULL || ! thunar_file_is_mounted (directory))
+  if (error != NULL || ! thunar_file_is_mounted (directory))
     {
       thunar_history_error_not_found (goto_file, NULL);
 
@@ -418,8 +473,7 @@ thunar_history_go_back (ThunarHistory  *history,
 
       if (g_file_equal (goto_file, G_FILE (lp->data)))
         {
-          if (directory != NULL)
-            history->current_directory = g_object_ref (directory);
+          history->current_directory = g_object_ref (directory);
 
           /* remove the new directory from the list */
           g_object_unref (lp->data);
@@ -436,9 +490,6 @@ thunar_history_go_back (ThunarHistory  *history,
       history->forward_list = lp;
     }
 
-  if (directory != NULL)
-    g_object_unref (directory);
-
   /* tell the other modules to change the current directory */
   if (G_LIKELY (history->current_directory != NULL))
     thunar_navigator_change_directory (THUNAR_NAVIGATOR (history), history->current_directory);
@@ -456,17 +507,39 @@ static void
 thunar_history_go_forward (ThunarHistory  *history,
                            GFile          *goto_file)
 {
-  GFile      *gfile;
-  GSList     *lnext;
-  GSList     *lp;
-  ThunarFile *directory;
-
   _thunar_return_if_fail (THUNAR_IS_HISTORY (history));
   _thunar_return_if_fail (G_IS_FILE (goto_file));
 
+  /* check if the directory still exists, without blocking on slow mounts */
+  thunar_history_cancel_load (history);
+  history->load_cancellable = g_cancellable_new ();
+  thunar_file_get_async (goto_file, history->load_cancellable, thunar_history_go_forward_ready, history);
+}
+
+
+
+static void
+thunar_history_go_forward_ready (GFile      *goto_file,
+                                 ThunarFile *directory,
+                                 GError     *error,
+                                 gpointer    user_data)
+{
+  ThunarHistory *history;
+  GFile         *gfile;
+  GSList        *lnext;
+  GSList        *lp;
+
+  /* going back or forward was cancelled, the history might be gone */
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    return;
+
+  history = THUNAR_HISTORY (user_data);
+
+  g_object_unref (history->load_cancellable);
+  history->load_cancellable = NULL;
+
   /* check if the directory still exists */
-  directory = thunar_file_get (goto_file, NULL);
-  if (directory == NULL || ! thunar_file_is_mounted (directory))
+  if (error != NULL || ! thunar_file_is_mounted (directory))
     {
       thunar_history_error_not_found (goto_file, NULL);
 
@@ -497,8 +570,7 @@ thunar_history_go_forward (ThunarHistory  *history,
 
       if (g_file_equal (goto_file, G_FILE (lp->data)))
         {
-          if (directory != NULL)
-            history->current_directory = g_object_ref (directory);
+          history->current_directory = g_object_ref (directory);
 
           /* remove the new dirctory from the list */
           g_object_unref (lp->data);
@@ -515,9 +587,6 @@ thunar_history_go_forward (ThunarHistory  *history,
       history->back_list = lp;
     }
 
-  if (directory != NULL)
-    g_object_unref (directory);
-
   /* tell the other modules to change the current directory */
   if (G_LIKELY (history->current_directory != NULL))
     thunar_navigator_change_directory (THUNAR_NAVIGATOR (history), history->current_directory);
@@ -792,11 +861,12 @@ thunar_history_copy (ThunarHistory  *history,
  * thunar_file_history_peek_back:
  * @history : a #ThunarHistory.
  *
- * Returns the previous directory in the history.
+ * Returns the previous directory in the history, if it is
+ * still loaded. This function does not block on the file system.
  *
  * The returned #ThunarFile must be released by the caller.
  *
- * Return value: the previous #ThunarFile in the history.
+ * Return value: the previous #ThunarFile in the history or %NULL.
  **/
 ThunarFile *
 thunar_history_peek_back (ThunarHistory *history)
@@ -807,7 +877,7 @@ thunar_history_peek_back (ThunarHistory *history)
 
   /* pick the first (conceptually the last) file in the back list, if there are any */
   if (history->back_list != NULL)
-    result = thunar_file_get (history->back_list->data, NULL);
+    result = thunar_file_cache_lookup (history->back_list->data);
 
   return result;
 }
@@ -818,12 +888,13 @@ thunar_history_peek_back (ThunarHistory *history)
  * thunar_file_history_peek_forward:
  * @history : a #ThunarHistory.
  *
- * Returns the next directory in the history. This often but not always
- * refers to a child of the current directory.
+ * Returns the next directory in the history, if it is still loaded.
+ * This often but not always refers to a child of the current directory.
+ * This function does not block on the file system.
  *
  * The returned #ThunarFile must be released by the caller.
  *
- * Return value: the next #ThunarFile in the history.
+ * Return value: the next #ThunarFile in the history or %NULL.
  **/
 ThunarFile *
 thunar_history_peek_forward (ThunarHistory *history)
@@ -834,7 +905,7 @@ thunar_history_peek_forward (ThunarHistory *history)
 
   /* pick the first file in the forward list, if there are any */
   if (history->forward_list != NULL)
-    result = thunar_file_get (history->forward_list->data, NULL);
+    result = thunar_file_cache_lookup (history->forward_list->data);
 
   return result;
 }
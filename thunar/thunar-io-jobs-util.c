@@ -32,12 +32,145 @@
 
 
 
+typedef struct
+{
+  /* the basenames in the directory, including the ones handed out */
+  GHashTable *names;
+
+  /* the last number handed out per duplicate name template */
+  GHashTable *hints;
+} ThunarIoJobsUtilSnapshot;
+
+
+
+static GQuark thunar_io_jobs_util_snapshots_quark = 0;
+
+
+
+static void
+thunar_io_jobs_util_snapshot_free (gpointer data)
+{
+  ThunarIoJobsUtilSnapshot *snapshot = data;
+
+  g_hash_table_destroy (snapshot->names);
+  g_hash_table_destroy (snapshot->hints);
+  g_slice_free (ThunarIoJobsUtilSnapshot, snapshot);
+}
+
+
+
+static ThunarIoJobsUtilSnapshot *
+thunar_io_jobs_util_get_snapshot (ThunarJob *job,
+                                  GFile     *parent_file)
+{
+  ThunarIoJobsUtilSnapshot *snapshot;
+  GFileEnumerator          *enumerator;
+  GHashTable               *snapshots;
+  GFileInfo                *info;
+
+  /* allocate the quark on-demand */
+  if (G_UNLIKELY (thunar_io_jobs_util_snapshots_quark == 0))
+    thunar_io_jobs_util_snapshots_quark = g_quark_from_static_string ("thunar-io-jobs-util-snapshots");
+
+  /* lookup the snapshots of this job */
+  snapshots = g_object_get_qdata (G_OBJECT (job), thunar_io_jobs_util_snapshots_quark);
+  if (G_UNLIKELY (snapshots == NULL))
+    {
+      snapshots = g_hash_table_new_full (g_file_hash, (GEqualFunc) g_file_equal,
+                                         g_object_unref, thunar_io_jobs_util_snapshot_free);
+      g_object_set_qdata_full (G_OBJECT (job), thunar_io_jobs_util_snapshots_quark,
+                               snapshots, (GDestroyNotify) g_hash_table_destroy);
+    }
+
+  /* check if the directory was already read for this job */
+  snapshot = g_hash_table_lookup (snapshots, parent_file);
+  if (G_LIKELY (snapshot != NULL))
+    return snapshot;
+
+  snapshot = g_slice_new (ThunarIoJobsUtilSnapshot);
+  snapshot->names = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  snapshot->hints = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  g_hash_table_insert (snapshots, g_object_ref (parent_file), snapshot);
+
+  /* collect the names in the directory, this only happens on the
+   * first collision in the directory. if that fails the snapshot
+   * stays empty and the callers catch the taken names on creation */
+  enumerator = g_file_enumerate_children (parent_file, G_FILE_ATTRIBUTE_STANDARD_NAME,
+                                          G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                          exo_job_get_cancellable (EXO_JOB (job)), NULL);
+  if (G_LIKELY (enumerator != NULL))
+    {
+      while ((info = g_file_enumerator_next_file (enumerator, exo_job_get_cancellable (EXO_JOB (job)), NULL)) != NULL)
+        {
+          g_hash_table_insert (snapshot->names, g_strdup (g_file_info_get_name (info)), GUINT_TO_POINTER (1));
+          g_object_unref (info);
+        }
+
+      g_object_unref (enumerator);
+    }
+
+  return snapshot;
+}
+
+
+
+static gchar *
+thunar_io_jobs_util_duplicate_name (GFileInfo *info,
+                                    gboolean   copy,
+                                    guint      n)
+{
+  const gchar *old_display_name;
+  gchar       *display_name;
+  gchar       *file_basename;
+  gchar       *dot = NULL;
+
+  old_display_name = g_file_info_get_display_name (info);
+  if (copy)
+    {
+      /* get file extension if file is not a directory */
+      if (g_file_info_get_file_type (info) != G_FILE_TYPE_DIRECTORY)
+        dot = thunar_util_str_get_extension (old_display_name);
+
+      if (dot != NULL)
+        {
+          file_basename = g_strndup (old_display_name, dot - old_display_name);
+          /* I18N: put " (copy #) between basename and extension */
+          display_name = g_strdup_printf (_("%s (copy %u)%s"), file_basename, n, dot);
+          g_free(file_basename);
+        }
+      else
+        {
+          /* I18N: put " (copy #)" after filename (for files without extension) */
+          display_name = g_strdup_printf (_("%s (copy %u)"), old_display_name, n);
+        }
+    }
+  else
+    {
+      /* create name for link */
+      if (n == 1)
+        {
+          /* I18N: name for first link to basename */
+          display_name = g_strdup_printf (_("link to %s"), old_display_name);
+        }
+      else
+        {
+          /* I18N: name for nth link to basename */
+          display_name = g_strdup_printf (_("link %u to %s"), n, old_display_name);
+        }
+    }
+
+  return display_name;
+}
+
+
+
 /**
  * thunar_io_jobs_util_next_duplicate_file:
  * @job   : a #ThunarJob.
  * @file  : the source #GFile.
  * @type  : the operation type (copy or link).
- * @n     : the @n<!---->th copy/link to create the #GFile for.
+ * @n     : the @n<!---->th copy/link to start from, set to the
+ *          number of the returned copy/link.
  * @error : return location for errors or %NULL.
  *
  * Determines the #GFile for the next copy/link of/to @file.
@@ -47,6 +180,14 @@
  * Links follow have a bit different scheme, since the first link
  * is renamed to "link to #" and after that "link Y to X".
  *
+ * The names in the target directory are read once per @job, on
+ * the first duplicate in that directory, so numbers already in
+ * use are skipped without touching the file system, and the last
+ * number handed out per name is remembered. If the returned file
+ * exists anyway, because the directory changed in the meantime,
+ * creating it fails with %G_IO_ERROR_EXISTS and the caller retries
+ * with @n + 1.
+ *
  * If there are errors or the job was cancelled, the return value
  * will be %NULL and @error will be set.
  *
@@ -57,21 +198,21 @@ GFile *
 thunar_io_jobs_util_next_duplicate_file (ThunarJob *job,
                                          GFile     *file,
                                          gboolean   copy,
-                                         guint      n,
+                                         guint     *n,
                                          GError   **error)
 {
-  GFileInfo   *info;
-  GError      *err = NULL;
-  GFile       *duplicate_file = NULL;
-  GFile       *parent_file = NULL;
-  const gchar *old_display_name;
-  gchar       *display_name;
-  gchar       *file_basename;
-  gchar       *dot = NULL;
+  ThunarIoJobsUtilSnapshot *snapshot;
+  GFileInfo                *info;
+  GError                   *err = NULL;
+  GFile                    *duplicate_file = NULL;
+  GFile                    *parent_file = NULL;
+  gchar                    *display_name;
+  gchar                    *hint_key;
+  guint                     hint;
   
   _thunar_return_val_if_fail (THUNAR_IS_JOB (job), NULL);
   _thunar_return_val_if_fail (G_IS_FILE (file), NULL);
-  _thunar_return_val_if_fail (0 < n, NULL);
+  _thunar_return_val_if_fail (n != NULL && 0 < *n, NULL);
   _thunar_return_val_if_fail (error == NULL || *error == NULL, NULL);
   _thunar_return_val_if_fail (!thunar_g_file_is_root (file), NULL);
 
@@ -92,52 +233,42 @@ thunar_io_jobs_util_next_duplicate_file (ThunarJob *job,
       return NULL;
     }
 
-  old_display_name = g_file_info_get_display_name (info);
-  if (copy)
-    {
-      /* get file extension if file is not a directory */
-      if (g_file_info_get_file_type (info) != G_FILE_TYPE_DIRECTORY)
-        dot = thunar_util_str_get_extension (old_display_name);
+  /* get the names in the target directory */
+  parent_file = g_file_get_parent (file);
+  snapshot = thunar_io_jobs_util_get_snapshot (job, parent_file);
 
-      if (dot != NULL)
-        {
-          file_basename = g_strndup (old_display_name, dot - old_display_name);
-          /* I18N: put " (copy #) between basename and extension */
-          display_name = g_strdup_printf (_("%s (copy %u)%s"), file_basename, n, dot);
-          g_free(file_basename);
-        }
-      else
-        {
-          /* I18N: put " (copy #)" after filename (for files without extension) */
-          display_name = g_strdup_printf (_("%s (copy %u)"), old_display_name, n);
-        }
+  /* abort if reading the directory was cancelled */
+  if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
+    {
+      g_object_unref (parent_file);
+      g_object_unref (info);
+      return NULL;
     }
-  else
+
+  /* all numbers up to the last one handed out for this name are taken */
+  hint_key = g_strdup_printf ("%c%s", copy ? 'c' : 'l', g_file_info_get_display_name (info));
+  hint = GPOINTER_TO_UINT (g_hash_table_lookup (snapshot->hints, hint_key));
+  if (*n <= hint)
+    *n = hint + 1;
+
+  /* skip the numbers whose name is in the directory */
+  for (;; ++*n)
     {
-      /* create name for link */
-      if (n == 1)
-        {
-          /* I18N: name for first link to basename */
-          display_name = g_strdup_printf (_("link to %s"), old_display_name);
-        }
-      else
-        {
-          /* I18N: name for nth link to basename */
-          display_name = g_strdup_printf (_("link %u to %s"), n, old_display_name);
-        }
+      display_name = thunar_io_jobs_util_duplicate_name (info, copy, *n);
+      if (g_hash_table_lookup (snapshot->names, display_name) == NULL)
+        break;
+      g_free (display_name);
     }
 
-  /* create the GFile for the copy/link */
-  parent_file = g_file_get_parent (file);
   duplicate_file = g_file_get_child (parent_file, display_name);
   g_object_unref (parent_file);
 
+  /* the name is taken once the caller tried it, no matter the outcome */
+  g_hash_table_insert (snapshot->names, display_name, GUINT_TO_POINTER (1));
+  g_hash_table_insert (snapshot->hints, hint_key, GUINT_TO_POINTER (*n));
+
   /* free resources */
   g_object_unref (info);
-  g_free (display_name);
 
   return duplicate_file;
 }
-
-
-
@@ -28,7 +28,7 @@ G_BEGIN_DECLS
 GFile *thunar_io_jobs_util_next_duplicate_file (ThunarJob *job,
                                                 GFile     *file,
                                                 gboolean   copy,
-                                                guint      n,
+                                                guint     *n,
                                                 GError   **error) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
 
 G_END_DECLS
@@ -22,7 +22,30 @@
 #include <config.h>
 #endif
 
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+#ifdef HAVE_DIRENT_H
+#include <dirent.h>
+#endif
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
 #include <gio/gio.h>
+#include <glib/gstdio.h>
 
 #include <thunar/thunar-application.h>
 #include <thunar/thunar-enum-types.h>
@@ -32,12 +55,30 @@
 #include <thunar/thunar-io-jobs-util.h>
 #include <thunar/thunar-job.h>
 #include <thunar/thunar-private.h>
+#include <thunar/thunar-search-index.h>
 #include <thunar/thunar-simple-job.h>
 #include <thunar/thunar-thumbnail-cache.h>
 #include <thunar/thunar-transfer-job.h>
 
 
 
+/* the fd relative syscalls used to change native files in place */
+#if defined (HAVE_FCHMODAT) && defined (HAVE_FCHOWNAT) && defined (HAVE_FDOPENDIR) \
+ && defined (HAVE_FSTATAT) && defined (HAVE_OPENAT) && defined (HAVE_DIRENT_H)
+#define TIJ_HAVE_AT_FUNCS 1
+#endif
+
+/* interval between two progress updates of the native walker */
+#define TIJ_CHANGE_UPDATE_INTERVAL (G_USEC_PER_SEC / 10)
+
+/* directory levels the native walker keeps a descriptor open for */
+#define TIJ_CHANGE_MAX_OPEN_DEPTH (64)
+
+/* interval between two batches of search results */
+#define TIJ_SEARCH_REPORT_INTERVAL (G_USEC_PER_SEC / 5)
+
+
+
 static GList *
 _tij_collect_nofollow (ThunarJob *job,
                        GList     *base_file_list,
@@ -576,7 +617,7 @@ _thunar_io_jobs_link_file (ThunarJob *job,
   gchar            *base_name;
   gchar            *display_name;
   gchar            *source_path;
-  gint              n;
+  guint             n;
 
   _thunar_return_val_if_fail (THUNAR_IS_JOB (job), NULL);
   _thunar_return_val_if_fail (G_IS_FILE (source_file), NULL);
@@ -623,7 +664,7 @@ _thunar_io_jobs_link_file (ThunarJob *job,
             {
               GFile *duplicate_file = thunar_io_jobs_util_next_duplicate_file (job,
                                                                                source_file,
-                                                                               FALSE, n,
+                                                                               FALSE, &n,
                                                                                &err);
 
               if (err == NULL)
@@ -789,6 +830,248 @@ thunar_io_jobs_link_files (GList *source_file_list,
 
 
 
+typedef struct
+{
+  /* the device the trash directory belongs to */
+  dev_t  device;
+
+  /* the mount point for a $topdir trash, NULL for the home trash */
+  gchar *topdir;
+
+  /* the "files" and "info" directories of the trash, NULL if the
+   * device has no usable trash, so gio decides what to do */
+  gchar *files_dir;
+  gchar *info_dir;
+} TijTrashDir;
+
+
+
+static void
+_tij_trash_dir_free (TijTrashDir *trash_dir)
+{
+  g_free (trash_dir->topdir);
+  g_free (trash_dir->files_dir);
+  g_free (trash_dir->info_dir);
+  g_slice_free (TijTrashDir, trash_dir);
+}
+
+
+
+static gboolean
+_tij_trash_dir_setup (TijTrashDir *trash_dir,
+                      const gchar *path)
+{
+  struct stat statb;
+
+  trash_dir->files_dir = g_build_filename (path, "files", NULL);
+  trash_dir->info_dir = g_build_filename (path, "info", NULL);
+
+  /* make sure both directories exist on the trash device */
+  if (g_mkdir_with_parents (trash_dir->files_dir, 0700) == 0
+      && g_mkdir_with_parents (trash_dir->info_dir, 0700) == 0
+      && lstat (trash_dir->files_dir, &statb) == 0
+      && S_ISDIR (statb.st_mode)
+      && statb.st_dev == trash_dir->device)
+    return TRUE;
+
+  g_free (trash_dir->files_dir);
+  g_free (trash_dir->info_dir);
+  trash_dir->files_dir = NULL;
+  trash_dir->info_dir = NULL;
+
+  return FALSE;
+}
+
+
+
+static TijTrashDir *
+_tij_trash_dir_lookup (GSList     **trash_dirs,
+                       const gchar *path,
+                       dev_t        device)
+{
+  struct stat  statb;
+  TijTrashDir *trash_dir;
+  GSList      *lp;
+  gchar       *parent;
+  gchar       *dir;
+
+  /* the home trash is resolved first, so it's preferred for its device */
+  if (*trash_dirs == NULL)
+    {
+      dir = g_build_filename (g_get_user_data_dir (), "Trash", NULL);
+      if (g_mkdir_with_parents (dir, 0700) == 0 && stat (dir, &statb) == 0)
+        {
+          trash_dir = g_slice_new0 (TijTrashDir);
+          trash_dir->device = statb.st_dev;
+          _tij_trash_dir_setup (trash_dir, dir);
+          *trash_dirs = g_slist_prepend (*trash_dirs, trash_dir);
+        }
+      g_free (dir);
+    }
+
+  /* check if the trash of this device was resolved already */
+  for (lp = *trash_dirs; lp != NULL; lp = lp->next)
+    if (((TijTrashDir *) lp->data)->device == device)
+      return lp->data;
+
+  trash_dir = g_slice_new0 (TijTrashDir);
+  trash_dir->device = device;
+  *trash_dirs = g_slist_prepend (*trash_dirs, trash_dir);
+
+  /* determine the mount point of the device */
+  trash_dir->topdir = g_path_get_dirname (path);
+  while (strcmp (trash_dir->topdir, G_DIR_SEPARATOR_S) != 0)
+    {
+      parent = g_path_get_dirname (trash_dir->topdir);
+      if (stat (parent, &statb) < 0 || statb.st_dev != device)
+        {
+          g_free (parent);
+          break;
+        }
+      g_free (trash_dir->topdir);
+      trash_dir->topdir = parent;
+    }
+
+  /* prefer $topdir/.Trash/$uid if the administrator set up a shared trash */
+  dir = g_build_filename (trash_dir->topdir, ".Trash", NULL);
+  if (lstat (dir, &statb) == 0 && S_ISDIR (statb.st_mode) && (statb.st_mode & S_ISVTX) != 0)
+    {
+      parent = dir;
+      dir = g_strdup_printf ("%s/%u", parent, (guint) getuid ());
+      g_free (parent);
+
+      if (_tij_trash_dir_setup (trash_dir, dir))
+        {
+          g_free (dir);
+          return trash_dir;
+        }
+    }
+  g_free (dir);
+
+  /* use $topdir/.Trash-$uid otherwise, it must be a real directory owned by us */
+  dir = g_strdup_printf ("%s/.Trash-%u", trash_dir->topdir, (guint) getuid ());
+  if ((mkdir (dir, 0700) == 0 || errno == EEXIST)
+      && lstat (dir, &statb) == 0
+      && S_ISDIR (statb.st_mode)
+      && statb.st_uid == getuid ())
+    _tij_trash_dir_setup (trash_dir, dir);
+  g_free (dir);
+
+  return trash_dir;
+}
+
+
+
+static gint
+_tij_trash_file (TijTrashDir *trash_dir,
+                 const gchar *path,
+                 const gchar *deletion_date)
+{
+  struct stat  statb;
+  const gchar *relative_path = path;
+  gchar       *basename;
+  gchar       *name;
+  gchar       *info_path;
+  gchar       *files_path;
+  gchar       *escaped_path;
+  gchar       *contents;
+  gsize        length;
+  gsize        offset;
+  gssize       n;
+  guint        i;
+  gint         errsv = 0;
+  gint         fd;
+
+  /* paths in a $topdir trash are relative to the mount point */
+  if (trash_dir->topdir != NULL)
+    {
+      relative_path = path + strlen (trash_dir->topdir);
+      while (*relative_path == G_DIR_SEPARATOR)
+        ++relative_path;
+    }
+
+  /* the info file is written first, the spec says the trash
+   * implementation has to ignore info files without a file */
+  escaped_path = g_uri_escape_string (relative_path, "/", FALSE);
+  contents = g_strdup_printf ("[Trash Info]\nPath=%s\nDeletionDate=%s\n", escaped_path, deletion_date);
+  length = strlen (contents);
+  g_free (escaped_path);
+
+  /* find a name that's unused in the trash */
+  basename = g_path_get_basename (path);
+  for (i = 1, fd = -1; fd < 0; ++i)
+    {
+      name = (i == 1) ? g_strdup (basename) : g_strdup_printf ("%s.%u", basename, i);
+      info_path = g_strconcat (trash_dir->info_dir, G_DIR_SEPARATOR_S, name, ".trashinfo", NULL);
+      files_path = g_build_filename (trash_dir->files_dir, name, NULL);
+      g_free (name);
+
+      fd = open (info_path, O_CREAT | O_EXCL | O_WRONLY, 0600);
+      if (G_LIKELY (fd >= 0))
+        {
+          /* rename() would replace a stale entry in the files directory */
+          if (lstat (files_path, &statb) == 0)
+            {
+              close (fd);
+              fd = -1;
+              g_unlink (info_path);
+            }
+        }
+      else if (errno != EEXIST)
+        {
+          errsv = errno;
+        }
+
+      if (fd < 0)
+        {
+          g_free (info_path);
+          g_free (files_path);
+
+          if (errsv != 0)
+            break;
+        }
+    }
+  g_free (basename);
+
+  if (G_LIKELY (fd >= 0))
+    {
+      /* write the info file */
+      for (offset = 0; offset < length; offset += n)
+        {
+          n = write (fd, contents + offset, length - offset);
+          if (G_UNLIKELY (n < 0))
+            {
+              if (errno != EINTR)
+                {
+                  errsv = errno;
+                  break;
+                }
+              n = 0;
+            }
+        }
+
+      if (close (fd) < 0 && errsv == 0)
+        errsv = errno;
+
+      /* move the file into the trash */
+      if (errsv == 0 && rename (path, files_path) < 0)
+        errsv = errno;
+
+      /* drop the info file again if that failed */
+      if (G_UNLIKELY (errsv != 0))
+        g_unlink (info_path);
+
+      g_free (info_path);
+      g_free (files_path);
+    }
+
+  g_free (contents);
+
+  return errsv;
+}
+
+
+
 static gboolean
 _thunar_io_jobs_trash (ThunarJob  *job,
                        GArray     *param_values,
@@ -796,9 +1079,19 @@ _thunar_io_jobs_trash (ThunarJob  *job,
 {
   ThunarThumbnailCache *thumbnail_cache;
   ThunarApplication    *application;
+  ThunarJobResponse     response;
+  struct stat           statb;
+  TijTrashDir          *trash_dir;
+  GDateTime            *date_time;
   GError               *err = NULL;
+  GSList               *trash_dirs = NULL;
   GList                *file_list;
+  GList                *trashed_list = NULL;
   GList                *lp;
+  gchar                *deletion_date;
+  gchar                *display_name;
+  gchar                *path;
+  gint                  errsv;
 
   _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
   _thunar_return_val_if_fail (param_values != NULL, FALSE);
@@ -810,24 +1103,82 @@ _thunar_io_jobs_trash (ThunarJob  *job,
   if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
     return FALSE;
 
-  /* take a reference on the thumbnail cache */
-  application = thunar_application_get ();
-  thumbnail_cache = thunar_application_get_thumbnail_cache (application);
-  g_object_unref (application);
+  /* we know the total list of files to process */
+  thunar_job_set_total_files (THUNAR_JOB (job), file_list);
 
-  for (lp = file_list; err == NULL && lp != NULL; lp = lp->next)
+  /* all files of this job share the deletion date */
+  date_time = g_date_time_new_now_local ();
+  deletion_date = g_date_time_format (date_time, "%Y-%m-%dT%H:%M:%S");
+  g_date_time_unref (date_time);
+
+  for (lp = file_list;
+       err == NULL && lp != NULL && !exo_job_is_cancelled (EXO_JOB (job));
+       lp = lp->next)
     {
       _thunar_assert (G_IS_FILE (lp->data));
 
-      /* trash the file or folder */
-      g_file_trash (lp->data, exo_job_get_cancellable (EXO_JOB (job)), &err);
+      /* update progress information */
+      thunar_job_processing_file (THUNAR_JOB (job), lp);
+
+      path = g_file_get_path (lp->data);
+
+retry_trash:
+      /* move local files into the trash of their device directly, the
+       * trash directories are only resolved once per device */
+      errsv = EXDEV;
+      if (G_LIKELY (path != NULL) && lstat (path, &statb) == 0)
+        {
+          trash_dir = _tij_trash_dir_lookup (&trash_dirs, path, statb.st_dev);
+          if (G_LIKELY (trash_dir->files_dir != NULL))
+            errsv = _tij_trash_file (trash_dir, path, deletion_date);
+        }
+
+      /* let gio handle everything else */
+      if (errsv == EXDEV)
+        g_file_trash (lp->data, exo_job_get_cancellable (EXO_JOB (job)), &err);
+      else if (G_UNLIKELY (errsv != 0))
+        g_set_error_literal (&err, G_IO_ERROR, g_io_error_from_errno (errsv), g_strerror (errsv));
+
+      if (G_LIKELY (err == NULL))
+        {
+          /* remember the file for the thumbnail cache */
+          trashed_list = g_list_prepend (trashed_list, lp->data);
+        }
+      else if (!exo_job_is_cancelled (EXO_JOB (job)))
+        {
+          /* ask the user whether to skip/retry this file */
+          display_name = thunar_g_file_get_display_name (lp->data);
+          response = thunar_job_ask_skip (job, _("Failed to move \"%s\" to the trash: %s"),
+                                          display_name, err->message);
+          g_free (display_name);
+
+          /* clear the error */
+          g_clear_error (&err);
 
-      /* update the thumbnail cache */
-      thunar_thumbnail_cache_cleanup_file (thumbnail_cache, lp->data);
+          /* check whether to retry */
+          if (response == THUNAR_JOB_RESPONSE_RETRY)
+            goto retry_trash;
+        }
+
+      g_free (path);
     }
 
-  /* release the thumbnail cache */
+  /* update the thumbnail cache */
+  application = thunar_application_get ();
+  thumbnail_cache = thunar_application_get_thumbnail_cache (application);
+  thunar_thumbnail_cache_cleanup_files (thumbnail_cache, trashed_list);
   g_object_unref (thumbnail_cache);
+  g_object_unref (application);
+
+  /* cleanup */
+  g_list_free (trashed_list);
+  g_slist_foreach (trash_dirs, (GFunc) _tij_trash_dir_free, NULL);
+  g_slist_free (trash_dirs);
+  g_free (deletion_date);
+
+  /* propagate the cancellation, if the user aborted */
+  if (err == NULL)
+    exo_job_set_error_if_cancelled (EXO_JOB (job), &err);
 
   if (err != NULL)
     {
@@ -871,6 +1222,250 @@ thunar_io_jobs_restore_files (GList *source_file_list,
 
 
 
+#ifdef TIJ_HAVE_AT_FUNCS
+typedef struct
+{
+  ThunarJob     *job;
+
+  /* the new owner and group, -1 to keep them */
+  gint           uid;
+  gint           gid;
+
+  /* the permission changes, if mode is set */
+  gboolean       mode;
+  ThunarFileMode dir_mask;
+  ThunarFileMode dir_mode;
+  ThunarFileMode file_mask;
+  ThunarFileMode file_mode;
+
+  /* progress information */
+  guint          n_processed;
+  gint64         last_update;
+} TijChange;
+
+
+
+static gboolean
+_tij_change_ask_skip (TijChange   *change,
+                      const gchar *path,
+                      gint         errsv,
+                      GError     **error)
+{
+  ThunarJobResponse response;
+  const gchar      *message;
+  gchar            *display_name;
+
+  /* errors are fatal once the job was cancelled */
+  if (exo_job_set_error_if_cancelled (EXO_JOB (change->job), error))
+    return FALSE;
+
+  /* generate a useful error message */
+  if (change->mode)
+    message = _("Failed to change the permissions of \"%s\": %s");
+  else if (change->uid >= 0)
+    message = _("Failed to change the owner of \"%s\": %s");
+  else
+    message = _("Failed to change the group of \"%s\": %s");
+
+  /* ask the user whether to skip/retry this file */
+  display_name = g_filename_display_name (path);
+  response = thunar_job_ask_skip (change->job, message, display_name, g_strerror (errsv));
+  g_free (display_name);
+
+  /* propagate the cancellation, if the user aborted */
+  exo_job_set_error_if_cancelled (EXO_JOB (change->job), error);
+
+  return (response == THUNAR_JOB_RESPONSE_RETRY);
+}
+
+
+
+static void
+_tij_change_apply (TijChange         *change,
+                   gint               parent_fd,
+                   const gchar       *name,
+                   const gchar       *path,
+                   const struct stat *statb,
+                   mode_t             new_mode,
+                   GError           **error)
+{
+  if (change->mode)
+    {
+      /* symlinks don't have permissions of their own, and
+       * there's nothing to do if the mode already matches */
+      if (S_ISLNK (statb->st_mode) || (statb->st_mode & 07777) == new_mode)
+        return;
+
+      while (fchmodat (parent_fd, name, new_mode, 0) < 0)
+        if (!_tij_change_ask_skip (change, path, errno, error))
+          break;
+    }
+  else
+    {
+      /* there's nothing to do if the owner or group already matches */
+      if ((change->uid < 0 || statb->st_uid == (uid_t) change->uid)
+          && (change->gid < 0 || statb->st_gid == (gid_t) change->gid))
+        return;
+
+      /* change the owner or group of the file or symlink itself */
+      while (fchownat (parent_fd, name, change->uid, change->gid, AT_SYMLINK_NOFOLLOW) < 0)
+        if (!_tij_change_ask_skip (change, path, errno, error))
+          break;
+    }
+}
+
+
+
+static void
+_tij_change_at (TijChange   *change,
+                gint         parent_fd,
+                const gchar *name,
+                const gchar *path,
+                gboolean     recursive,
+                guint        depth,
+                GError     **error)
+{
+  struct dirent *dp;
+  struct stat    statb;
+  gboolean       is_dir;
+  gboolean       after;
+  mode_t         new_mode = 0;
+  gint64         now;
+  GSList        *names = NULL;
+  GSList        *lp;
+  gchar         *child_path;
+  gchar         *display_name;
+  DIR           *dirp = NULL;
+  gint           child_fd;
+  gint           fd;
+
+  /* abort on cancellation */
+  if (exo_job_set_error_if_cancelled (EXO_JOB (change->job), error))
+    return;
+
+  /* update the progress information from time to time */
+  now = g_get_monotonic_time ();
+  if (now - change->last_update >= TIJ_CHANGE_UPDATE_INTERVAL)
+    {
+      display_name = g_filename_display_name (path);
+      exo_job_info_message (EXO_JOB (change->job),
+                            ngettext ("%u file processed, %s",
+                                      "%u files processed, %s",
+                                      change->n_processed),
+                            change->n_processed, display_name);
+      g_free (display_name);
+      change->last_update = now;
+    }
+
+  /* determine the current mode and owner, without following symlinks */
+  while (fstatat (parent_fd, name, &statb, AT_SYMLINK_NOFOLLOW) < 0)
+    if (!_tij_change_ask_skip (change, path, errno, error))
+      return;
+
+  change->n_processed += 1;
+
+  /* determine the new mode */
+  is_dir = S_ISDIR (statb.st_mode);
+  if (change->mode && is_dir)
+    new_mode = ((statb.st_mode & ~change->dir_mask) | change->dir_mode) & 07777;
+  else if (change->mode)
+    new_mode = ((statb.st_mode & ~change->file_mask) | change->file_mode) & 07777;
+
+  /* directories are changed before their contents, so they can be
+   * opened, unless that removes permissions; then they're changed last */
+  after = (is_dir && recursive && change->mode && (statb.st_mode & 07777 & ~new_mode) != 0);
+  if (!after)
+    _tij_change_apply (change, parent_fd, name, path, &statb, new_mode, error);
+
+  if (is_dir && recursive && *error == NULL)
+    {
+      /* open the directory, without following symlinks */
+      for (;;)
+        {
+          fd = openat (parent_fd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW);
+          if (fd >= 0)
+            {
+              dirp = fdopendir (fd);
+              if (G_LIKELY (dirp != NULL))
+                break;
+              close (fd);
+            }
+
+          if (!_tij_change_ask_skip (change, path, errno, error))
+            break;
+        }
+
+      /* change the contents of the directory */
+      if (G_LIKELY (dirp != NULL))
+        {
+          /* read the names first, so the directory is not changed while it is read */
+          while ((dp = readdir (dirp)) != NULL)
+            if (strcmp (dp->d_name, ".") != 0 && strcmp (dp->d_name, "..") != 0)
+              names = g_slist_prepend (names, g_strdup (dp->d_name));
+
+          /* every level below keeps its directory open, so deep trees
+           * would run out of descriptors; address the children of the
+           * deeper levels by their path instead */
+          if (G_UNLIKELY (depth >= TIJ_CHANGE_MAX_OPEN_DEPTH))
+            {
+              closedir (dirp);
+              dirp = NULL;
+              child_fd = AT_FDCWD;
+            }
+          else
+            {
+              child_fd = dirfd (dirp);
+            }
+
+          for (lp = names; lp != NULL && *error == NULL; lp = lp->next)
+            {
+              child_path = g_build_filename (path, lp->data, NULL);
+              _tij_change_at (change, child_fd, (child_fd == AT_FDCWD) ? child_path : lp->data,
+                              child_path, TRUE, depth + 1, error);
+              g_free (child_path);
+            }
+
+          g_slist_free_full (names, g_free);
+
+          if (dirp != NULL)
+            closedir (dirp);
+        }
+    }
+
+  if (after && *error == NULL)
+    _tij_change_apply (change, parent_fd, name, path, &statb, new_mode, error);
+}
+
+
+
+static GList *
+_tij_change_native (TijChange *change,
+                    GList     *file_list,
+                    gboolean   recursive,
+                    GError   **error)
+{
+  GList *remaining = NULL;
+  GList *lp;
+  gchar *path;
+
+  /* change the local files in place, without collecting them first */
+  for (lp = file_list; lp != NULL && *error == NULL; lp = lp->next)
+    {
+      path = g_file_get_path (lp->data);
+      if (G_LIKELY (path != NULL))
+        _tij_change_at (change, AT_FDCWD, path, path, recursive, 0, error);
+      else
+        remaining = thunar_g_file_list_prepend (remaining, lp->data);
+      g_free (path);
+    }
+
+  /* the other files are changed using gio */
+  return g_list_reverse (remaining);
+}
+#endif
+
+
+
 static gboolean
 _thunar_io_jobs_chown (ThunarJob  *job,
                        GArray     *param_values,
@@ -882,9 +1477,13 @@ _thunar_io_jobs_chown (ThunarJob  *job,
   gboolean          recursive;
   GError           *err = NULL;
   GList            *file_list;
+  GList            *collected;
   GList            *lp;
   gint              uid;
   gint              gid;
+#ifdef TIJ_HAVE_AT_FUNCS
+  TijChange         change = { job, -1, -1, FALSE, 0, 0, 0, 0, 0, 0 };
+#endif
 
   _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
   _thunar_return_val_if_fail (param_values != NULL, FALSE);
@@ -898,20 +1497,33 @@ _thunar_io_jobs_chown (ThunarJob  *job,
 
   _thunar_assert ((uid >= 0 || gid >= 0) && !(uid >= 0 && gid >= 0));
 
-  /* collect the files for the chown operation */
-  if (recursive)
-    file_list = _tij_collect_nofollow (job, file_list, FALSE, &err);
-  else
-    file_list = thunar_g_file_list_copy (file_list);
+#ifdef TIJ_HAVE_AT_FUNCS
+  /* change the local files in place while walking the tree */
+  change.uid = uid;
+  change.gid = gid;
+  file_list = _tij_change_native (&change, file_list, recursive, &err);
+#else
+  file_list = thunar_g_file_list_copy (file_list);
+#endif
+
+  /* collect the remaining files for the chown operation */
+  if (recursive && file_list != NULL && err == NULL)
+    {
+      collected = _tij_collect_nofollow (job, file_list, FALSE, &err);
+      thunar_g_file_list_free (file_list);
+      file_list = collected;
+    }
 
   if (err != NULL)
     {
+      thunar_g_file_list_free (file_list);
       g_propagate_error (error, err);
       return FALSE;
     }
 
   /* we know the total list of files to process */
-  thunar_job_set_total_files (THUNAR_JOB (job), file_list);
+  if (file_list != NULL)
+    thunar_job_set_total_files (THUNAR_JOB (job), file_list);
 
   /* change the ownership of all files */
   for (lp = file_list; lp != NULL && err == NULL; lp = lp->next)
@@ -1018,6 +1630,7 @@ _thunar_io_jobs_chmod (ThunarJob  *job,
   gboolean          recursive;
   GError           *err = NULL;
   GList            *file_list;
+  GList            *collected;
   GList            *lp;
   ThunarFileMode    dir_mask;
   ThunarFileMode    dir_mode;
@@ -1027,6 +1640,9 @@ _thunar_io_jobs_chmod (ThunarJob  *job,
   ThunarFileMode    mode;
   ThunarFileMode    old_mode;
   ThunarFileMode    new_mode;
+#ifdef TIJ_HAVE_AT_FUNCS
+  TijChange         change = { job, -1, -1, FALSE, 0, 0, 0, 0, 0, 0 };
+#endif
 
   _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
   _thunar_return_val_if_fail (param_values != NULL, FALSE);
@@ -1040,20 +1656,36 @@ _thunar_io_jobs_chmod (ThunarJob  *job,
   file_mode = g_value_get_flags (&g_array_index (param_values, GValue, 4));
   recursive = g_value_get_boolean (&g_array_index (param_values, GValue, 5));
 
-  /* collect the files for the chown operation */
-  if (recursive)
-    file_list = _tij_collect_nofollow (job, file_list, FALSE, &err);
-  else
-    file_list = thunar_g_file_list_copy (file_list);
+#ifdef TIJ_HAVE_AT_FUNCS
+  /* change the local files in place while walking the tree */
+  change.mode = TRUE;
+  change.dir_mask = dir_mask;
+  change.dir_mode = dir_mode;
+  change.file_mask = file_mask;
+  change.file_mode = file_mode;
+  file_list = _tij_change_native (&change, file_list, recursive, &err);
+#else
+  file_list = thunar_g_file_list_copy (file_list);
+#endif
+
+  /* collect the remaining files for the chmod operation */
+  if (recursive && file_list != NULL && err == NULL)
+    {
+      collected = _tij_collect_nofollow (job, file_list, FALSE, &err);
+      thunar_g_file_list_free (file_list);
+      file_list = collected;
+    }
 
   if (err != NULL)
     {
+      thunar_g_file_list_free (file_list);
       g_propagate_error (error, err);
       return FALSE;
     }
 
   /* we know the total list of files to process */
-  thunar_job_set_total_files (THUNAR_JOB (job), file_list);
+  if (file_list != NULL)
+    thunar_job_set_total_files (THUNAR_JOB (job), file_list);
 
   /* change the ownership of all files */
   for (lp = file_list; lp != NULL && err == NULL; lp = lp->next)
@@ -1093,7 +1725,7 @@ retry_chown:
        * information) into account */
       new_mode = ((old_mode & ~mask) | mode) & 07777;
 
-      if (old_mode != new_mode)
+      if ((old_mode & 07777) != new_mode)
         {
           /* try to change the file mode */
           g_file_set_attribute_uint32 (lp->data,
@@ -1242,6 +1874,281 @@ thunar_io_jobs_list_directory (GFile *directory)
 
 
 
+typedef struct
+{
+  ThunarJob                  *job;
+  const ThunarSearchCriteria *criteria;
+  GThreadPool                *pool;
+
+  /* protects the fields below */
+  GMutex                      lock;
+  GCond                       cond;
+
+  /* number of folders queued or being scanned */
+  guint                       n_pending;
+
+  /* the matches not reported yet */
+  GList                      *matches;
+} TijSearch;
+
+typedef struct
+{
+  GFile *directory;
+  guint  depth;
+} TijSearchFolder;
+
+
+
+static void
+_tij_search_process (TijSearch *search,
+                     GList     *files,
+                     guint      depth)
+{
+  TijSearchFolder *folder;
+  GList           *matches = NULL;
+  GList           *lp;
+
+  for (lp = files; lp != NULL; lp = lp->next)
+    {
+      /* queue sub folders for the pool, but don't follow symlinks to avoid loops */
+      if (thunar_file_is_directory (lp->data)
+          && !thunar_file_is_symlink (lp->data)
+          && (search->criteria->max_depth == 0 || depth < search->criteria->max_depth))
+        {
+          folder = g_slice_new (TijSearchFolder);
+          folder->directory = g_object_ref (thunar_file_get_file (lp->data));
+          folder->depth = depth + 1;
+
+          g_mutex_lock (&search->lock);
+          search->n_pending += 1;
+          g_mutex_unlock (&search->lock);
+
+          g_thread_pool_push (search->pool, folder, NULL);
+        }
+
+      /* collect the matches, the list owns a reference on the files */
+      if (thunar_search_criteria_matches (search->criteria, lp->data))
+        matches = g_list_prepend (matches, g_object_ref (lp->data));
+    }
+
+  if (matches != NULL)
+    {
+      g_mutex_lock (&search->lock);
+      search->matches = g_list_concat (matches, search->matches);
+      g_mutex_unlock (&search->lock);
+    }
+}
+
+
+
+static void
+_tij_search_folder (gpointer data,
+                    gpointer user_data)
+{
+  TijSearchFolder *folder = data;
+  TijSearch       *search = user_data;
+  GList           *files;
+
+  /* scan the folder, errors in sub folders are ignored like find(1) does */
+  if (!exo_job_is_cancelled (EXO_JOB (search->job)))
+    {
+      files = thunar_io_scan_directory (search->job, folder->directory,
+                                        G_FILE_QUERY_INFO_NONE,
+                                        FALSE, FALSE, TRUE, NULL);
+      _tij_search_process (search, files, folder->depth);
+      thunar_g_file_list_free (files);
+    }
+
+  g_object_unref (folder->directory);
+  g_slice_free (TijSearchFolder, folder);
+
+  /* wake up the job once all folders are done */
+  g_mutex_lock (&search->lock);
+  if (--search->n_pending == 0)
+    g_cond_signal (&search->cond);
+  g_mutex_unlock (&search->lock);
+}
+
+
+
+static gboolean
+_tij_search_index (ThunarJob                  *job,
+                   GFile                      *directory,
+                   const ThunarSearchCriteria *criteria)
+{
+  ThunarSearchIndex *index;
+  ThunarFile        *file;
+  GList             *matches = NULL;
+  GList             *files;
+  GList             *lp;
+  gint64             last_report;
+  gint64             now;
+  gboolean           indexed = FALSE;
+
+  index = thunar_search_index_get_default ();
+  if (index == NULL)
+    return FALSE;
+
+  if (thunar_search_index_query (index, directory, criteria, &files))
+    {
+      indexed = TRUE;
+      last_report = g_get_monotonic_time ();
+
+      /* the index may be outdated, so files that are gone are skipped
+       * and the size and date limits are checked on the files */
+      for (lp = files; lp != NULL && !exo_job_is_cancelled (EXO_JOB (job)); lp = lp->next)
+        {
+          file = thunar_file_get (lp->data, NULL);
+          if (file != NULL && thunar_search_criteria_matches (criteria, file))
+            matches = g_list_prepend (matches, file);
+          else if (file != NULL)
+            g_object_unref (file);
+
+          now = g_get_monotonic_time ();
+          if (matches != NULL && (lp->next == NULL || now - last_report >= TIJ_SEARCH_REPORT_INTERVAL))
+            {
+              if (!thunar_job_files_ready (job, matches))
+                thunar_g_file_list_free (matches);
+              matches = NULL;
+              last_report = now;
+            }
+        }
+
+      thunar_g_file_list_free (matches);
+      thunar_g_file_list_free (files);
+    }
+
+  thunar_search_index_release (index);
+
+  return indexed;
+}
+
+
+
+static gboolean
+_thunar_io_jobs_search (ThunarJob  *job,
+                        GArray     *param_values,
+                        GError    **error)
+{
+  TijSearch  search;
+  GError    *err = NULL;
+  GFile     *directory;
+  GList     *file_list;
+  gint64     last_report = 0;
+  gint64     now;
+  gboolean   done;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
+  _thunar_return_val_if_fail (param_values != NULL, FALSE);
+  _thunar_return_val_if_fail (param_values->len == 2, FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  if (exo_job_set_error_if_cancelled (EXO_JOB (job), error))
+    return FALSE;
+
+  /* determine the directory and what to search for */
+  directory = g_value_get_object (&g_array_index (param_values, GValue, 0));
+  _thunar_assert (G_IS_FILE (directory));
+
+  search.job = job;
+  search.criteria = g_value_get_boxed (&g_array_index (param_values, GValue, 1));
+
+  /* answer from the file name index if it covers the folder */
+  if (_tij_search_index (job, directory, search.criteria))
+    {
+      if (exo_job_set_error_if_cancelled (EXO_JOB (job), &err))
+        {
+          g_propagate_error (error, err);
+          return FALSE;
+        }
+
+      return TRUE;
+    }
+
+  search.n_pending = 0;
+  search.matches = NULL;
+  g_mutex_init (&search.lock);
+  g_cond_init (&search.cond);
+  search.pool = g_thread_pool_new (_tij_search_folder, &search,
+                                   MAX (search.criteria->n_threads, 1),
+                                   FALSE, NULL);
+
+  /* scan the start folder here, so errors are reported */
+  file_list = thunar_io_scan_directory (job, directory, G_FILE_QUERY_INFO_NONE,
+                                        FALSE, FALSE, TRUE, &err);
+  if (G_LIKELY (err == NULL))
+    _tij_search_process (&search, file_list, 0);
+  thunar_g_file_list_free (file_list);
+
+  /* report the matches while the pool scans the sub folders */
+  g_mutex_lock (&search.lock);
+  for (;;)
+    {
+      done = (search.n_pending == 0);
+      now = g_get_monotonic_time ();
+
+      if (search.matches != NULL && (done || now - last_report >= TIJ_SEARCH_REPORT_INTERVAL))
+        {
+          file_list = search.matches;
+          search.matches = NULL;
+          last_report = now;
+
+          g_mutex_unlock (&search.lock);
+
+          /* hand the matches over to the folder */
+          if (exo_job_is_cancelled (EXO_JOB (job))
+              || !thunar_job_files_ready (job, file_list))
+            thunar_g_file_list_free (file_list);
+
+          g_mutex_lock (&search.lock);
+        }
+      else if (done)
+        {
+          break;
+        }
+      else
+        {
+          g_cond_wait_until (&search.cond, &search.lock, now + TIJ_SEARCH_REPORT_INTERVAL);
+        }
+    }
+  g_mutex_unlock (&search.lock);
+
+  /* all folders are done, so this doesn't block */
+  g_thread_pool_free (search.pool, FALSE, TRUE);
+  g_mutex_clear (&search.lock);
+  g_cond_clear (&search.cond);
+
+  /* abort on errors or cancellation */
+  if (err != NULL)
+    {
+      g_propagate_error (error, err);
+      return FALSE;
+    }
+  else if (exo_job_set_error_if_cancelled (EXO_JOB (job), &err))
+    {
+      g_propagate_error (error, err);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+
+
+ThunarJob *
+thunar_io_jobs_search_directory (GFile                      *directory,
+                                 const ThunarSearchCriteria *criteria)
+{
+  _thunar_return_val_if_fail (G_IS_FILE (directory), NULL);
+  _thunar_return_val_if_fail (criteria != NULL, NULL);
+
+  return thunar_simple_job_launch (_thunar_io_jobs_search, 2,
+                                   G_TYPE_FILE, directory,
+                                   THUNAR_TYPE_SEARCH_CRITERIA, criteria);
+}
+
+
+
 static gboolean
 _thunar_io_jobs_rename_notify (ThunarFile *file)
 {
@@ -23,6 +23,7 @@
 
 #include <thunar/thunar-job.h>
 #include <thunar/thunar-enum-types.h>
+#include <thunar/thunar-search-criteria.h>
 
 G_BEGIN_DECLS
 
@@ -49,6 +50,8 @@ ThunarJob *thunar_io_jobs_change_mode      (GList         *files,
                                             ThunarFileMode file_mode,
                                             gboolean       recursive) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
 ThunarJob *thunar_io_jobs_list_directory   (GFile         *directory) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
+ThunarJob *thunar_io_jobs_search_directory (GFile                      *directory,
+                                            const ThunarSearchCriteria *criteria) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
 ThunarJob *thunar_io_jobs_rename_file      (ThunarFile    *file,
                                             const gchar   *display_name) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
 
@@ -70,6 +70,11 @@ struct _ThunarJobPrivate
   ThunarJobResponse earlier_ask_overwrite_response;
   ThunarJobResponse earlier_ask_skip_response;
   GList            *total_files;
+  guint             n_total_files;
+
+  /* the last file passed to thunar_job_processing_file() */
+  GList            *current_file;
+  guint             n_processed;
 };
 
 
@@ -598,6 +603,9 @@ thunar_job_set_total_files (ThunarJob *job,
   _thunar_return_if_fail (total_files != NULL);
 
   job->priv->total_files = total_files;
+  job->priv->n_total_files = g_list_length (total_files);
+  job->priv->current_file = NULL;
+  job->priv->n_processed = 0;
 }
 
 
@@ -625,16 +633,27 @@ thunar_job_processing_file (ThunarJob *job,
   /* verify that we have total files set */
   if (G_LIKELY (job->priv->total_files != NULL))
     {
-      /* determine the number of files processed so far */
-      for (lp = job->priv->total_files, n_processed = 0;
-           lp != current_file;
-           lp = lp->next);
+      /* determine the number of files processed so far, the files
+       * are usually processed in order, so continue from the last one */
+      if (job->priv->current_file != NULL && job->priv->current_file->next == current_file)
+        {
+          n_processed = job->priv->n_processed + 1;
+        }
+      else
+        {
+          for (lp = job->priv->total_files, n_processed = 0;
+               lp != NULL && lp != current_file;
+               lp = lp->next, ++n_processed);
+        }
+
+      job->priv->current_file = current_file;
+      job->priv->n_processed = n_processed;
 
       /* emit only if n_processed is a multiple of 8 */
       if ((n_processed % 8) == 0)
         {
           /* determine the total_number of files */
-          n_total = g_list_length (job->priv->total_files);
+          n_total = job->priv->n_total_files;
 
           exo_job_percent (EXO_JOB (job), (n_processed * 100.0) / n_total);
         }
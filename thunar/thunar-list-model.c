@@ -29,6 +29,9 @@
 #ifdef HAVE_STRING_H
 #include <string.h>
 #endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
 
 #include <thunar/thunar-application.h>
 #include <thunar/thunar-file-monitor.h>
@@ -48,6 +51,7 @@ enum
   PROP_DATE_STYLE,
   PROP_FOLDER,
   PROP_FOLDERS_FIRST,
+  PROP_FREE_SPACE,
   PROP_NUM_FILES,
   PROP_SHOW_HIDDEN,
   PROP_FILE_SIZE_BINARY,
@@ -63,10 +67,25 @@ enum
 
 
 
+/* time in microseconds the free space of a volume is cached */
+#define THUNAR_LIST_MODEL_FREE_SPACE_TTL (5 * G_USEC_PER_SEC)
+
+/* folders with at least this many rows are sorted by several threads */
+#define THUNAR_LIST_MODEL_PARALLEL_SORT_MIN         (10000)
+#define THUNAR_LIST_MODEL_PARALLEL_SORT_MAX_THREADS (8)
+
+
+
 typedef gint (*ThunarSortFunc) (const ThunarFile *a,
                                 const ThunarFile *b,
                                 gboolean          case_sensitive);
 
+typedef struct _ThunarListModelFreeSpace      ThunarListModelFreeSpace;
+typedef struct _ThunarListModelFreeSpaceQuery ThunarListModelFreeSpaceQuery;
+typedef struct _ThunarListModelRemoved        ThunarListModelRemoved;
+typedef struct _ThunarListModelSortItem       ThunarListModelSortItem;
+typedef struct _ThunarListModelSortTask       ThunarListModelSortTask;
+
 
 
 static void               thunar_list_model_tree_model_init       (GtkTreeModelIface      *iface);
@@ -136,10 +155,26 @@ static gboolean           thunar_list_model_has_default_sort_func (GtkTreeSortab
 static gint               thunar_list_model_cmp_func              (gconstpointer           a,
                                                                    gconstpointer           b,
                                                                    gpointer                user_data);
+static gboolean           thunar_list_model_sort_parallel         (ThunarListModel        *store,
+                                                                   gint                    length,
+                                                                   gint                   *new_order);
 static void               thunar_list_model_sort                  (ThunarListModel        *store);
+static void               thunar_list_model_track_row             (ThunarListModel        *store,
+                                                                   ThunarFile             *file,
+                                                                   GSequenceIter          *row);
+static void               thunar_list_model_untrack_row           (ThunarListModel        *store,
+                                                                   ThunarFile             *file);
 static void               thunar_list_model_file_changed          (ThunarFileMonitor      *file_monitor,
                                                                    ThunarFile             *file,
-                                                                   ThunarListModel        *store);
+                                                                   gpointer                user_data);
+static void               thunar_list_model_row_changed           (ThunarListModel        *store,
+                                                                   ThunarFile             *file);
+static gboolean           thunar_list_model_filter_matches        (ThunarListModel        *store,
+                                                                   ThunarFile             *file);
+static void               thunar_list_model_filter_row            (ThunarListModel        *store,
+                                                                   GSequenceIter          *row);
+static void               thunar_list_model_unfilter_row          (ThunarListModel        *store,
+                                                                   GSequenceIter          *row);
 static void               thunar_list_model_folder_destroy        (ThunarFolder           *folder,
                                                                    ThunarListModel        *store);
 static void               thunar_list_model_folder_error          (ThunarFolder           *folder,
@@ -148,6 +183,12 @@ static void               thunar_list_model_folder_error          (ThunarFolder
 static void               thunar_list_model_files_added           (ThunarFolder           *folder,
                                                                    GList                  *files,
                                                                    ThunarListModel        *store);
+static gint               thunar_list_model_cmp_removed           (gconstpointer           a,
+                                                                   gconstpointer           b);
+static ThunarListModel   *thunar_list_model_find_sorted_peer      (ThunarListModel        *store,
+                                                                   ThunarFolder           *folder);
+static void               thunar_list_model_copy_rows             (ThunarListModel        *store,
+                                                                   ThunarListModel        *peer);
 static void               thunar_list_model_files_removed         (ThunarFolder           *folder,
                                                                    GList                  *files,
                                                                    ThunarListModel        *store);
@@ -183,6 +224,14 @@ static ThunarDateStyle    thunar_list_model_get_date_style        (ThunarListMod
 static void               thunar_list_model_set_date_style        (ThunarListModel        *store,
                                                                    ThunarDateStyle         date_style);
 static gint               thunar_list_model_get_num_files         (ThunarListModel        *store);
+static gboolean           thunar_list_model_get_free_space        (ThunarListModel        *store,
+                                                                   guint64                *free_space_return);
+static void               thunar_list_model_summary_add           (ThunarListModel        *store,
+                                                                   ThunarFile             *file);
+static void               thunar_list_model_summary_remove        (ThunarListModel        *store,
+                                                                   ThunarFile             *file);
+static void               thunar_list_model_summary_free          (gpointer                data);
+static void               thunar_list_model_free_space_free       (gpointer                data);
 static gboolean           thunar_list_model_get_folders_first     (ThunarListModel        *store);
 
 
@@ -209,12 +258,25 @@ struct _ThunarListModel
 #endif
 
   GSequence      *rows;
-  GSList         *hidden;
+  GHashTable     *hidden;
   ThunarFolder   *folder;
+
+  /* the casefolded text typed to filter the view, and the rows
+   * not matching it, kept in sorted order so they can be moved
+   * back into rows without sorting the folder again.
+   */
+  gchar          *filter;
+  GSequence      *filtered;
+
   gboolean        show_hidden : 1;
   gboolean        file_size_binary : 1;
   ThunarDateStyle date_style;
 
+  /* maps the files in rows and filtered to their GSequenceIter,
+   * so rows can be looked up without walking the sequence.
+   */
+  GHashTable    *row_map;
+
   /* Use the shared ThunarFileMonitor instance, so we
    * do not need to connect "changed" handler to every
    * file in the model.
@@ -231,6 +293,58 @@ struct _ThunarListModel
   gboolean       sort_folders_first : 1;
   gint           sort_sign;   /* 1 = ascending, -1 descending */
   ThunarSortFunc sort_func;
+
+  /* running total of the sizes of the regular files in
+   * rows, updated whenever a row is inserted, removed or
+   * changed, so the statusbar text does not need to walk
+   * the whole folder. the table remembers the size each
+   * file contributed to the total.
+   */
+  guint64        size_summary;
+  GHashTable    *size_contributions;
+
+  /* pending query for the free space of the folder volume */
+  GCancellable  *free_space_cancellable;
+};
+
+struct _ThunarListModelFreeSpace
+{
+  guint64  free_space;
+  gint64   timestamp;
+  gboolean known;
+};
+
+struct _ThunarListModelFreeSpaceQuery
+{
+  ThunarListModel *store;
+  GCancellable    *cancellable;
+  gchar           *filesystem_id;
+};
+
+struct _ThunarListModelRemoved
+{
+  GSequenceIter *row;
+  gint           position;
+};
+
+struct _ThunarListModelSortItem
+{
+  ThunarFile    *file;
+  GSequenceIter *row;
+  gint           position;
+};
+
+struct _ThunarListModelSortTask
+{
+  ThunarListModel         *store;
+  ThunarListModelSortItem *src;
+  ThunarListModelSortItem *dst;
+
+  /* sort src from start to end, or merge the sorted
+   * runs before and after middle into dst */
+  gint                     start;
+  gint                     middle;
+  gint                     end;
 };
 
 
@@ -238,6 +352,14 @@ struct _ThunarListModel
 static guint       list_model_signals[LAST_SIGNAL];
 static GParamSpec *list_model_props[N_PROPERTIES] = { NULL, };
 
+/* filesystem id -> ThunarListModelFreeSpace, shared by all models */
+static GHashTable *free_space_cache = NULL;
+
+/* ThunarFile -> GSList of the models showing the file in a row, used
+ * to route "file-changed" only to the models that contain the file */
+static GHashTable *list_model_subscribers = NULL;
+static GSList     *list_model_stores = NULL;
+
 
 
 G_DEFINE_TYPE_WITH_CODE (ThunarListModel, thunar_list_model, G_TYPE_OBJECT,
@@ -307,6 +429,20 @@ thunar_list_model_class_init (ThunarListModelClass *klass)
                             TRUE,
                             EXO_PARAM_READWRITE);
 
+  /**
+   * ThunarListModel::free-space:
+   *
+   * The amount of free space on the volume of the folder presented
+   * by this #ThunarListModel, or %0 if it is not known (yet). The
+   * value is queried asynchronously and cached for a few seconds.
+   **/
+  list_model_props[PROP_FREE_SPACE] =
+      g_param_spec_uint64 ("free-space",
+                           "free-space",
+                           "free-space",
+                           0, G_MAXUINT64, 0,
+                           EXO_PARAM_READABLE);
+
   /**
    * ThunarListModel::num-files:
    *
@@ -422,13 +558,24 @@ thunar_list_model_init (ThunarListModel *store)
   store->sort_sign = 1;
   store->sort_func = thunar_file_compare_by_name;
   store->rows = g_sequence_new (g_object_unref);
+  store->filtered = g_sequence_new (g_object_unref);
+  store->row_map = g_hash_table_new (g_direct_hash, g_direct_equal);
+  store->hidden = g_hash_table_new_full (g_direct_hash, g_direct_equal, g_object_unref, NULL);
+  store->size_contributions = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                                     NULL, thunar_list_model_summary_free);
 
   /* connect to the shared ThunarFileMonitor, so we don't need to
-   * connect "changed" to every single ThunarFile we own.
+   * connect "changed" to every single ThunarFile we own. a single
+   * handler dispatches the changes to the models with the file.
    */
   store->file_monitor = thunar_file_monitor_get_default ();
-  g_signal_connect (G_OBJECT (store->file_monitor), "file-changed",
-                    G_CALLBACK (thunar_list_model_file_changed), store);
+  if (list_model_stores == NULL)
+    {
+      list_model_subscribers = g_hash_table_new (g_direct_hash, g_direct_equal);
+      g_signal_connect (G_OBJECT (store->file_monitor), "file-changed",
+                        G_CALLBACK (thunar_list_model_file_changed), NULL);
+    }
+  list_model_stores = g_slist_prepend (list_model_stores, store);
 }
 
 
@@ -450,9 +597,20 @@ thunar_list_model_finalize (GObject *object)
   ThunarListModel *store = THUNAR_LIST_MODEL (object);
 
   g_sequence_free (store->rows);
+  g_sequence_free (store->filtered);
+  g_free (store->filter);
+  g_hash_table_destroy (store->row_map);
+  g_hash_table_destroy (store->hidden);
+  g_hash_table_destroy (store->size_contributions);
 
   /* disconnect from the file monitor */
-  g_signal_handlers_disconnect_by_func (G_OBJECT (store->file_monitor), thunar_list_model_file_changed, store);
+  list_model_stores = g_slist_remove (list_model_stores, store);
+  if (list_model_stores == NULL)
+    {
+      g_signal_handlers_disconnect_by_func (G_OBJECT (store->file_monitor), thunar_list_model_file_changed, NULL);
+      g_hash_table_destroy (list_model_subscribers);
+      list_model_subscribers = NULL;
+    }
   g_object_unref (G_OBJECT (store->file_monitor));
 
   (*G_OBJECT_CLASS (thunar_list_model_parent_class)->finalize) (object);
@@ -467,6 +625,7 @@ thunar_list_model_get_property (GObject    *object,
                                 GParamSpec *pspec)
 {
   ThunarListModel *store = THUNAR_LIST_MODEL (object);
+  guint64          size;
 
   switch (prop_id)
     {
@@ -486,6 +645,12 @@ thunar_list_model_get_property (GObject    *object,
       g_value_set_boolean (value, thunar_list_model_get_folders_first (store));
       break;
 
+    case PROP_FREE_SPACE:
+      if (!thunar_list_model_get_free_space (store, &size))
+        size = 0;
+      g_value_set_uint64 (value, size);
+      break;
+
     case PROP_NUM_FILES:
       g_value_set_uint (value, thunar_list_model_get_num_files (store));
       break;
@@ -1047,6 +1212,182 @@ thunar_list_model_cmp_func (gconstpointer a,
 
 
 
+static gint
+thunar_list_model_cmp_items (gconstpointer a,
+                             gconstpointer b,
+                             gpointer      user_data)
+{
+  const ThunarListModelSortItem *item_a = a;
+  const ThunarListModelSortItem *item_b = b;
+  gint                           result;
+
+  result = thunar_list_model_cmp_func (item_a->file, item_b->file, user_data);
+
+  /* keep equal rows in their old order */
+  if (G_UNLIKELY (result == 0))
+    result = item_a->position - item_b->position;
+
+  return result;
+}
+
+
+
+static gpointer
+thunar_list_model_sort_run (gpointer data)
+{
+  ThunarListModelSortTask *task = data;
+
+  g_qsort_with_data (task->src + task->start, task->end - task->start,
+                     sizeof (ThunarListModelSortItem),
+                     thunar_list_model_cmp_items, task->store);
+
+  return NULL;
+}
+
+
+
+static gpointer
+thunar_list_model_sort_merge (gpointer data)
+{
+  ThunarListModelSortTask *task = data;
+  gint                     i = task->start;
+  gint                     j = task->middle;
+  gint                     n = task->start;
+
+  while (i < task->middle && j < task->end)
+    {
+      if (thunar_list_model_cmp_items (task->src + j, task->src + i, task->store) < 0)
+        task->dst[n++] = task->src[j++];
+      else
+        task->dst[n++] = task->src[i++];
+    }
+
+  /* copy the rest of the run that is left */
+  memcpy (task->dst + n, task->src + i, (task->middle - i) * sizeof (ThunarListModelSortItem));
+  n += task->middle - i;
+  memcpy (task->dst + n, task->src + j, (task->end - j) * sizeof (ThunarListModelSortItem));
+
+  return NULL;
+}
+
+
+
+static void
+thunar_list_model_sort_tasks (ThunarListModelSortTask *tasks,
+                              guint                    n_tasks,
+                              GThreadFunc              func)
+{
+  GThread *threads[THUNAR_LIST_MODEL_PARALLEL_SORT_MAX_THREADS];
+  guint    n;
+
+  /* the first task runs in this thread while the others run in new ones,
+   * a task for which no thread could be created runs here as well */
+  for (n = 1; n < n_tasks; ++n)
+    {
+      threads[n] = g_thread_try_new ("thunar-sort", func, tasks + n, NULL);
+      if (G_UNLIKELY (threads[n] == NULL))
+        (*func) (tasks + n);
+    }
+
+  (*func) (tasks);
+
+  for (n = 1; n < n_tasks; ++n)
+    if (G_LIKELY (threads[n] != NULL))
+      g_thread_join (threads[n]);
+}
+
+
+
+static gboolean
+thunar_list_model_sort_parallel (ThunarListModel *store,
+                                 gint             length,
+                                 gint            *new_order)
+{
+  ThunarListModelSortTask  tasks[THUNAR_LIST_MODEL_PARALLEL_SORT_MAX_THREADS];
+  ThunarListModelSortItem *items;
+  ThunarListModelSortItem *buffer;
+  ThunarListModelSortItem *swap;
+  GSequenceIter           *row;
+  GSequenceIter           *end;
+  glong                    n_threads = 1;
+  guint                    n_runs;
+  guint                    n, m;
+  gint                     run_length;
+  gint                     i;
+
+  /* the other sort functions look up users, groups and content types,
+   * which must not happen outside the main thread */
+  if (store->sort_func != thunar_file_compare_by_name
+      && store->sort_func != sort_by_date_accessed
+      && store->sort_func != sort_by_date_modified
+      && store->sort_func != sort_by_permissions
+      && store->sort_func != sort_by_size)
+    return FALSE;
+
+#ifdef _SC_NPROCESSORS_ONLN
+  n_threads = CLAMP (sysconf (_SC_NPROCESSORS_ONLN), 1, THUNAR_LIST_MODEL_PARALLEL_SORT_MAX_THREADS);
+#endif
+  if (n_threads < 2)
+    return FALSE;
+
+  /* collect the rows into a flat array */
+  items = g_new (ThunarListModelSortItem, length);
+  row = g_sequence_get_begin_iter (store->rows);
+  for (i = 0; i < length; ++i, row = g_sequence_iter_next (row))
+    {
+      items[i].file = g_sequence_get (row);
+      items[i].row = row;
+      items[i].position = i;
+    }
+
+  /* sort a run of rows in each thread */
+  run_length = (length + n_threads - 1) / n_threads;
+  for (n = 0; n < n_threads; ++n)
+    {
+      tasks[n].store = store;
+      tasks[n].src = items;
+      tasks[n].start = MIN ((gint) n * run_length, length);
+      tasks[n].end = MIN (tasks[n].start + run_length, length);
+    }
+  thunar_list_model_sort_tasks (tasks, n_threads, thunar_list_model_sort_run);
+
+  /* merge pairs of sorted runs until a single run is left */
+  buffer = g_new (ThunarListModelSortItem, length);
+  for (n_runs = n_threads; n_runs > 1; n_runs = (n_runs + 1) / 2, run_length *= 2)
+    {
+      for (n = 0, m = 0; n < n_runs; n += 2, ++m)
+        {
+          tasks[m].store = store;
+          tasks[m].src = items;
+          tasks[m].dst = buffer;
+          tasks[m].start = MIN ((gint) n * run_length, length);
+          tasks[m].middle = MIN (tasks[m].start + run_length, length);
+          tasks[m].end = MIN (tasks[m].middle + run_length, length);
+        }
+      thunar_list_model_sort_tasks (tasks, m, thunar_list_model_sort_merge);
+
+      swap = items;
+      items = buffer;
+      buffer = swap;
+    }
+
+  /* move the rows into the new order, without comparing them
+   * again, the iters stay valid; new_order[newpos] = oldpos */
+  end = g_sequence_get_end_iter (store->rows);
+  for (i = 0; i < length; ++i)
+    {
+      g_sequence_move (items[i].row, end);
+      new_order[i] = items[i].position;
+    }
+
+  g_free (items);
+  g_free (buffer);
+
+  return TRUE;
+}
+
+
+
 static void
 thunar_list_model_sort (ThunarListModel *store)
 {
@@ -1059,36 +1400,46 @@ thunar_list_model_sort (ThunarListModel *store)
 
   _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
 
+  /* the filtered rows are not shown, so nobody needs to know */
+  g_sequence_sort (store->filtered, thunar_list_model_cmp_func, store);
+
   length = g_sequence_get_length (store->rows);
   if (G_UNLIKELY (length <= 1))
     return;
 
   /* be sure to not overuse the stack */
   if (G_LIKELY (length < 2000))
-    {
-      old_order = g_newa (GSequenceIter *, length);
-      new_order = g_newa (gint, length);
-    }
+    new_order = g_newa (gint, length);
   else
-    {
-      old_order = g_new (GSequenceIter *, length);
-      new_order = g_new (gint, length);
-    }
+    new_order = g_new (gint, length);
 
-  /* store old order */
-  row = g_sequence_get_begin_iter (store->rows);
-  for (n = 0; n < length; ++n)
+  /* large folders are sorted by several threads */
+  if (length < THUNAR_LIST_MODEL_PARALLEL_SORT_MIN
+      || !thunar_list_model_sort_parallel (store, length, new_order))
     {
-      old_order[n] = row;
-      row = g_sequence_iter_next (row);
-    }
+      if (G_LIKELY (length < 2000))
+        old_order = g_newa (GSequenceIter *, length);
+      else
+        old_order = g_new (GSequenceIter *, length);
+
+      /* store old order */
+      row = g_sequence_get_begin_iter (store->rows);
+      for (n = 0; n < length; ++n)
+        {
+          old_order[n] = row;
+          row = g_sequence_iter_next (row);
+        }
 
-  /* sort */
-  g_sequence_sort (store->rows, thunar_list_model_cmp_func, store);
+      /* sort */
+      g_sequence_sort (store->rows, thunar_list_model_cmp_func, store);
 
-  /* new_order[newpos] = oldpos */
-  for (n = 0; n < length; ++n)
-    new_order[g_sequence_iter_get_position (old_order[n])] = n;
+      /* new_order[newpos] = oldpos */
+      for (n = 0; n < length; ++n)
+        new_order[g_sequence_iter_get_position (old_order[n])] = n;
+
+      if (G_UNLIKELY (length >= 2000))
+        g_free (old_order);
+    }
 
   /* tell the view about the new item order */
   path = gtk_tree_path_new_first ();
@@ -1097,10 +1448,42 @@ thunar_list_model_sort (ThunarListModel *store)
 
   /* clean up if we used the heap */
   if (G_UNLIKELY (length >= 2000))
-    {
-      g_free (old_order);
-      g_free (new_order);
-    }
+    g_free (new_order);
+}
+
+
+
+static void
+thunar_list_model_track_row (ThunarListModel *store,
+                             ThunarFile      *file,
+                             GSequenceIter   *row)
+{
+  GSList *stores;
+
+  g_hash_table_insert (store->row_map, file, row);
+
+  /* subscribe to changes of the file */
+  stores = g_hash_table_lookup (list_model_subscribers, file);
+  g_hash_table_insert (list_model_subscribers, file, g_slist_prepend (stores, store));
+}
+
+
+
+static void
+thunar_list_model_untrack_row (ThunarListModel *store,
+                               ThunarFile      *file)
+{
+  GSList *stores;
+
+  g_hash_table_remove (store->row_map, file);
+
+  /* unsubscribe from changes of the file */
+  stores = g_hash_table_lookup (list_model_subscribers, file);
+  stores = g_slist_remove (stores, store);
+  if (G_LIKELY (stores == NULL))
+    g_hash_table_remove (list_model_subscribers, file);
+  else
+    g_hash_table_insert (list_model_subscribers, file, stores);
 }
 
 
@@ -1108,85 +1491,185 @@ thunar_list_model_sort (ThunarListModel *store)
 static void
 thunar_list_model_file_changed (ThunarFileMonitor *file_monitor,
                                 ThunarFile        *file,
-                                ThunarListModel   *store)
+                                gpointer           user_data)
+{
+  GSList *stores;
+  GSList *lp;
+
+  _thunar_return_if_fail (THUNAR_IS_FILE_MONITOR (file_monitor));
+  _thunar_return_if_fail (THUNAR_IS_FILE (file));
+
+  /* check if any model shows this file */
+  stores = g_hash_table_lookup (list_model_subscribers, file);
+  if (G_LIKELY (stores == NULL))
+    return;
+
+  /* the handlers of the model signals may change the subscribers */
+  stores = g_slist_copy (stores);
+  g_slist_foreach (stores, (GFunc) g_object_ref, NULL);
+
+  for (lp = stores; lp != NULL; lp = lp->next)
+    thunar_list_model_row_changed (lp->data, file);
+
+  g_slist_free_full (stores, g_object_unref);
+}
+
+
+
+static void
+thunar_list_model_row_changed (ThunarListModel *store,
+                               ThunarFile      *file)
 {
   GSequenceIter *row;
-  GSequenceIter *end;
   gint           pos_after;
-  gint           pos_before = 0;
+  gint           pos_before;
   gint          *new_order;
   gint           length;
   gint           i, j;
   GtkTreePath   *path;
   GtkTreeIter    iter;
 
-  _thunar_return_if_fail (THUNAR_IS_FILE_MONITOR (file_monitor));
   _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
   _thunar_return_if_fail (THUNAR_IS_FILE (file));
 
-  row = g_sequence_get_begin_iter (store->rows);
-  end = g_sequence_get_end_iter (store->rows);
+  /* lookup the row of the file, if it's still in the model */
+  row = g_hash_table_lookup (store->row_map, file);
+  if (G_UNLIKELY (row == NULL))
+    return;
 
-  while (row != end)
+  /* a renamed file may start or stop matching the filter */
+  if (g_sequence_iter_get_sequence (row) == store->filtered)
     {
-      if (G_UNLIKELY (g_sequence_get (row) == file))
-        {
-          /* generate the iterator for this row */
-          GTK_TREE_ITER_INIT (iter, store->stamp, row);
+      if (thunar_list_model_filter_matches (store, file))
+        thunar_list_model_unfilter_row (store, row);
+      else
+        g_sequence_sort_changed (row, thunar_list_model_cmp_func, store);
+      return;
+    }
+  else if (!thunar_list_model_filter_matches (store, file))
+    {
+      thunar_list_model_filter_row (store, row);
+      g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_NUM_FILES]);
+      return;
+    }
 
-          /* notify the view that it has to redraw the file */
-          _thunar_assert (pos_before == g_sequence_iter_get_position (row));
-          path = gtk_tree_path_new_from_indices (pos_before, -1);
-          gtk_tree_model_row_changed (GTK_TREE_MODEL (store), path, &iter);
-          gtk_tree_path_free (path);
+  /* generate the iterator for this row */
+  GTK_TREE_ITER_INIT (iter, store->stamp, row);
 
-          /* check if the sorting changed */
-          g_sequence_sort_changed (row, thunar_list_model_cmp_func, store);
-          pos_after = g_sequence_iter_get_position (row);
-          if (pos_after != pos_before)
-            {
-              /* do swap sorting here since its much faster than a complete sort */
-              length = g_sequence_get_length (store->rows);
-              if (G_LIKELY (length < 2000))
-                new_order = g_newa (gint, length);
-              else
-                new_order = g_new (gint, length);
-
-              /* new_order[newpos] = oldpos */
-              for (i = 0, j = 0; i < length; ++i)
-                {
-                  if (G_UNLIKELY (i == pos_after))
-                    {
-                      new_order[i] = pos_before;
-                    }
-                  else
-                    {
-                      if (G_UNLIKELY (j == pos_before))
-                        j++;
-                      new_order[i] = j++;
-                    }
-                }
+  /* the size of the file may have changed */
+  thunar_list_model_summary_remove (store, file);
+  thunar_list_model_summary_add (store, file);
 
-              /* tell the view about the new item order */
-              path = gtk_tree_path_new_first ();
-              gtk_tree_model_rows_reordered (GTK_TREE_MODEL (store), path, NULL, new_order);
-              gtk_tree_path_free (path);
+  /* notify the view that it has to redraw the file */
+  pos_before = g_sequence_iter_get_position (row);
+  path = gtk_tree_path_new_from_indices (pos_before, -1);
+  gtk_tree_model_row_changed (GTK_TREE_MODEL (store), path, &iter);
+  gtk_tree_path_free (path);
 
-              /* clean up if we used the heap */
-              if (G_UNLIKELY (length >= 2000))
-                g_free (new_order);
-            }
+  /* check if the sorting changed */
+  g_sequence_sort_changed (row, thunar_list_model_cmp_func, store);
+  pos_after = g_sequence_iter_get_position (row);
+  if (pos_after != pos_before)
+    {
+      /* do swap sorting here since its much faster than a complete sort,
+       * this is emitted as a reorder and not as a delete and insert, so
+       * the views keep the row selected */
+      length = g_sequence_get_length (store->rows);
+      if (G_LIKELY (length < 2000))
+        new_order = g_newa (gint, length);
+      else
+        new_order = g_new (gint, length);
 
-          break;
+      /* new_order[newpos] = oldpos */
+      for (i = 0, j = 0; i < length; ++i)
+        {
+          if (G_UNLIKELY (i == pos_after))
+            {
+              new_order[i] = pos_before;
+            }
+          else
+            {
+              if (G_UNLIKELY (j == pos_before))
+                j++;
+              new_order[i] = j++;
+            }
         }
 
-      row = g_sequence_iter_next (row);
-      pos_before++;
+      /* tell the view about the new item order */
+      path = gtk_tree_path_new_first ();
+      gtk_tree_model_rows_reordered (GTK_TREE_MODEL (store), path, NULL, new_order);
+      gtk_tree_path_free (path);
+
+      /* clean up if we used the heap */
+      if (G_UNLIKELY (length >= 2000))
+        g_free (new_order);
     }
 }
 
 
 
+static gboolean
+thunar_list_model_filter_matches (ThunarListModel *store,
+                                  ThunarFile      *file)
+{
+  gboolean matches;
+  gchar   *name;
+
+  if (G_LIKELY (store->filter == NULL))
+    return TRUE;
+
+  name = g_utf8_casefold (thunar_file_get_display_name (file), -1);
+  matches = (strstr (name, store->filter) != NULL);
+  g_free (name);
+
+  return matches;
+}
+
+
+
+static void
+thunar_list_model_filter_row (ThunarListModel *store,
+                              GSequenceIter   *row)
+{
+  GtkTreePath *path;
+  ThunarFile  *file = g_sequence_get (row);
+
+  _thunar_return_if_fail (g_sequence_iter_get_sequence (row) == store->rows);
+
+  path = gtk_tree_path_new_from_indices (g_sequence_iter_get_position (row), -1);
+
+  /* move the row into the filtered rows, the iter stays valid */
+  thunar_list_model_summary_remove (store, file);
+  g_sequence_move (row, g_sequence_search (store->filtered, file, thunar_list_model_cmp_func, store));
+
+  gtk_tree_model_row_deleted (GTK_TREE_MODEL (store), path);
+  gtk_tree_path_free (path);
+}
+
+
+
+static void
+thunar_list_model_unfilter_row (ThunarListModel *store,
+                                GSequenceIter   *row)
+{
+  GtkTreePath *path;
+  GtkTreeIter  iter;
+  ThunarFile  *file = g_sequence_get (row);
+
+  _thunar_return_if_fail (g_sequence_iter_get_sequence (row) == store->filtered);
+
+  /* the rows are sorted, so a binary search finds the position */
+  g_sequence_move (row, g_sequence_search (store->rows, file, thunar_list_model_cmp_func, store));
+  thunar_list_model_summary_add (store, file);
+
+  GTK_TREE_ITER_INIT (iter, store->stamp, row);
+  path = gtk_tree_path_new_from_indices (g_sequence_iter_get_position (row), -1);
+  gtk_tree_model_row_inserted (GTK_TREE_MODEL (store), path, &iter);
+  gtk_tree_path_free (path);
+}
+
+
+
 static void
 thunar_list_model_folder_destroy (ThunarFolder    *folder,
                                   ThunarListModel *store)
@@ -1253,13 +1736,21 @@ thunar_list_model_files_added (ThunarFolder    *folder,
       /* check if the file should be hidden */
       if (!store->show_hidden && thunar_file_is_hidden (file))
         {
-          store->hidden = g_slist_prepend (store->hidden, file);
+          g_hash_table_insert (store->hidden, file, file);
+        }
+      else if (!thunar_list_model_filter_matches (store, file))
+        {
+          row = g_sequence_insert_sorted (store->filtered, file,
+                                          thunar_list_model_cmp_func, store);
+          thunar_list_model_track_row (store, file, row);
         }
       else
         {
           /* insert the file */
           row = g_sequence_insert_sorted (store->rows, file,
                                           thunar_list_model_cmp_func, store);
+          thunar_list_model_track_row (store, file, row);
+          thunar_list_model_summary_add (store, file);
 
           if (has_handler)
             {
@@ -1281,60 +1772,198 @@ thunar_list_model_files_added (ThunarFolder    *folder,
 
 
 
+static ThunarListModel*
+thunar_list_model_find_sorted_peer (ThunarListModel *store,
+                                    ThunarFolder    *folder)
+{
+  ThunarListModel *peer;
+  GSList          *lp;
+
+  /* look for another model showing the folder with the same sorting */
+  for (lp = list_model_stores; lp != NULL; lp = lp->next)
+    {
+      peer = THUNAR_LIST_MODEL (lp->data);
+      if (peer != store
+          && peer->folder == folder
+          && peer->sort_func == store->sort_func
+          && peer->sort_sign == store->sort_sign
+          && peer->sort_case_sensitive == store->sort_case_sensitive
+          && peer->sort_folders_first == store->sort_folders_first)
+        return peer;
+    }
+
+  return NULL;
+}
+
+
+
 static void
-thunar_list_model_files_removed (ThunarFolder    *folder,
-                                 GList           *files,
-                                 ThunarListModel *store)
+thunar_list_model_copy_rows (ThunarListModel *store,
+                             ThunarListModel *peer)
 {
-  GList         *lp;
+  GSequenceIter *inserted;
   GSequenceIter *row;
   GSequenceIter *end;
-  GSequenceIter *next;
   GtkTreePath   *path;
-  gboolean       found;
+  GtkTreeIter    iter;
+  ThunarFile    *file;
+  gboolean       has_handler;
+  GList         *files;
+  GList         *lp;
+  gint          *indices;
 
-  /* drop all the referenced files from the model */
-  for (lp = files; lp != NULL; lp = lp->next)
-    {
-      row = g_sequence_get_begin_iter (store->rows);
-      end = g_sequence_get_end_iter (store->rows);
+  _thunar_return_if_fail (g_sequence_get_length (store->rows) == 0);
+  _thunar_return_if_fail (store->filter == NULL);
 
-      found = FALSE;
+  /* see thunar_list_model_files_added() */
+  path = gtk_tree_path_new_first ();
+  indices = gtk_tree_path_get_indices (path);
+  has_handler = g_signal_has_handler_pending (G_OBJECT (store), store->row_inserted_id, 0, FALSE);
 
-      while (row != end)
+  /* the rows of the peer are already sorted, so they
+   * can simply be appended without comparing files */
+  row = g_sequence_get_begin_iter (peer->rows);
+  end = g_sequence_get_end_iter (peer->rows);
+  for (; row != end; row = g_sequence_iter_next (row))
+    {
+      file = g_object_ref (g_sequence_get (row));
+
+      if (!store->show_hidden && thunar_file_is_hidden (file))
         {
-          next = g_sequence_iter_next (row);
+          g_hash_table_insert (store->hidden, file, file);
+          continue;
+        }
 
-          if (g_sequence_get (row) == lp->data)
-            {
-              /* setup path for "row-deleted" */
-              path = gtk_tree_path_new_from_indices (g_sequence_iter_get_position (row), -1);
+      indices[0] = g_sequence_get_length (store->rows);
+      inserted = g_sequence_append (store->rows, file);
+      thunar_list_model_track_row (store, file, inserted);
+      thunar_list_model_summary_add (store, file);
 
-              /* remove file from the model */
-              g_sequence_remove (row);
+      if (has_handler)
+        {
+          GTK_TREE_ITER_INIT (iter, store->stamp, inserted);
+          gtk_tree_model_row_inserted (GTK_TREE_MODEL (store), path, &iter);
+        }
+    }
 
-              /* notify the view(s) */
-              gtk_tree_model_row_deleted (GTK_TREE_MODEL (store), path);
-              gtk_tree_path_free (path);
+  /* take over the files hidden or filtered in the peer, the
+   * store has no filter yet, so these are inserted unless hidden */
+  files = g_hash_table_get_keys (peer->hidden);
+  row = g_sequence_get_begin_iter (peer->filtered);
+  end = g_sequence_get_end_iter (peer->filtered);
+  for (; row != end; row = g_sequence_iter_next (row))
+    files = g_list_prepend (files, g_sequence_get (row));
 
-              /* no need to look in the hidden files */
-              found = TRUE;
+  for (lp = files; lp != NULL; lp = lp->next)
+    {
+      file = g_object_ref (lp->data);
 
-              break;
-            }
+      if (!store->show_hidden && thunar_file_is_hidden (file))
+        {
+          g_hash_table_insert (store->hidden, file, file);
+          continue;
+        }
 
-          row = next;
+      inserted = g_sequence_insert_sorted (store->rows, file,
+                                           thunar_list_model_cmp_func, store);
+      thunar_list_model_track_row (store, file, inserted);
+      thunar_list_model_summary_add (store, file);
+
+      if (has_handler)
+        {
+          GTK_TREE_ITER_INIT (iter, store->stamp, inserted);
+          indices[0] = g_sequence_iter_get_position (inserted);
+          gtk_tree_model_row_inserted (GTK_TREE_MODEL (store), path, &iter);
+        }
+    }
+  g_list_free (files);
+
+  gtk_tree_path_free (path);
+
+  /* number of visible files changed */
+  g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_NUM_FILES]);
+}
+
+
+
+static gint
+thunar_list_model_cmp_removed (gconstpointer a,
+                               gconstpointer b)
+{
+  /* sort in descending order of position */
+  return ((const ThunarListModelRemoved *) b)->position - ((const ThunarListModelRemoved *) a)->position;
+}
+
+
+
+static void
+thunar_list_model_files_removed (ThunarFolder    *folder,
+                                 GList           *files,
+                                 ThunarListModel *store)
+{
+  ThunarListModelRemoved *removed;
+  GSequenceIter          *row;
+  GtkTreePath            *path;
+  gboolean                has_handler;
+  GArray                 *rows;
+  GList                  *lp;
+  gint                   *indices;
+  guint                   n;
+
+  /* lookup the rows of the removed files */
+  rows = g_array_new (FALSE, FALSE, sizeof (ThunarListModelRemoved));
+  for (lp = files; lp != NULL; lp = lp->next)
+    {
+      row = g_hash_table_lookup (store->row_map, lp->data);
+      if (row != NULL && g_sequence_iter_get_sequence (row) == store->filtered)
+        {
+          /* file is filtered, the views don't know about it */
+          thunar_list_model_untrack_row (store, lp->data);
+          g_sequence_remove (row);
         }
+      else if (G_LIKELY (row != NULL))
+        {
+          g_array_set_size (rows, rows->len + 1);
+          removed = &g_array_index (rows, ThunarListModelRemoved, rows->len - 1);
+          removed->row = row;
+          removed->position = g_sequence_iter_get_position (row);
 
-      /* check if the file was found */
-      if (!found)
+          thunar_list_model_untrack_row (store, lp->data);
+          thunar_list_model_summary_remove (store, lp->data);
+        }
+      else
         {
           /* file is hidden */
-          _thunar_assert (g_slist_find (store->hidden, lp->data) != NULL);
-          store->hidden = g_slist_remove (store->hidden, lp->data);
-          g_object_unref (G_OBJECT (lp->data));
+          _thunar_assert (g_hash_table_lookup (store->hidden, lp->data) != NULL);
+          g_hash_table_remove (store->hidden, lp->data);
+        }
+    }
+
+  /* remove the rows from the bottom up, so the positions of the rows
+   * still to be removed remain valid and the path can be reused */
+  g_array_sort (rows, thunar_list_model_cmp_removed);
+
+  /* check if we have any handlers connected for "row-deleted" */
+  has_handler = g_signal_has_handler_pending (G_OBJECT (store), store->row_deleted_id, 0, FALSE);
+
+  path = gtk_tree_path_new_first ();
+  indices = gtk_tree_path_get_indices (path);
+  for (n = 0; n < rows->len; ++n)
+    {
+      removed = &g_array_index (rows, ThunarListModelRemoved, n);
+
+      /* remove file from the model */
+      g_sequence_remove (removed->row);
+
+      /* notify the view(s) */
+      if (G_LIKELY (has_handler))
+        {
+          indices[0] = removed->position;
+          gtk_tree_model_row_deleted (GTK_TREE_MODEL (store), path);
         }
     }
+  gtk_tree_path_free (path);
+  g_array_free (rows, TRUE);
 
   /* this probably changed */
   g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_NUM_FILES]);
@@ -1760,12 +2389,13 @@ void
 thunar_list_model_set_folder (ThunarListModel *store,
                               ThunarFolder    *folder)
 {
-  GtkTreePath   *path;
-  gboolean       has_handler;
-  GList         *files;
-  GSequenceIter *row;
-  GSequenceIter *end;
-  GSequenceIter *next;
+  ThunarListModel *peer;
+  GtkTreePath     *path;
+  gboolean         has_handler;
+  GList           *files;
+  GSequenceIter   *row;
+  GSequenceIter   *end;
+  GSequenceIter   *next;
 
   _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
   _thunar_return_if_fail (folder == NULL || THUNAR_IS_FOLDER (folder));
@@ -1783,26 +2413,53 @@ thunar_list_model_set_folder (ThunarListModel *store,
       row = g_sequence_get_begin_iter (store->rows);
       end = g_sequence_get_end_iter (store->rows);
 
-      /* remove existing entries */
-      path = gtk_tree_path_new_first ();
-      while (row != end)
+      if (G_LIKELY (!has_handler))
         {
-          /* remove the row from the list */
-          next = g_sequence_iter_next (row);
-          g_sequence_remove (row);
-          row = next;
-
-          /* notify the view(s) if they're actually
-           * interested in the "row-deleted" signal.
+          /* nobody is interested in the individual rows (the views
+           * detach from the model when changing the folder), so drop
+           * all rows in one go without emitting any signals.
            */
-          if (G_LIKELY (has_handler))
-            gtk_tree_model_row_deleted (GTK_TREE_MODEL (store), path);
+          for (; row != end; row = g_sequence_iter_next (row))
+            thunar_list_model_untrack_row (store, g_sequence_get (row));
+          g_sequence_remove_range (g_sequence_get_begin_iter (store->rows), end);
+        }
+      else
+        {
+          /* remove existing entries */
+          path = gtk_tree_path_new_first ();
+          while (row != end)
+            {
+              /* remove the row from the list */
+              next = g_sequence_iter_next (row);
+              thunar_list_model_untrack_row (store, g_sequence_get (row));
+              g_sequence_remove (row);
+              row = next;
+
+              /* notify the view(s) about the removed row */
+              gtk_tree_model_row_deleted (GTK_TREE_MODEL (store), path);
+            }
+          gtk_tree_path_free (path);
         }
-      gtk_tree_path_free (path);
 
-      /* remove hidden entries */
-      g_slist_free_full (store->hidden, g_object_unref);
-      store->hidden = NULL;
+      /* reset the running totals */
+      g_hash_table_remove_all (store->size_contributions);
+      store->size_summary = 0;
+
+      /* stop querying the free space of the old volume */
+      if (store->free_space_cancellable != NULL)
+        {
+          g_cancellable_cancel (store->free_space_cancellable);
+          g_object_unref (store->free_space_cancellable);
+          store->free_space_cancellable = NULL;
+        }
+
+      /* remove hidden and filtered entries */
+      g_hash_table_remove_all (store->hidden);
+      row = g_sequence_get_begin_iter (store->filtered);
+      end = g_sequence_get_end_iter (store->filtered);
+      for (; row != end; row = g_sequence_iter_next (row))
+        thunar_list_model_untrack_row (store, g_sequence_get (row));
+      g_sequence_remove_range (g_sequence_get_begin_iter (store->filtered), end);
 
       /* unregister signals and drop the reference */
       g_signal_handlers_disconnect_matched (G_OBJECT (store->folder), G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, store);
@@ -1820,6 +2477,10 @@ thunar_list_model_set_folder (ThunarListModel *store,
   /* activate the new folder */
   store->folder = folder;
 
+  /* the filter was typed for the old folder */
+  g_free (store->filter);
+  store->filter = NULL;
+
   /* freeze */
   g_object_freeze_notify (G_OBJECT (store));
 
@@ -1831,8 +2492,12 @@ thunar_list_model_set_folder (ThunarListModel *store,
       /* get the already loaded files */
       files = thunar_folder_get_files (folder);
 
-      /* insert the files */
-      if (files != NULL)
+      /* insert the files, taking over the sorted rows of another
+       * model showing this folder (i.e. when switching the view) */
+      peer = thunar_list_model_find_sorted_peer (store, folder);
+      if (peer != NULL)
+        thunar_list_model_copy_rows (store, peer);
+      else if (files != NULL)
         thunar_list_model_files_added (folder, files, store);
 
       /* connect signals to the new folder */
@@ -1921,10 +2586,11 @@ void
 thunar_list_model_set_show_hidden (ThunarListModel *store,
                                    gboolean         show_hidden)
 {
+  GHashTableIter hidden_iter;
   GtkTreePath   *path;
   GtkTreeIter    iter;
   ThunarFile    *file;
-  GSList        *lp;
+  gpointer       key;
   GSequenceIter *row;
   GSequenceIter *next;
   GSequenceIter *end;
@@ -1939,13 +2605,25 @@ thunar_list_model_set_show_hidden (ThunarListModel *store,
 
   if (store->show_hidden)
     {
-      for (lp = store->hidden; lp != NULL; lp = lp->next)
+      g_hash_table_iter_init (&hidden_iter, store->hidden);
+      while (g_hash_table_iter_next (&hidden_iter, &key, NULL))
         {
-          file = THUNAR_FILE (lp->data);
+          file = THUNAR_FILE (key);
+
+          /* files not matching the filter stay invisible */
+          if (!thunar_list_model_filter_matches (store, file))
+            {
+              row = g_sequence_insert_sorted (store->filtered, file,
+                                              thunar_list_model_cmp_func, store);
+              thunar_list_model_track_row (store, file, row);
+              continue;
+            }
 
-          /* insert file in the sorted position */
+          /* insert file in the sorted position, rows takes over the reference */
           row = g_sequence_insert_sorted (store->rows, file,
                                           thunar_list_model_cmp_func, store);
+          thunar_list_model_track_row (store, file, row);
+          thunar_list_model_summary_add (store, file);
 
           GTK_TREE_ITER_INIT (iter, store->stamp, row);
 
@@ -1954,12 +2632,11 @@ thunar_list_model_set_show_hidden (ThunarListModel *store,
           gtk_tree_model_row_inserted (GTK_TREE_MODEL (store), path, &iter);
           gtk_tree_path_free (path);
         }
-      g_slist_free (store->hidden);
-      store->hidden = NULL;
+      g_hash_table_steal_all (store->hidden);
     }
   else
     {
-      _thunar_assert (store->hidden == NULL);
+      _thunar_assert (g_hash_table_size (store->hidden) == 0);
 
       /* remove all hidden files */
       row = g_sequence_get_begin_iter (store->rows);
@@ -1972,13 +2649,15 @@ thunar_list_model_set_show_hidden (ThunarListModel *store,
           file = g_sequence_get (row);
           if (thunar_file_is_hidden (file))
             {
-              /* store file in the list */
-              store->hidden = g_slist_prepend (store->hidden, g_object_ref (file));
+              /* store file in the hidden set */
+              g_hash_table_insert (store->hidden, g_object_ref (file), file);
+              thunar_list_model_untrack_row (store, file);
 
               /* setup path for "row-deleted" */
               path = gtk_tree_path_new_from_indices (g_sequence_iter_get_position (row), -1);
 
               /* remove file from the model */
+              thunar_list_model_summary_remove (store, file);
               g_sequence_remove (row);
 
               /* notify the view(s) */
@@ -1989,6 +2668,24 @@ thunar_list_model_set_show_hidden (ThunarListModel *store,
           row = next;
           _thunar_assert (end == g_sequence_get_end_iter (store->rows));
         }
+
+      /* the filtered files aren't shown, so just move them over */
+      row = g_sequence_get_begin_iter (store->filtered);
+      end = g_sequence_get_end_iter (store->filtered);
+      while (row != end)
+        {
+          next = g_sequence_iter_next (row);
+
+          file = g_sequence_get (row);
+          if (thunar_file_is_hidden (file))
+            {
+              g_hash_table_insert (store->hidden, g_object_ref (file), file);
+              thunar_list_model_untrack_row (store, file);
+              g_sequence_remove (row);
+            }
+
+          row = next;
+        }
     }
 
   /* notify listeners about the new setting */
@@ -2000,6 +2697,97 @@ thunar_list_model_set_show_hidden (ThunarListModel *store,
 
 
 
+/**
+ * thunar_list_model_get_filter:
+ * @store : a #ThunarListModel.
+ *
+ * Return value: the casefolded filter text of @store, or %NULL
+ *               if all files are shown.
+ **/
+const gchar*
+thunar_list_model_get_filter (ThunarListModel *store)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_LIST_MODEL (store), NULL);
+  return store->filter;
+}
+
+
+
+/**
+ * thunar_list_model_set_filter:
+ * @store  : a #ThunarListModel.
+ * @filter : the text typed by the user, or %NULL.
+ *
+ * Hides the rows whose display names don't contain @filter,
+ * ignoring case. The filter is reset when the folder changes.
+ *
+ * While the user types, each new filter usually contains the
+ * previous one, so only the visible rows are tested again.
+ * Likewise, a shorter filter only tests the filtered rows.
+ **/
+void
+thunar_list_model_set_filter (ThunarListModel *store,
+                              const gchar     *filter)
+{
+  GSequenceIter *row;
+  GSequenceIter *next;
+  GSequenceIter *end;
+  gboolean       narrowing;
+  gboolean       widening;
+  gchar         *old_filter;
+
+  _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
+  _thunar_return_if_fail (filter == NULL || g_utf8_validate (filter, -1, NULL));
+
+  old_filter = store->filter;
+  store->filter = (filter != NULL && *filter != '\0') ? g_utf8_casefold (filter, -1) : NULL;
+
+  /* check if the filter changed */
+  if (g_strcmp0 (old_filter, store->filter) == 0)
+    {
+      g_free (old_filter);
+      return;
+    }
+
+  /* a filter containing the old one can only hide more rows,
+   * and a filter contained in the old one can only show more */
+  narrowing = (old_filter == NULL || (store->filter != NULL && strstr (store->filter, old_filter) != NULL));
+  widening = (store->filter == NULL || (old_filter != NULL && strstr (old_filter, store->filter) != NULL));
+  g_free (old_filter);
+
+  if (!narrowing)
+    {
+      /* show the filtered rows matching the new filter */
+      row = g_sequence_get_begin_iter (store->filtered);
+      end = g_sequence_get_end_iter (store->filtered);
+      while (row != end)
+        {
+          next = g_sequence_iter_next (row);
+          if (thunar_list_model_filter_matches (store, g_sequence_get (row)))
+            thunar_list_model_unfilter_row (store, row);
+          row = next;
+        }
+    }
+
+  if (!widening)
+    {
+      /* hide the visible rows not matching the new filter */
+      row = g_sequence_get_begin_iter (store->rows);
+      end = g_sequence_get_end_iter (store->rows);
+      while (row != end)
+        {
+          next = g_sequence_iter_next (row);
+          if (!thunar_list_model_filter_matches (store, g_sequence_get (row)))
+            thunar_list_model_filter_row (store, row);
+          row = next;
+        }
+    }
+
+  g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_NUM_FILES]);
+}
+
+
+
 /**
  * thunar_list_model_get_file_size_binary:
  * @store : a valid #ThunarListModel object.
@@ -2098,6 +2886,194 @@ thunar_list_model_get_num_files (ThunarListModel *store)
 
 
 
+static void
+thunar_list_model_summary_add (ThunarListModel *store,
+                               ThunarFile      *file)
+{
+  guint64 *size;
+
+  _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
+  _thunar_return_if_fail (THUNAR_IS_FILE (file));
+
+  /* only regular files contribute to the size summary */
+  if (!thunar_file_is_regular (file))
+    return;
+
+  size = g_slice_new (guint64);
+  *size = thunar_file_get_size (file);
+  g_hash_table_insert (store->size_contributions, file, size);
+
+  store->size_summary += *size;
+}
+
+
+
+static void
+thunar_list_model_summary_remove (ThunarListModel *store,
+                                  ThunarFile      *file)
+{
+  guint64 *size;
+
+  _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
+
+  /* subtract what the file contributed when it was added */
+  size = g_hash_table_lookup (store->size_contributions, file);
+  if (size != NULL)
+    {
+      _thunar_assert (store->size_summary >= *size);
+      store->size_summary -= *size;
+      g_hash_table_remove (store->size_contributions, file);
+    }
+}
+
+
+
+static void
+thunar_list_model_summary_free (gpointer data)
+{
+  g_slice_free (guint64, data);
+}
+
+
+
+static void
+thunar_list_model_free_space_free (gpointer data)
+{
+  g_slice_free (ThunarListModelFreeSpace, data);
+}
+
+
+
+static void
+thunar_list_model_free_space_ready (GObject      *object,
+                                    GAsyncResult *result,
+                                    gpointer      user_data)
+{
+  ThunarListModelFreeSpaceQuery *query = user_data;
+  ThunarListModelFreeSpace      *entry = NULL;
+  ThunarListModel               *store = query->store;
+  GFileInfo                     *info;
+  GError                        *error = NULL;
+
+  _thunar_return_if_fail (G_IS_FILE (object));
+  _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (store));
+
+  info = g_file_query_filesystem_info_finish (G_FILE (object), result, &error);
+  if (info != NULL || !g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    {
+      /* remember the free space of the volume, also remember failed
+       * lookups so filesystems that do not report the free space are
+       * not queried again before the TTL expired */
+      entry = g_hash_table_lookup (free_space_cache, query->filesystem_id);
+      if (entry == NULL)
+        {
+          entry = g_slice_new (ThunarListModelFreeSpace);
+          g_hash_table_insert (free_space_cache, g_strdup (query->filesystem_id), entry);
+        }
+      entry->known = (info != NULL && g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_FILESYSTEM_FREE));
+      entry->free_space = entry->known ? g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_FILESYSTEM_FREE) : 0;
+      entry->timestamp = g_get_monotonic_time ();
+    }
+
+  if (info != NULL)
+    g_object_unref (info);
+  g_clear_error (&error);
+
+  /* check if this is still the active query of the store, the
+   * query was cancelled if the store changed the folder meanwhile */
+  if (store->free_space_cancellable == query->cancellable)
+    {
+      g_object_unref (store->free_space_cancellable);
+      store->free_space_cancellable = NULL;
+
+      /* the statusbar text may have changed */
+      if (entry != NULL && entry->known)
+        g_object_notify_by_pspec (G_OBJECT (store), list_model_props[PROP_FREE_SPACE]);
+    }
+
+  /* cleanup */
+  g_object_unref (query->cancellable);
+  g_object_unref (store);
+  g_free (query->filesystem_id);
+  g_slice_free (ThunarListModelFreeSpaceQuery, query);
+}
+
+
+
+/**
+ * thunar_list_model_get_free_space:
+ * @store             : a #ThunarListModel.
+ * @free_space_return : return location for the amount of free space.
+ *
+ * Looks up the amount of free space on the volume of the folder
+ * presented by @store in the free space cache. If the cached value
+ * is missing or older than %THUNAR_LIST_MODEL_FREE_SPACE_TTL, a new
+ * asynchronous query is started and "free-space" is notified once
+ * the result is known. A stale value is returned in the meantime.
+ *
+ * Return value: %TRUE if the amount of free space is known.
+ **/
+static gboolean
+thunar_list_model_get_free_space (ThunarListModel *store,
+                                  guint64         *free_space_return)
+{
+  ThunarListModelFreeSpaceQuery *query;
+  ThunarListModelFreeSpace      *entry;
+  ThunarFile                    *file;
+  const gchar                   *filesystem_id = NULL;
+  gchar                         *uri = NULL;
+
+  _thunar_return_val_if_fail (THUNAR_IS_LIST_MODEL (store), FALSE);
+
+  /* try to determine a file for the current folder */
+  file = (store->folder != NULL) ? thunar_folder_get_corresponding_file (store->folder) : NULL;
+  if (G_UNLIKELY (file == NULL))
+    return FALSE;
+
+  /* files on the same volume share the cached value */
+  if (thunar_file_get_info (file) != NULL)
+    filesystem_id = g_file_info_get_attribute_string (thunar_file_get_info (file), G_FILE_ATTRIBUTE_ID_FILESYSTEM);
+  if (G_UNLIKELY (filesystem_id == NULL))
+    filesystem_id = uri = thunar_file_dup_uri (file);
+
+  if (G_UNLIKELY (free_space_cache == NULL))
+    {
+      free_space_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                                thunar_list_model_free_space_free);
+    }
+
+  entry = g_hash_table_lookup (free_space_cache, filesystem_id);
+
+  /* refresh the cached value in the background if needed */
+  if ((entry == NULL || g_get_monotonic_time () - entry->timestamp > THUNAR_LIST_MODEL_FREE_SPACE_TTL)
+      && store->free_space_cancellable == NULL)
+    {
+      store->free_space_cancellable = g_cancellable_new ();
+
+      query = g_slice_new (ThunarListModelFreeSpaceQuery);
+      query->store = g_object_ref (store);
+      query->cancellable = g_object_ref (store->free_space_cancellable);
+      query->filesystem_id = g_strdup (filesystem_id);
+
+      g_file_query_filesystem_info_async (thunar_file_get_file (file),
+                                          G_FILE_ATTRIBUTE_FILESYSTEM_FREE,
+                                          G_PRIORITY_DEFAULT,
+                                          store->free_space_cancellable,
+                                          thunar_list_model_free_space_ready,
+                                          query);
+    }
+
+  g_free (uri);
+
+  if (entry == NULL || !entry->known)
+    return FALSE;
+
+  *free_space_return = entry->free_space;
+  return TRUE;
+}
+
+
+
 /**
  * thunar_list_model_get_paths_for_files:
  * @store : a #ThunarListModel instance.
@@ -2122,25 +3098,16 @@ thunar_list_model_get_paths_for_files (ThunarListModel *store,
 {
   GList         *paths = NULL;
   GSequenceIter *row;
-  GSequenceIter *end;
-  gint           i = 0;
+  GList         *lp;
 
   _thunar_return_val_if_fail (THUNAR_IS_LIST_MODEL (store), NULL);
 
-  row = g_sequence_get_begin_iter (store->rows);
-  end = g_sequence_get_end_iter (store->rows);
-
   /* find the rows for the given files */
-  while (row != end)
+  for (lp = files; lp != NULL; lp = lp->next)
     {
-      if (g_list_find (files, g_sequence_get (row)) != NULL)
-        {
-          _thunar_assert (i == g_sequence_iter_get_position (row));
-          paths = g_list_prepend (paths, gtk_tree_path_new_from_indices (i, -1));
-        }
-
-      row = g_sequence_iter_next (row);
-      i++;
+      row = g_hash_table_lookup (store->row_map, lp->data);
+      if (row != NULL && g_sequence_iter_get_sequence (row) == store->rows)
+        paths = g_list_prepend (paths, gtk_tree_path_new_from_indices (g_sequence_iter_get_position (row), -1));
     }
 
   return paths;
@@ -2248,8 +3215,6 @@ thunar_list_model_get_statusbar_text (ThunarListModel *store,
   gint               height;
   gint               width;
   gchar             *description;
-  GSequenceIter     *row;
-  GSequenceIter     *end;
   gint               nrows;
   ThunarPreferences *preferences;
   gboolean           show_image_size;
@@ -2261,30 +3226,16 @@ thunar_list_model_get_statusbar_text (ThunarListModel *store,
 
   if (selected_items == NULL)
     {
-      /* try to determine a file for the current folder */
-      file = (store->folder != NULL) ? thunar_folder_get_corresponding_file (store->folder) : NULL;
-
       nrows = g_sequence_get_length (store->rows);
 
-      /* check if we can determine the amount of free space for the volume */
-      if (G_LIKELY (file != NULL
-          && thunar_g_file_get_free_space (thunar_file_get_file (file), &size, NULL)))
+      /* check if we know the amount of free space for the volume */
+      if (G_LIKELY (thunar_list_model_get_free_space (store, &size)))
         {
           /* humanize the free space */
           fspace_string = g_format_size_full (size, file_size_binary ? G_FORMAT_SIZE_IEC_UNITS : G_FORMAT_SIZE_DEFAULT);
-          size_summary = 0;
 
-          row = g_sequence_get_begin_iter (store->rows);
-          end = g_sequence_get_end_iter (store->rows);
-
-          /* calculate the size of all file items */
-          while (row != end)
-            {
-              file = g_sequence_get (row);
-              if (thunar_file_is_regular (file))
-                size_summary += thunar_file_get_size (file);
-              row = g_sequence_iter_next (row);
-            }
+          /* the size of all file items is maintained while rows change */
+          size_summary = store->size_summary;
 
           if (size_summary > 0)
             {
@@ -49,6 +49,10 @@ gboolean         thunar_list_model_get_show_hidden        (ThunarListModel  *sto
 void             thunar_list_model_set_show_hidden        (ThunarListModel  *store,
                                                            gboolean          show_hidden);
 
+const gchar     *thunar_list_model_get_filter             (ThunarListModel  *store);
+void             thunar_list_model_set_filter             (ThunarListModel  *store,
+                                                           const gchar      *filter);
+
 gboolean         thunar_list_model_get_file_size_binary   (ThunarListModel  *store);
 void             thunar_list_model_set_file_size_binary   (ThunarListModel  *store,
                                                            gboolean          file_size_binary);
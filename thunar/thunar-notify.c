@@ -28,6 +28,7 @@
 
 #include <thunar/thunar-notify.h>
 #include <thunar/thunar-device.h>
+#include <thunar/thunar-gio-extensions.h>
 #include <thunar/thunar-private.h>
 
 
@@ -129,8 +130,8 @@ thunar_notify_device_readonly (ThunarDevice *device)
   mount_point = thunar_device_get_root (device);
   if (mount_point != NULL)
     {
-      info = g_file_query_info (mount_point, G_FILE_ATTRIBUTE_ACCESS_CAN_WRITE,
-                                G_FILE_QUERY_INFO_NONE, NULL, NULL);
+      info = thunar_g_file_query_info (mount_point, G_FILE_ATTRIBUTE_ACCESS_CAN_WRITE,
+                                       G_FILE_QUERY_INFO_NONE, NULL, NULL);
 
       if (info != NULL)
         {
@@ -52,6 +52,10 @@
 
 
 
+typedef struct _ThunarPathEntryResolve ThunarPathEntryResolve;
+
+
+
 enum
 {
   PROP_0,
@@ -91,12 +95,26 @@ static void     thunar_path_entry_drag_data_get                 (GtkWidget
                                                                  guint                 timestamp);
 static void     thunar_path_entry_activate                      (GtkEntry             *entry);
 static void     thunar_path_entry_changed                       (GtkEditable          *editable);
+static void     thunar_path_entry_resolve_free                  (ThunarPathEntryResolve *resolve);
+static void     thunar_path_entry_folder_ready                  (GFile                *location,
+                                                                 ThunarFile           *file,
+                                                                 GError               *error,
+                                                                 gpointer              user_data);
+static void     thunar_path_entry_file_ready                    (GFile                *location,
+                                                                 ThunarFile           *file,
+                                                                 GError               *error,
+                                                                 gpointer              user_data);
+static void     thunar_path_entry_set_files                     (ThunarPathEntry      *path_entry,
+                                                                 ThunarFile           *current_folder,
+                                                                 ThunarFile           *current_file);
 static void     thunar_path_entry_update_icon                   (ThunarPathEntry      *path_entry);
 static void     thunar_path_entry_do_insert_text                (GtkEditable          *editable,
                                                                  const gchar          *new_text,
                                                                  gint                  new_text_length,
                                                                  gint                 *position);
 static void     thunar_path_entry_clear_completion              (ThunarPathEntry      *path_entry);
+static void     thunar_path_entry_invalidate_names              (ThunarPathEntry      *path_entry);
+static void     thunar_path_entry_load_names                    (ThunarPathEntry      *path_entry);
 static void     thunar_path_entry_common_prefix_append          (ThunarPathEntry      *path_entry,
                                                                  gboolean              highlight);
 static void     thunar_path_entry_common_prefix_lookup          (ThunarPathEntry      *path_entry,
@@ -142,6 +160,36 @@ struct _ThunarPathEntry
   guint              in_change : 1;
   guint              has_completion : 1;
   guint              check_completion_idle_id;
+
+  /* the names in the completion model, sorted by name and
+   * by normalized name, loaded on demand */
+  ThunarListModel   *completion_model;
+  GPtrArray         *names;
+  GPtrArray         *names_normalized;
+
+  /* the files matching the entry text in match_func */
+  gchar             *match_text;
+  GHashTable        *match_files;
+
+  /* resolving the files for the entry text, an activation
+   * while resolving is delayed until the files are known */
+  GCancellable      *resolve_cancellable;
+  guint              activate_pending : 1;
+};
+
+typedef struct
+{
+  gchar      *name;
+  gchar      *normalized;
+  ThunarFile *file;
+} ThunarPathEntryName;
+
+struct _ThunarPathEntryResolve
+{
+  ThunarPathEntry *path_entry;
+  GCancellable    *cancellable;
+  GFile           *file_path;
+  ThunarFile      *current_folder;
 };
 
 
@@ -254,6 +302,12 @@ thunar_path_entry_init (ThunarPathEntry *path_entry)
   gtk_entry_completion_set_model (completion, GTK_TREE_MODEL (store));
   g_object_unref (G_OBJECT (store));
 
+  /* reload the sorted names once the model changes */
+  path_entry->completion_model = store;
+  g_signal_connect_swapped (G_OBJECT (store), "row-inserted", G_CALLBACK (thunar_path_entry_invalidate_names), path_entry);
+  g_signal_connect_swapped (G_OBJECT (store), "row-changed", G_CALLBACK (thunar_path_entry_invalidate_names), path_entry);
+  g_signal_connect_swapped (G_OBJECT (store), "row-deleted", G_CALLBACK (thunar_path_entry_invalidate_names), path_entry);
+
   /* need to connect the "key-press-event" before the GtkEntry class connects the completion signals, so
    * we get the Tab key before its handled as part of the completion stuff.
    */
@@ -281,6 +335,13 @@ thunar_path_entry_finalize (GObject *object)
 {
   ThunarPathEntry *path_entry = THUNAR_PATH_ENTRY (object);
 
+  /* stop resolving the entry text */
+  if (G_UNLIKELY (path_entry->resolve_cancellable != NULL))
+    {
+      g_cancellable_cancel (path_entry->resolve_cancellable);
+      g_object_unref (path_entry->resolve_cancellable);
+    }
+
   /* release factory */
   if (path_entry->icon_factory != NULL)
     g_object_unref (path_entry->icon_factory);
@@ -304,6 +365,11 @@ thunar_path_entry_finalize (GObject *object)
   if (G_UNLIKELY (path_entry->check_completion_idle_id != 0))
     g_source_remove (path_entry->check_completion_idle_id);
 
+  /* release the completion names */
+  g_signal_handlers_disconnect_matched (G_OBJECT (path_entry->completion_model), G_SIGNAL_MATCH_DATA,
+                                        0, 0, NULL, NULL, path_entry);
+  thunar_path_entry_invalidate_names (path_entry);
+
   (*G_OBJECT_CLASS (thunar_path_entry_parent_class)->finalize) (object);
 }
 
@@ -484,6 +550,16 @@ thunar_path_entry_key_press_event (GtkWidget   *widget,
       return TRUE;
     }
 
+  /* activate once the files for the entered text are known */
+  if (G_UNLIKELY (path_entry->resolve_cancellable != NULL
+                  && (event->keyval == GDK_KEY_Return
+                      || event->keyval == GDK_KEY_KP_Enter
+                      || event->keyval == GDK_KEY_ISO_Enter)))
+    {
+      path_entry->activate_pending = TRUE;
+      return TRUE;
+    }
+
   return FALSE;
 }
 
@@ -536,19 +612,14 @@ thunar_path_entry_activate (GtkEntry *entry)
 static void
 thunar_path_entry_changed (GtkEditable *editable)
 {
-  GtkEntryCompletion *completion;
-  ThunarPathEntry    *path_entry = THUNAR_PATH_ENTRY (editable);
-  ThunarFolder       *folder;
-  GtkTreeModel       *model;
-  const gchar        *text;
-  gchar              *escaped_text;
-  ThunarFile         *current_folder;
-  ThunarFile         *current_file;
-  GFile              *folder_path = NULL;
-  GFile              *file_path = NULL;
-  gchar              *folder_part = NULL;
-  gchar              *file_part = NULL;
-  gboolean            update_icon = FALSE;
+  ThunarPathEntryResolve *resolve;
+  ThunarPathEntry        *path_entry = THUNAR_PATH_ENTRY (editable);
+  const gchar            *text;
+  gchar                  *escaped_text;
+  GFile                  *folder_path = NULL;
+  GFile                  *file_path = NULL;
+  gchar                  *folder_part = NULL;
+  gchar                  *file_part = NULL;
 
   /* check if we should ignore this event */
   if (G_UNLIKELY (path_entry->in_change))
@@ -585,9 +656,120 @@ thunar_path_entry_changed (GtkEditable *editable)
       g_free (file_part);
     }
 
-  /* determine new current file/folder from the paths */
-  current_folder = (folder_path != NULL) ? thunar_file_get (folder_path, NULL) : NULL;
-  current_file = (file_path != NULL) ? thunar_file_get (file_path, NULL) : NULL;
+  /* stop resolving the previous text, an activation for it is dropped */
+  if (G_UNLIKELY (path_entry->resolve_cancellable != NULL))
+    {
+      g_cancellable_cancel (path_entry->resolve_cancellable);
+      g_object_unref (path_entry->resolve_cancellable);
+      path_entry->resolve_cancellable = NULL;
+      path_entry->activate_pending = FALSE;
+    }
+
+  if (G_UNLIKELY (folder_path == NULL || file_path == NULL))
+    {
+      thunar_path_entry_set_files (path_entry, NULL, NULL);
+    }
+  else
+    {
+      /* resolve the folder and then the file, without blocking on slow
+       * mounts; files in the cache are returned right away */
+      resolve = g_slice_new0 (ThunarPathEntryResolve);
+      resolve->path_entry = path_entry;
+      resolve->cancellable = g_cancellable_new ();
+      resolve->file_path = g_object_ref (file_path);
+      path_entry->resolve_cancellable = g_object_ref (resolve->cancellable);
+      thunar_file_get_async (folder_path, resolve->cancellable, thunar_path_entry_folder_ready, resolve);
+    }
+
+  /* cleanup */
+  if (G_LIKELY (folder_path != NULL))
+    g_object_unref (folder_path);
+  if (G_LIKELY (file_path != NULL))
+    g_object_unref (file_path);
+}
+
+
+
+static void
+thunar_path_entry_resolve_free (ThunarPathEntryResolve *resolve)
+{
+  if (resolve->current_folder != NULL)
+    g_object_unref (resolve->current_folder);
+  g_object_unref (resolve->file_path);
+  g_object_unref (resolve->cancellable);
+  g_slice_free (ThunarPathEntryResolve, resolve);
+}
+
+
+
+static void
+thunar_path_entry_folder_ready (GFile      *location,
+                                ThunarFile *file,
+                                GError     *error,
+                                gpointer    user_data)
+{
+  ThunarPathEntryResolve *resolve = user_data;
+
+  /* the entry text changed or the entry is gone */
+  if (g_cancellable_is_cancelled (resolve->cancellable))
+    {
+      thunar_path_entry_resolve_free (resolve);
+      return;
+    }
+
+  if (G_LIKELY (error == NULL))
+    resolve->current_folder = g_object_ref (file);
+
+  /* the file is the folder if the text ends with a slash */
+  if (g_file_equal (location, resolve->file_path))
+    thunar_path_entry_file_ready (location, file, error, resolve);
+  else
+    thunar_file_get_async (resolve->file_path, resolve->cancellable, thunar_path_entry_file_ready, resolve);
+}
+
+
+
+static void
+thunar_path_entry_file_ready (GFile      *location,
+                              ThunarFile *file,
+                              GError     *error,
+                              gpointer    user_data)
+{
+  ThunarPathEntryResolve *resolve = user_data;
+  ThunarPathEntry        *path_entry = resolve->path_entry;
+
+  if (G_LIKELY (!g_cancellable_is_cancelled (resolve->cancellable)))
+    {
+      _thunar_assert (path_entry->resolve_cancellable == resolve->cancellable);
+
+      g_object_unref (path_entry->resolve_cancellable);
+      path_entry->resolve_cancellable = NULL;
+
+      thunar_path_entry_set_files (path_entry, resolve->current_folder,
+                                   (error == NULL) ? file : NULL);
+
+      /* activate the entry if return was pressed while resolving */
+      if (G_UNLIKELY (path_entry->activate_pending))
+        {
+          path_entry->activate_pending = FALSE;
+          gtk_widget_activate (GTK_WIDGET (path_entry));
+        }
+    }
+
+  thunar_path_entry_resolve_free (resolve);
+}
+
+
+
+static void
+thunar_path_entry_set_files (ThunarPathEntry *path_entry,
+                             ThunarFile      *current_folder,
+                             ThunarFile      *current_file)
+{
+  GtkEntryCompletion *completion;
+  ThunarFolder       *folder;
+  GtkTreeModel       *model;
+  gboolean            update_icon = FALSE;
 
   /* determine the entry completion */
   completion = gtk_entry_get_completion (GTK_ENTRY (path_entry));
@@ -615,7 +797,13 @@ thunar_path_entry_changed (GtkEditable *editable)
       model = gtk_entry_completion_get_model (completion);
       g_object_ref (G_OBJECT (model));
       gtk_entry_completion_set_model (completion, NULL);
+
+      /* don't invalidate per row, so the model replaces its rows at once */
+      g_signal_handlers_block_by_func (G_OBJECT (model), thunar_path_entry_invalidate_names, path_entry);
       thunar_list_model_set_folder (THUNAR_LIST_MODEL (model), folder);
+      g_signal_handlers_unblock_by_func (G_OBJECT (model), thunar_path_entry_invalidate_names, path_entry);
+      thunar_path_entry_invalidate_names (path_entry);
+
       gtk_entry_completion_set_model (completion, model);
       g_object_unref (G_OBJECT (model));
 
@@ -649,16 +837,6 @@ thunar_path_entry_changed (GtkEditable *editable)
 
   if (update_icon)
     thunar_path_entry_update_icon (path_entry);
-
-  /* cleanup */
-  if (G_LIKELY (current_folder != NULL))
-    g_object_unref (G_OBJECT (current_folder));
-  if (G_LIKELY (current_file != NULL))
-    g_object_unref (G_OBJECT (current_file));
-  if (G_LIKELY (folder_path != NULL))
-    g_object_unref (folder_path);
-  if (G_LIKELY (file_path != NULL))
-    g_object_unref (file_path);
 }
 
 
@@ -814,17 +992,153 @@ thunar_path_entry_common_prefix_append (ThunarPathEntry *path_entry,
 
 
 
+static void
+thunar_path_entry_invalidate_names (ThunarPathEntry *path_entry)
+{
+  ThunarPathEntryName *entry;
+  guint                n;
+
+  /* release the sorted names */
+  if (path_entry->names != NULL)
+    {
+      for (n = 0; n < path_entry->names->len; ++n)
+        {
+          entry = g_ptr_array_index (path_entry->names, n);
+          if (entry->normalized != entry->name)
+            g_free (entry->normalized);
+          g_free (entry->name);
+          g_object_unref (G_OBJECT (entry->file));
+          g_slice_free (ThunarPathEntryName, entry);
+        }
+
+      g_ptr_array_free (path_entry->names, TRUE);
+      g_ptr_array_free (path_entry->names_normalized, TRUE);
+      path_entry->names = NULL;
+      path_entry->names_normalized = NULL;
+    }
+
+  /* release the files matched for the entry text */
+  if (path_entry->match_files != NULL)
+    {
+      g_hash_table_destroy (path_entry->match_files);
+      path_entry->match_files = NULL;
+    }
+
+  g_free (path_entry->match_text);
+  path_entry->match_text = NULL;
+}
+
+
+
+static gint
+thunar_path_entry_names_compare (gconstpointer a,
+                                 gconstpointer b)
+{
+  return strcmp ((*(ThunarPathEntryName **) a)->name, (*(ThunarPathEntryName **) b)->name);
+}
+
+
+
+static gint
+thunar_path_entry_names_compare_normalized (gconstpointer a,
+                                            gconstpointer b)
+{
+  return strcmp ((*(ThunarPathEntryName **) a)->normalized, (*(ThunarPathEntryName **) b)->normalized);
+}
+
+
+
+static void
+thunar_path_entry_load_names (ThunarPathEntry *path_entry)
+{
+  ThunarPathEntryName *entry;
+  GtkTreeModel        *model = GTK_TREE_MODEL (path_entry->completion_model);
+  GtkTreeIter          iter;
+
+  /* check if the names are loaded already */
+  if (G_LIKELY (path_entry->names != NULL))
+    return;
+
+  path_entry->names = g_ptr_array_new ();
+  path_entry->names_normalized = g_ptr_array_new ();
+
+  /* collect the names of all files in the model */
+  if (gtk_tree_model_get_iter_first (model, &iter))
+    {
+      do
+        {
+          entry = g_slice_new (ThunarPathEntryName);
+          gtk_tree_model_get (model, &iter, THUNAR_COLUMN_FILE, &entry->file, -1);
+          entry->name = g_strdup (thunar_file_get_basename (entry->file));
+          entry->normalized = g_utf8_normalize (entry->name, -1, G_NORMALIZE_ALL);
+          if (G_UNLIKELY (entry->normalized == NULL))
+            entry->normalized = entry->name;
+
+          g_ptr_array_add (path_entry->names, entry);
+          g_ptr_array_add (path_entry->names_normalized, entry);
+        }
+      while (gtk_tree_model_iter_next (model, &iter));
+    }
+
+  /* sort them for prefix lookups */
+  g_ptr_array_sort (path_entry->names, thunar_path_entry_names_compare);
+  g_ptr_array_sort (path_entry->names_normalized, thunar_path_entry_names_compare_normalized);
+}
+
+
+
+static void
+thunar_path_entry_names_lookup (GPtrArray   *names,
+                                gboolean     normalized,
+                                const gchar *prefix,
+                                guint       *first_return,
+                                guint       *last_return)
+{
+  ThunarPathEntryName *entry;
+  gsize                length = strlen (prefix);
+  guint                lower;
+  guint                upper;
+  guint                mid;
+
+  /* find the first name that is not smaller than the prefix */
+  for (lower = 0, upper = names->len; lower < upper; )
+    {
+      mid = (lower + upper) / 2;
+      entry = g_ptr_array_index (names, mid);
+      if (strcmp (normalized ? entry->normalized : entry->name, prefix) < 0)
+        lower = mid + 1;
+      else
+        upper = mid;
+    }
+  *first_return = lower;
+
+  /* find the first name after it that does not start with the prefix */
+  for (upper = names->len; lower < upper; )
+    {
+      mid = (lower + upper) / 2;
+      entry = g_ptr_array_index (names, mid);
+      if (strncmp (normalized ? entry->normalized : entry->name, prefix, length) <= 0)
+        lower = mid + 1;
+      else
+        upper = mid;
+    }
+  *last_return = lower;
+}
+
+
+
 static void
 thunar_path_entry_common_prefix_lookup (ThunarPathEntry *path_entry,
                                         gchar          **prefix_return,
                                         ThunarFile     **file_return)
 {
-  GtkTreeModel *model;
-  GtkTreeIter   iter;
-  const gchar  *text;
-  const gchar  *s;
-  gchar        *name;
-  gchar        *t;
+  ThunarPathEntryName *first;
+  ThunarPathEntryName *last;
+  const gchar         *text;
+  const gchar         *s;
+  const gchar         *t;
+  guint                n_first;
+  guint                n_last;
 
   *prefix_return = NULL;
   *file_return = NULL;
@@ -837,48 +1151,22 @@ thunar_path_entry_common_prefix_lookup (ThunarPathEntry *path_entry,
   else if (G_LIKELY (s != NULL))
     text = s + 1;
 
-  /* check all items in the model */
-  model = gtk_entry_completion_get_model (gtk_entry_get_completion (GTK_ENTRY (path_entry)));
-  if (gtk_tree_model_get_iter_first (model, &iter))
-    {
-      do 
-        {
-          /* determine the real file name for the iter */
-          gtk_tree_model_get (model, &iter, THUNAR_COLUMN_FILE_NAME, &name, -1);
+  /* lookup the range of names starting with the text */
+  thunar_path_entry_load_names (path_entry);
+  thunar_path_entry_names_lookup (path_entry->names, FALSE, text, &n_first, &n_last);
+  if (n_first == n_last)
+    return;
 
-          /* check if we have a valid prefix here */
-          if (g_str_has_prefix (name, text))
-            {
-              /* check if we're the first to match */
-              if (*prefix_return == NULL)
-                {
-                  /* remember the prefix */
-                  *prefix_return = g_strdup (name);
-                  
-                  /* determine the file for the iter */
-                  gtk_tree_model_get (model, &iter, THUNAR_COLUMN_FILE, file_return, -1);
-                }
-              else
-                {
-                  /* we already have another prefix, so determine the common part */
-                  for (s = name, t = *prefix_return; *s != '\0' && *s == *t; ++s, ++t)
-                    ;
-                  *t = '\0';
-
-                  /* release the file, since it's not a unique match */
-                  if (G_LIKELY (*file_return != NULL))
-                    {
-                      g_object_unref (G_OBJECT (*file_return));
-                      *file_return = NULL;
-                    }
-                }
-            }
+  /* the common prefix of the sorted range is the common prefix of its bounds */
+  first = g_ptr_array_index (path_entry->names, n_first);
+  last = g_ptr_array_index (path_entry->names, n_last - 1);
+  for (s = first->name, t = last->name; *s != '\0' && *s == *t; ++s, ++t)
+    ;
+  *prefix_return = g_strndup (first->name, s - first->name);
 
-          /* cleanup */
-          g_free (name);
-        }
-      while (gtk_tree_model_iter_next (model, &iter));
-    }
+  /* remember the file, if it's a unique match */
+  if (n_last - n_first == 1)
+    *file_return = g_object_ref (G_OBJECT (first->file));
 }
 
 
@@ -889,13 +1177,15 @@ thunar_path_entry_match_func (GtkEntryCompletion *completion,
                               GtkTreeIter        *iter,
                               gpointer            user_data)
 {
-  GtkTreeModel *model;
-  const gchar  *last_slash;
-  ThunarFile   *file;
-  gboolean      matched;
-  gchar        *text_normalized;
-  gchar        *name_normalized;
-  gchar        *name;
+  ThunarPathEntry *path_entry = THUNAR_PATH_ENTRY (user_data);
+  GtkTreeModel    *model;
+  const gchar     *last_slash;
+  const gchar     *text;
+  ThunarFile      *file;
+  gboolean         matched;
+  gchar           *text_normalized;
+  guint            n_first;
+  guint            n_last;
 
   /* determine the model from the completion */
   model = gtk_entry_completion_get_model (completion);
@@ -905,45 +1195,56 @@ thunar_path_entry_match_func (GtkEntryCompletion *completion,
   if (G_UNLIKELY (model == NULL))
     return FALSE;
 
-  /* determine the current text (UTF-8 normalized) */
-  text_normalized = g_utf8_normalize (gtk_entry_get_text (GTK_ENTRY (user_data)), -1, G_NORMALIZE_ALL);
-
-  /* lookup the last slash character in the key */
-  last_slash = strrchr (text_normalized, G_DIR_SEPARATOR);
-  if (G_UNLIKELY (last_slash != NULL && last_slash[1] == '\0'))
-    {
-      /* check if the file is hidden */
-      gtk_tree_model_get (model, iter, THUNAR_COLUMN_FILE, &file, -1);
-      matched = !thunar_file_is_hidden (file);
-      g_object_unref (G_OBJECT (file));
-    }
-  else
+  /* the matching files only change with the text, so they're collected
+   * once per text with a lookup in the sorted names instead of
+   * comparing the text with every row */
+  text = gtk_entry_get_text (GTK_ENTRY (path_entry));
+  if (path_entry->match_files == NULL || g_strcmp0 (path_entry->match_text, text) != 0)
     {
-      if (G_UNLIKELY (last_slash == NULL))
-        last_slash = text_normalized;
-      else
-        last_slash += 1;
+      g_free (path_entry->match_text);
+      path_entry->match_text = g_strdup (text);
 
-      /* determine the real file name for the iter */
-      gtk_tree_model_get (model, iter, THUNAR_COLUMN_FILE_NAME, &name, -1);
-      name_normalized = g_utf8_normalize (name, -1, G_NORMALIZE_ALL);
-      if (G_LIKELY (name_normalized != NULL))
-        g_free (name);
+      if (path_entry->match_files == NULL)
+        path_entry->match_files = g_hash_table_new (g_direct_hash, g_direct_equal);
       else
-        name_normalized = name;
+        g_hash_table_remove_all (path_entry->match_files);
 
-      /* check if we have a match here */
-      if (name_normalized != NULL)
-        matched = g_str_has_prefix (name_normalized, last_slash);
-      else
-        matched = FALSE;
+      /* determine the current text (UTF-8 normalized) */
+      text_normalized = g_utf8_normalize (text, -1, G_NORMALIZE_ALL);
 
-      /* cleanup */
-      g_free (name_normalized);
+      /* lookup the last slash character in the key, if the text ends with a
+       * slash every non-hidden file matches, which is checked below */
+      last_slash = strrchr (text_normalized, G_DIR_SEPARATOR);
+      if (G_LIKELY (last_slash == NULL || last_slash[1] != '\0'))
+        {
+          if (G_UNLIKELY (last_slash == NULL))
+            last_slash = text_normalized;
+          else
+            last_slash += 1;
+
+          /* collect the files whose normalized name starts with the text */
+          thunar_path_entry_load_names (path_entry);
+          thunar_path_entry_names_lookup (path_entry->names_normalized, TRUE, last_slash, &n_first, &n_last);
+          for (; n_first < n_last; ++n_first)
+            {
+              file = ((ThunarPathEntryName *) g_ptr_array_index (path_entry->names_normalized, n_first))->file;
+              g_hash_table_insert (path_entry->match_files, file, file);
+            }
+        }
+
+      g_free (text_normalized);
     }
 
-  /* cleanup */
-  g_free (text_normalized);
+  gtk_tree_model_get (model, iter, THUNAR_COLUMN_FILE, &file, -1);
+
+  /* check if the file is hidden or matches the text */
+  last_slash = strrchr (text, G_DIR_SEPARATOR);
+  if (G_UNLIKELY (last_slash != NULL && last_slash[1] == '\0'))
+    matched = !thunar_file_is_hidden (file);
+  else
+    matched = g_hash_table_lookup (path_entry->match_files, file) != NULL;
+
+  g_object_unref (G_OBJECT (file));
 
   return matched;
 }
@@ -83,6 +83,12 @@ enum
   PROP_MISC_MIDDLE_CLICK_IN_TAB,
   PROP_MISC_RECURSIVE_PERMISSIONS,
   PROP_MISC_REMEMBER_GEOMETRY,
+  PROP_MISC_SEARCH_INDEX,
+  PROP_MISC_SEARCH_INDEX_MAX_MEMORY,
+  PROP_MISC_SEARCH_INDEX_RESCAN_INTERVAL,
+  PROP_MISC_SEARCH_INDEX_ROOTS,
+  PROP_MISC_SEARCH_MAX_DEPTH,
+  PROP_MISC_SEARCH_THREADS,
   PROP_MISC_SHOW_ABOUT_TEMPLATES,
   PROP_MISC_SINGLE_CLICK,
   PROP_MISC_SINGLE_CLICK_TIMEOUT,
@@ -90,6 +96,8 @@ enum
   PROP_MISC_TAB_CLOSE_MIDDLE_CLICK,
   PROP_MISC_TEXT_BESIDE_ICONS,
   PROP_MISC_THUMBNAIL_MODE,
+  PROP_MISC_THUMBNAIL_PREFETCH_PAGES,
+  PROP_MISC_TYPE_TO_FILTER,
   PROP_MISC_FILE_SIZE_BINARY,
   PROP_SHORTCUTS_ICON_EMBLEMS,
   PROP_SHORTCUTS_ICON_SIZE,
@@ -602,6 +610,86 @@ thunar_preferences_class_init (ThunarPreferencesClass *klass)
                             TRUE,
                             EXO_PARAM_READWRITE);
 
+  /**
+   * ThunarPreferences:misc-search-index:
+   *
+   * Whether Thunar should keep an index of the file names below
+   * "misc-search-index-roots" in the background. "Search Files"
+   * answers from the index for folders that are indexed.
+   **/
+  preferences_props[PROP_MISC_SEARCH_INDEX] =
+      g_param_spec_boolean ("misc-search-index",
+                            NULL,
+                            NULL,
+                            FALSE,
+                            EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-search-index-max-memory:
+   *
+   * The memory in MiB the search index may use, including the
+   * new index built while the folders are checked again. Folders
+   * that don't fit anymore are searched on disk.
+   **/
+  preferences_props[PROP_MISC_SEARCH_INDEX_MAX_MEMORY] =
+      g_param_spec_uint ("misc-search-index-max-memory",
+                         NULL,
+                         NULL,
+                         1u, 4096u, 256u,
+                         EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-search-index-rescan-interval:
+   *
+   * The interval in minutes between two checks of all indexed
+   * folders for changes the folder monitors didn't report.
+   **/
+  preferences_props[PROP_MISC_SEARCH_INDEX_RESCAN_INTERVAL] =
+      g_param_spec_uint ("misc-search-index-rescan-interval",
+                         NULL,
+                         NULL,
+                         1u, 10080u, 60u,
+                         EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-search-index-roots:
+   *
+   * A semicolon separated list of absolute paths to index. If
+   * empty, the home folder and the mounted volumes are indexed.
+   **/
+  preferences_props[PROP_MISC_SEARCH_INDEX_ROOTS] =
+      g_param_spec_string ("misc-search-index-roots",
+                           NULL,
+                           NULL,
+                           "",
+                           EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-search-max-depth:
+   *
+   * The maximum number of folder levels below the current folder
+   * searched by "Search Files". A value of %0 searches all levels.
+   **/
+  preferences_props[PROP_MISC_SEARCH_MAX_DEPTH] =
+      g_param_spec_uint ("misc-search-max-depth",
+                         NULL,
+                         NULL,
+                         0u, G_MAXUINT, 0u,
+                         EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-search-threads:
+   *
+   * The number of threads scanning folders in parallel when
+   * searching files.
+   **/
+  preferences_props[PROP_MISC_SEARCH_THREADS] =
+      g_param_spec_uint ("misc-search-threads",
+                         NULL,
+                         NULL,
+                         1u, 64u, 4u,
+                         EXO_PARAM_READWRITE);
+
   /**
    * ThunarPreferences:misc-show-about-templates:
    *
@@ -693,6 +781,33 @@ thunar_preferences_class_init (ThunarPreferencesClass *klass)
                          THUNAR_THUMBNAIL_MODE_ONLY_LOCAL,
                          EXO_PARAM_READWRITE);
 
+  /**
+   * ThunarPreferences:misc-thumbnail-prefetch-pages:
+   *
+   * The number of pages, in multiples of the visible range of a
+   * view, for which thumbnails are requested ahead of the viewport
+   * in scroll direction. A value of %0 disables prefetching.
+   **/
+  preferences_props[PROP_MISC_THUMBNAIL_PREFETCH_PAGES] =
+      g_param_spec_uint ("misc-thumbnail-prefetch-pages",
+                         NULL,
+                         NULL,
+                         0u, 10u, 1u,
+                         EXO_PARAM_READWRITE);
+
+  /**
+   * ThunarPreferences:misc-type-to-filter:
+   *
+   * Whether typing in a view hides the files whose names don't
+   * contain the typed text, instead of jumping to the first match.
+   **/
+  preferences_props[PROP_MISC_TYPE_TO_FILTER] =
+      g_param_spec_boolean ("misc-type-to-filter",
+                            NULL,
+                            NULL,
+                            FALSE,
+                            EXO_PARAM_READWRITE);
+
   /**
    * ThunarPreferences:misc-file-size-binary:
    *
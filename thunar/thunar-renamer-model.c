@@ -39,6 +39,9 @@
 
 #define THUNAR_RENAMER_MODEL_ITEM(item) ((ThunarRenamerModelItem *) (item))
 
+/* maximum time spent per update idle iteration, in microseconds */
+#define THUNAR_RENAMER_MODEL_UPDATE_SLICE (G_USEC_PER_SEC / 100)
+
 
 
 /* Property identifiers */
@@ -110,10 +113,10 @@ static void                    thunar_renamer_model_file_destroyed      (ThunarR
                                                                          ThunarFile              *file,
                                                                          ThunarFileMonitor       *file_monitor);
 static void                    thunar_renamer_model_invalidate_all      (ThunarRenamerModel      *renamer_model);
+static void                    thunar_renamer_model_notify_busy         (ThunarRenamerModel      *renamer_model);
 static void                    thunar_renamer_model_invalidate_item     (ThunarRenamerModel      *renamer_model,
                                                                          ThunarRenamerModelItem  *item);
-static gboolean                thunar_renamer_model_conflict_item       (ThunarRenamerModel      *renamer_model,
-                                                                         ThunarRenamerModelItem  *item);
+static void                    thunar_renamer_model_update_conflicts    (ThunarRenamerModel      *renamer_model);
 static gchar                  *thunar_renamer_model_process_item        (ThunarRenamerModel      *renamer_model,
                                                                          ThunarRenamerModelItem  *item,
                                                                          guint                    idx);
@@ -160,11 +163,20 @@ struct _ThunarRenamerModel
 
   /* the idle source used to update the model */
   guint              update_idle_id;
+
+  /* the position of the update idle source in the items
+   * list, the walk restarts from the beginning whenever
+   * update_restart is set (i.e. an item was invalidated).
+   */
+  GList             *update_lp;
+  guint              update_idx;
+  gboolean           update_restart;
 };
 
 struct _ThunarRenamerModelItem
 {
   ThunarFile *file;
+  GFile      *parent;       /* the parent directory, used for conflict detection */
   gchar      *name;
   guint64     date_changed;
   guint       changed : 1;  /* if the file changed */
@@ -699,6 +711,9 @@ thunar_renamer_model_invalidate_all (ThunarRenamerModel *renamer_model)
 {
   GList *lp;
 
+  /* the items list may have changed, restart the update */
+  renamer_model->update_restart = TRUE;
+
   /* invalidate all items in the model */
   for (lp = renamer_model->items; lp != NULL; lp = lp->next)
     thunar_renamer_model_invalidate_item (renamer_model, lp->data);
@@ -706,6 +721,18 @@ thunar_renamer_model_invalidate_all (ThunarRenamerModel *renamer_model)
 
 
 
+static void
+thunar_renamer_model_notify_busy (ThunarRenamerModel *renamer_model)
+{
+  _thunar_return_if_fail (THUNAR_IS_RENAMER_MODEL (renamer_model));
+
+  /* the renamer emits "changed" once it is done, we only
+   * need to update the sensitivity of the rename button */
+  g_object_notify (G_OBJECT (renamer_model), "can-rename");
+}
+
+
+
 static void
 thunar_renamer_model_invalidate_item (ThunarRenamerModel     *renamer_model,
                                       ThunarRenamerModelItem *item)
@@ -713,6 +740,9 @@ thunar_renamer_model_invalidate_item (ThunarRenamerModel     *renamer_model,
   /* mark the item as dirty */
   item->dirty = TRUE;
 
+  /* make sure the update idle source rescans the whole list */
+  renamer_model->update_restart = TRUE;
+
   /* check if the update idle source is already running and not frozen */
   if (G_UNLIKELY (renamer_model->update_idle_id == 0 && !renamer_model->frozen))
     {
@@ -727,75 +757,93 @@ thunar_renamer_model_invalidate_item (ThunarRenamerModel     *renamer_model,
 
 
 
-static gboolean
-trm_same_directory (ThunarFile *a,
-                    ThunarFile *b)
+static const gchar*
+trm_item_get_name (const ThunarRenamerModelItem *item)
 {
-  GFile    *parent_a;
-  GFile    *parent_b;
-  gboolean  result;
+  return (item->name != NULL) ? item->name : thunar_file_get_display_name (item->file);
+}
 
-  /* determine the parent paths for both files */
-  parent_a = g_file_get_parent (thunar_file_get_file (a));
-  parent_b = g_file_get_parent (thunar_file_get_file (b));
 
-  /* check if both files have the same parent */
-  result = (parent_a != NULL && parent_b != NULL && g_file_equal (parent_a, parent_b));
 
-  if (parent_a != NULL)
-    g_object_unref (parent_a);
-  if (parent_b != NULL)
-    g_object_unref (parent_b);
+static guint
+trm_item_hash (gconstpointer data)
+{
+  const ThunarRenamerModelItem *item = data;
 
-  return result;
+  return g_file_hash (item->parent) ^ g_str_hash (trm_item_get_name (item));
 }
 
 
 
 static gboolean
-thunar_renamer_model_conflict_item (ThunarRenamerModel     *renamer_model,
-                                    ThunarRenamerModelItem *item)
+trm_item_equal (gconstpointer a,
+                gconstpointer b)
 {
-  ThunarRenamerModelItem *oitem;
+  const ThunarRenamerModelItem *item_a = a;
+  const ThunarRenamerModelItem *item_b = b;
+
+  return strcmp (trm_item_get_name (item_a), trm_item_get_name (item_b)) == 0
+      && g_file_equal (item_a->parent, item_b->parent);
+}
+
+
+
+static void
+thunar_renamer_model_update_conflicts (ThunarRenamerModel *renamer_model)
+{
+  ThunarRenamerModelItem *item;
   GtkTreePath            *path;
   GtkTreeIter             iter;
-  gboolean                conflict = FALSE;
+  GHashTable             *names;
+  gboolean                conflict;
+  guint                   value;
+  guint                   idx;
   GList                  *lp;
 
+  /* count the items per (directory, resulting name) pair, the lowest bit
+   * of the value is set if any of these items is going to be renamed */
+  names = g_hash_table_new (trm_item_hash, trm_item_equal);
   for (lp = renamer_model->items; lp != NULL; lp = lp->next)
     {
-      /* check if this item is dirty or the item we're about to check */
-      oitem = THUNAR_RENAMER_MODEL_ITEM (lp->data);
-      if (G_UNLIKELY (oitem == item || oitem->dirty))
+      item = THUNAR_RENAMER_MODEL_ITEM (lp->data);
+      if (G_UNLIKELY (item->parent == NULL))
         continue;
 
-      /* check if this other item conflicts with the item in question (can only conflict if in same directory) */
-      if (trm_same_directory (item->file, oitem->file)
-          && ((item->name != NULL && oitem->name == NULL && strcmp (item->name, thunar_file_get_display_name (oitem->file)) == 0)
-           || (item->name == NULL && oitem->name != NULL && strcmp (thunar_file_get_display_name (item->file), oitem->name) == 0)
-           || (item->name != NULL && oitem->name != NULL && strcmp (item->name, oitem->name) == 0)))
-        {
-          /* check if the other item is already in conflict state */
-          if (G_LIKELY (!oitem->conflict))
-            {
-              /* set to conflict state */
-              oitem->conflict = TRUE;
-
-              /* determine iter for other item */
-              GTK_TREE_ITER_INIT (iter, renamer_model->stamp, lp);
+      value = GPOINTER_TO_UINT (g_hash_table_lookup (names, item)) + 2;
+      if (item->name != NULL)
+        value |= 1;
+      g_hash_table_insert (names, item, GUINT_TO_POINTER (value));
+    }
 
-              /* emit "row-changed" for the other item */
-              path = gtk_tree_model_get_path (GTK_TREE_MODEL (renamer_model), &iter);
-              gtk_tree_model_row_changed (GTK_TREE_MODEL (renamer_model), path, &iter);
-              gtk_tree_path_free (path);
-            }
+  /* an item conflicts if another item in the same directory ends
+   * up with the same name and atleast one of them is renamed */
+  for (idx = 0, lp = renamer_model->items; lp != NULL; ++idx, lp = lp->next)
+    {
+      item = THUNAR_RENAMER_MODEL_ITEM (lp->data);
+      if (G_LIKELY (item->parent != NULL))
+        {
+          value = GPOINTER_TO_UINT (g_hash_table_lookup (names, item));
+          conflict = (value > 3 && (value & 1) != 0);
+        }
+      else
+        {
+          conflict = FALSE;
+        }
 
-          /* this item conflicts */
-          conflict = TRUE;
+      if (item->conflict != conflict)
+        {
+          /* apply the new state */
+          item->conflict = conflict;
+
+          /* emit "row-changed" for this item */
+          GTK_TREE_ITER_INIT (iter, renamer_model->stamp, lp);
+          path = gtk_tree_path_new_from_indices (idx, -1);
+          gtk_tree_model_row_changed (GTK_TREE_MODEL (renamer_model), path, &iter);
+          gtk_tree_path_free (path);
         }
     }
 
-  return conflict;
+  g_hash_table_destroy (names);
 }
 
 
@@ -893,8 +941,9 @@ thunar_renamer_model_update_idle (gpointer user_data)
   ThunarRenamerModel     *renamer_model = THUNAR_RENAMER_MODEL (user_data);
   GtkTreePath            *path;
   GtkTreeIter             iter;
-  gboolean                changed = FALSE;
-  gboolean                conflict;
+  gboolean                changed;
+  gboolean                done = TRUE;
+  gint64                  deadline;
   guint                   idx;
   gchar                  *name;
   GList                  *lp;
@@ -904,9 +953,27 @@ thunar_renamer_model_update_idle (gpointer user_data)
   /* don't do anything if the model is frozen */
   if (G_LIKELY (!renamer_model->frozen))
     {
-      /* process the first dirty item */
-      for (idx = 0, lp = renamer_model->items; !changed && lp != NULL; ++idx, lp = lp->next)
+      /* process dirty items until the time slice is used up */
+      deadline = g_get_monotonic_time () + THUNAR_RENAMER_MODEL_UPDATE_SLICE;
+      for (;;)
         {
+          /* start over if items were invalidated in the meantime */
+          if (G_UNLIKELY (renamer_model->update_restart))
+            {
+              renamer_model->update_restart = FALSE;
+              renamer_model->update_lp = renamer_model->items;
+              renamer_model->update_idx = 0;
+            }
+
+          /* check if we're done with the list */
+          lp = renamer_model->update_lp;
+          if (lp == NULL)
+            break;
+
+          /* advance the position for the next iteration */
+          idx = renamer_model->update_idx++;
+          renamer_model->update_lp = lp->next;
+
           /* check if this item is dirty */
           item = THUNAR_RENAMER_MODEL_ITEM (lp->data);
           if (G_LIKELY (!item->dirty))
@@ -919,6 +986,11 @@ thunar_renamer_model_update_idle (gpointer user_data)
           item->changed = FALSE;
           item->dirty = FALSE;
 
+          /* refresh the parent directory of the file */
+          if (item->parent != NULL)
+            g_object_unref (item->parent);
+          item->parent = g_file_get_parent (thunar_file_get_file (item->file));
+
           /* determine the new name for the item */
           name = thunar_renamer_model_process_item (renamer_model, item, idx);
           if (!exo_str_is_equal (item->name, name))
@@ -936,17 +1008,6 @@ thunar_renamer_model_update_idle (gpointer user_data)
               g_free (name);
             }
 
-          /* check if this item conflicts with any other item */
-          conflict = thunar_renamer_model_conflict_item (renamer_model, item);
-          if (item->conflict != conflict)
-            {
-              /* apply the new state */
-              item->conflict = conflict;
-
-              /* the item changed */
-              changed = TRUE;
-            }
-
           /* check if the item changed */
           if (G_LIKELY (changed))
             {
@@ -958,13 +1019,24 @@ thunar_renamer_model_update_idle (gpointer user_data)
               gtk_tree_model_row_changed (GTK_TREE_MODEL (renamer_model), path, &iter);
               gtk_tree_path_free (path);
             }
+
+          /* continue in the next iteration to keep the ui responsive */
+          if (g_get_monotonic_time () >= deadline)
+            {
+              done = FALSE;
+              break;
+            }
         }
+
+      /* all names are up to date, check for conflicts in one go */
+      if (G_LIKELY (done))
+        thunar_renamer_model_update_conflicts (renamer_model);
     }
 
   GDK_THREADS_LEAVE ();
 
-  /* keep the idle source as long as any item changed */
-  return changed;
+  /* keep the idle source until all items are processed */
+  return !done;
 }
 
 
@@ -972,8 +1044,10 @@ thunar_renamer_model_update_idle (gpointer user_data)
 static void
 thunar_renamer_model_update_idle_destroy (gpointer user_data)
 {
-  /* reset the update idle id... */
+  /* reset the update idle id and position... */
   THUNAR_RENAMER_MODEL (user_data)->update_idle_id = 0;
+  THUNAR_RENAMER_MODEL (user_data)->update_lp = NULL;
+  THUNAR_RENAMER_MODEL (user_data)->update_restart = TRUE;
 
   /* ...and notify listeners */
   g_object_notify (G_OBJECT (user_data), "can-rename");
@@ -1002,6 +1076,8 @@ thunar_renamer_model_item_free (gpointer data)
   ThunarRenamerModelItem *item = data;
 
   g_object_unref (G_OBJECT (item->file));
+  if (item->parent != NULL)
+    g_object_unref (item->parent);
   g_free (item->name);
   g_slice_free (ThunarRenamerModelItem, item);
 }
@@ -1071,7 +1147,7 @@ thunar_renamer_model_new (void)
  * atleast one file is present.
  *
  * This method will always return %FALSE if the
- * @renamer_model is frozen. See thunar_renamer_model_set_frozen()
+ * @renamer_model is frozen or the renamer is busy. See thunar_renamer_model_set_frozen()
  * and thunar_renamer_model_get_frozen().
  *
  * Return value: %TRUE if bulk rename can be performed.
@@ -1084,7 +1160,8 @@ thunar_renamer_model_get_can_rename (ThunarRenamerModel *renamer_model)
 
   _thunar_return_val_if_fail (THUNAR_IS_RENAMER_MODEL (renamer_model), FALSE);
 
-  if (G_LIKELY (renamer_model->renamer != NULL && !renamer_model->frozen && renamer_model->update_idle_id == 0))
+  if (G_LIKELY (renamer_model->renamer != NULL && !renamer_model->frozen && renamer_model->update_idle_id == 0)
+      && !thunarx_renamer_get_busy (renamer_model->renamer))
     {
       /* check if atleast one item has a new name and no conflicts exist */
       for (lp = renamer_model->items; lp != NULL; lp = lp->next)
@@ -1259,6 +1336,7 @@ thunar_renamer_model_set_renamer (ThunarRenamerModel *renamer_model,
   if (renamer_model->renamer != NULL)
     {
       g_signal_handlers_disconnect_by_func (G_OBJECT (renamer_model->renamer), thunar_renamer_model_invalidate_all, renamer_model);
+      g_signal_handlers_disconnect_by_func (G_OBJECT (renamer_model->renamer), thunar_renamer_model_notify_busy, renamer_model);
       g_object_unref (G_OBJECT (renamer_model->renamer));
     }
 
@@ -1269,6 +1347,7 @@ thunar_renamer_model_set_renamer (ThunarRenamerModel *renamer_model,
   if (G_LIKELY (renamer != NULL))
     {
       g_signal_connect_swapped (G_OBJECT (renamer), "changed", G_CALLBACK (thunar_renamer_model_invalidate_all), renamer_model);
+      g_signal_connect_swapped (G_OBJECT (renamer), "notify::busy", G_CALLBACK (thunar_renamer_model_notify_busy), renamer_model);
       g_object_ref (G_OBJECT (renamer));
     }
 
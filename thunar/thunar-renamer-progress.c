@@ -21,24 +21,62 @@
 #include <config.h>
 #endif
 
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#ifdef HAVE_SIGNAL_H
+#include <signal.h>
+#endif
+#include <stdio.h>
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include <glib/gstdio.h>
+
 #include <thunar/thunar-private.h>
 #include <thunar/thunar-renamer-progress.h>
+#include <thunar/thunar-simple-job.h>
 
 
 
-/* Signal identifiers */
-enum
-{
-  FINISHED,
-  LAST_SIGNAL,
-};
+/* minimum interval between two progress updates from the rename job */
+#define THUNAR_RENAMER_PROGRESS_UPDATE_INTERVAL (G_USEC_PER_SEC / 10)
+
+
 
+typedef struct _ThunarRenamerStep ThunarRenamerStep;
 
 
-static void     thunar_renamer_progress_finalize          (GObject                    *object);
-static void     thunar_renamer_progress_destroy           (GtkWidget                  *object);
-static gboolean thunar_renamer_progress_next_idle         (gpointer                    user_data);
-static void     thunar_renamer_progress_next_idle_destroy (gpointer                    user_data);
+
+static void               thunar_renamer_progress_finalize          (GObject                    *object);
+static void               thunar_renamer_progress_destroy           (GtkWidget                  *object);
+static ThunarRenamerStep *thunar_renamer_step_new                   (ThunarFile                 *file,
+                                                                     const gchar                *name,
+                                                                     const gchar                *oldname);
+static void               thunar_renamer_step_free                  (gpointer                    data);
+static GList             *thunar_renamer_progress_plan              (GList                      *pairs);
+static gboolean           thunar_renamer_progress_job_notify        (gpointer                    user_data);
+static gboolean           thunar_renamer_progress_job               (ThunarJob                  *job,
+                                                                     GArray                     *param_values,
+                                                                     GError                    **error);
+static void               thunar_renamer_progress_job_info_message  (ThunarRenamerProgress      *renamer_progress,
+                                                                     const gchar                *message,
+                                                                     ExoJob                     *job);
+static void               thunar_renamer_progress_job_percent       (ThunarRenamerProgress      *renamer_progress,
+                                                                     gdouble                     percent,
+                                                                     ExoJob                     *job);
+static void               thunar_renamer_progress_job_finished      (ThunarRenamerProgress      *renamer_progress,
+                                                                     ExoJob                     *job);
+static void               thunar_renamer_progress_job_launch        (ThunarRenamerProgress      *renamer_progress);
+static void               thunar_renamer_progress_execute           (ThunarRenamerProgress      *renamer_progress,
+                                                                     GList                      *steps,
+                                                                     gboolean                    undo,
+                                                                     FILE                       *journal);
+static void               thunar_renamer_progress_recover           (ThunarRenamerProgress      *renamer_progress);
 
 
 
@@ -52,15 +90,38 @@ struct _ThunarRenamerProgress
   GtkAlignment __parent__;
   GtkWidget   *bar;
 
+  /* the lists below are owned by the rename job while it
+   * runs and only touched from the main thread once it
+   * has finished.
+   */
   GList       *pairs_done;
   guint        n_pairs_done;
   GList       *pairs_todo;
   guint        n_pairs_todo;
   gboolean     pairs_undo;  /* whether we're undoing previous changes */
 
-  /* internal main loop for the _rename() method */
-  guint        next_idle_id;
-  GMainLoop   *next_idle_loop;
+  /* the step that failed in the last job run (if any) */
+  ThunarRenamerStep *pair_failed;
+  GError            *pair_error;
+
+  /* undo journal for the current run, NULL while undoing */
+  FILE        *journal;
+
+  /* the rename job and the internal main loop for the _run() method */
+  ThunarJob   *job;
+  GMainLoop   *job_loop;
+};
+
+/* A single rename operation, which also remembers the
+ * name the file had before (-> undo). Renames that are
+ * part of a cycle are split into two steps, with the
+ * file being moved to a temporary name first.
+ */
+struct _ThunarRenamerStep
+{
+  ThunarFile *file;
+  gchar      *name;
+  gchar      *oldname;
 };
 
 
@@ -101,13 +162,13 @@ thunar_renamer_progress_finalize (GObject *object)
 {
   ThunarRenamerProgress *renamer_progress = THUNAR_RENAMER_PROGRESS (object);
 
-  /* make sure we're not finalized while the main loop is active */
-  _thunar_assert (renamer_progress->next_idle_id == 0);
-  _thunar_assert (renamer_progress->next_idle_loop == NULL);
+  /* make sure we're not finalized while the job is active */
+  _thunar_assert (renamer_progress->job == NULL);
+  _thunar_assert (renamer_progress->job_loop == NULL);
 
   /* release the pairs */
-  thunar_renamer_pair_list_free (renamer_progress->pairs_done);
-  thunar_renamer_pair_list_free (renamer_progress->pairs_todo);
+  g_list_free_full (renamer_progress->pairs_done, thunar_renamer_step_free);
+  g_list_free_full (renamer_progress->pairs_todo, thunar_renamer_step_free);
 
   (*G_OBJECT_CLASS (thunar_renamer_progress_parent_class)->finalize) (object);
 }
@@ -119,7 +180,7 @@ thunar_renamer_progress_destroy (GtkWidget *object)
 {
   ThunarRenamerProgress *renamer_progress = THUNAR_RENAMER_PROGRESS (object);
 
-  /* exit the internal main loop on destroy */
+  /* stop the rename job on destroy */
   thunar_renamer_progress_cancel (renamer_progress);
 
   (*GTK_WIDGET_CLASS (thunar_renamer_progress_parent_class)->destroy) (object);
@@ -127,156 +188,600 @@ thunar_renamer_progress_destroy (GtkWidget *object)
 
 
 
-static gboolean
-thunar_renamer_progress_next_idle (gpointer user_data)
+static ThunarRenamerStep*
+thunar_renamer_step_new (ThunarFile  *file,
+                         const gchar *name,
+                         const gchar *oldname)
 {
-  ThunarRenamerProgress *renamer_progress = THUNAR_RENAMER_PROGRESS (user_data);
-  ThunarRenamerPair     *pair;
-  GtkWindow             *toplevel;
-  GtkWidget             *message;
-  GError                *error = NULL;
-  gchar                 *oldname;
-  gchar                  text[128];
-  gint                   response;
-  guint                  n_done;
-  guint                  n_total;
-  GList                 *first;
+  ThunarRenamerStep *step;
 
-  GDK_THREADS_ENTER ();
+  step = g_slice_new (ThunarRenamerStep);
+  step->file = g_object_ref (G_OBJECT (file));
+  step->name = g_strdup (name);
+  step->oldname = g_strdup (oldname);
 
-  /* check if we have still pairs to go */
-  if (G_LIKELY (renamer_progress->pairs_todo != NULL))
+  return step;
+}
+
+
+
+static void
+thunar_renamer_step_free (gpointer data)
+{
+  ThunarRenamerStep *step = data;
+
+  g_object_unref (G_OBJECT (step->file));
+  g_free (step->oldname);
+  g_free (step->name);
+  g_slice_free (ThunarRenamerStep, step);
+}
+
+
+
+static GList*
+thunar_renamer_progress_plan (GList *pairs)
+{
+  ThunarRenamerPair *pair;
+  GHashTable        *sources;
+  GPtrArray         *items;
+  GArray            *chain;
+  GFile             *parent;
+  GFile             *target;
+  GList             *steps = NULL;
+  GList             *lp;
+  gpointer           source;
+  guint             *blockers;
+  guint8            *states;
+  gchar             *tmpname = NULL;
+  guint              cycle;
+  guint              n, m, i;
+  static guint       tmp_counter = 0;
+
+  /* the pairs in rename order, and a lookup table from the current
+   * location of each file to its index (plus one) in the array
+   */
+  items = g_ptr_array_new ();
+  sources = g_hash_table_new (g_file_hash, (GEqualFunc) g_file_equal);
+  for (lp = pairs; lp != NULL; lp = lp->next)
     {
-      /* pop the first pair from the todo list */
-      first = g_list_first (renamer_progress->pairs_todo);
-      pair = first->data;
-      renamer_progress->pairs_todo = g_list_delete_link (renamer_progress->pairs_todo, first);
+      g_hash_table_insert (sources, thunar_file_get_file (((ThunarRenamerPair *) lp->data)->file),
+                           GUINT_TO_POINTER (items->len + 1));
+      g_ptr_array_add (items, lp->data);
+    }
 
-      /* update item count */
-      renamer_progress->n_pairs_todo--;
-      _thunar_assert (g_list_length (renamer_progress->pairs_todo) == renamer_progress->n_pairs_todo);
+  /* determine for every pair the pair that currently occupies its
+   * new name and therefore has to be renamed first (if any)
+   */
+  blockers = g_new (guint, items->len);
+  for (n = 0; n < items->len; ++n)
+    {
+      pair = g_ptr_array_index (items, n);
+      blockers[n] = G_MAXUINT;
+
+      parent = g_file_get_parent (thunar_file_get_file (pair->file));
+      if (G_UNLIKELY (parent == NULL))
+        continue;
+
+      target = g_file_get_child_for_display_name (parent, pair->name, NULL);
+      if (G_LIKELY (target != NULL))
+        {
+          source = g_hash_table_lookup (sources, target);
+          if (source != NULL && GPOINTER_TO_UINT (source) - 1 != n)
+            blockers[n] = GPOINTER_TO_UINT (source) - 1;
+          g_object_unref (G_OBJECT (target));
+        }
+
+      g_object_unref (G_OBJECT (parent));
+    }
+
+  /* every pair has at most one blocker, so the dependencies form
+   * simple chains, each possibly ending in a cycle. Follow each chain
+   * until its end and emit it backwards, so every file is moved out of
+   * the way before another file takes its name. A cycle is broken by
+   * moving one of its files to a temporary name first.
+   */
+  states = g_new0 (guint8, items->len);
+  chain = g_array_new (FALSE, FALSE, sizeof (guint));
+  for (n = 0; n < items->len; ++n)
+    {
+      if (states[n] != 0)
+        continue;
+
+      /* collect the chain of not yet emitted pairs */
+      g_array_set_size (chain, 0);
+      for (i = n; i != G_MAXUINT && states[i] == 0; i = blockers[i])
+        {
+          states[i] = 1;
+          g_array_append_val (chain, i);
+        }
+
+      /* check if the chain ends in a cycle */
+      cycle = (i != G_MAXUINT && states[i] == 1) ? i : G_MAXUINT;
+      if (G_UNLIKELY (cycle != G_MAXUINT))
+        {
+          pair = g_ptr_array_index (items, cycle);
+          tmpname = g_strdup_printf (".thunar-rename-%d-%u", (gint) getpid (), ++tmp_counter);
+          steps = g_list_prepend (steps, thunar_renamer_step_new (pair->file, tmpname,
+                                                                  thunar_file_get_display_name (pair->file)));
+        }
+
+      /* emit the chain backwards */
+      for (m = chain->len; m-- > 0; )
+        {
+          i = g_array_index (chain, guint, m);
+          pair = g_ptr_array_index (items, i);
+          steps = g_list_prepend (steps, thunar_renamer_step_new (pair->file, pair->name,
+                                                                  (i == cycle) ? tmpname
+                                                                  : thunar_file_get_display_name (pair->file)));
+          states[i] = 2;
+        }
 
-      /* determine the done/todo items */
-      n_done = renamer_progress->n_pairs_done + 1;
-      n_total = n_done + renamer_progress->n_pairs_todo;
+      g_free (tmpname);
+      tmpname = NULL;
+    }
 
-      /* update the progress bar text */
-      g_snprintf (text, sizeof (text), "%d/%d", n_done, n_total);
-      gtk_progress_bar_set_text (GTK_PROGRESS_BAR (renamer_progress->bar), text);
+  /* cleanup */
+  g_array_free (chain, TRUE);
+  g_hash_table_destroy (sources);
+  g_ptr_array_free (items, TRUE);
+  g_free (blockers);
+  g_free (states);
 
-      /* update the progress bar fraction */
-      gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (renamer_progress->bar), CLAMP ((gdouble) n_done / MAX (n_total, 1), 0.0, 1.0));
+  return g_list_reverse (steps);
+}
 
-      /* remember the old file name (for undo) */
-      oldname = g_strdup (thunar_file_get_display_name (pair->file));
+
+
+static gboolean
+thunar_renamer_progress_job_notify (gpointer user_data)
+{
+  GList *lp;
+
+  for (lp = user_data; lp != NULL; lp = lp->next)
+    {
+      /* tell the associated folder that the file was renamed */
+      thunarx_file_info_renamed (THUNARX_FILE_INFO (lp->data));
+
+      /* emit the file changed signal */
+      thunar_file_changed (lp->data);
+    }
+
+  return FALSE;
+}
+
+
+
+static gboolean
+thunar_renamer_progress_job (ThunarJob  *job,
+                             GArray     *param_values,
+                             GError    **error)
+{
+  ThunarRenamerProgress *renamer_progress;
+  ThunarRenamerStep     *step;
+  GCancellable          *cancellable;
+  GError                *err = NULL;
+  GList                 *renamed = NULL;
+  gint64                 last_update = 0;
+  gint64                 now;
+  gchar                 *uri;
+  gchar                 *escaped;
+  guint                  n_total;
+
+  _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
+  _thunar_return_val_if_fail (param_values != NULL, FALSE);
+  _thunar_return_val_if_fail (param_values->len == 1, FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  renamer_progress = g_value_get_pointer (&g_array_index (param_values, GValue, 0));
+  cancellable = exo_job_get_cancellable (EXO_JOB (job));
+
+  while (renamer_progress->pairs_todo != NULL)
+    {
+      if (exo_job_set_error_if_cancelled (EXO_JOB (job), &err))
+        break;
+
+      /* pop the first step from the todo list */
+      step = renamer_progress->pairs_todo->data;
+      renamer_progress->pairs_todo = g_list_delete_link (renamer_progress->pairs_todo,
+                                                         renamer_progress->pairs_todo);
+      renamer_progress->n_pairs_todo--;
 
       /* try to rename the file */
-      if (!thunar_file_rename (pair->file, pair->name, NULL, FALSE, &error))
+      if (!thunar_file_rename (step->file, step->name, cancellable, TRUE, &err))
         {
-          /* determine the toplevel widget */
-          toplevel = (GtkWindow *) gtk_widget_get_toplevel (GTK_WIDGET (renamer_progress));
-
-          /* tell the user that we failed */
-          message = gtk_message_dialog_new (toplevel,
-                                            GTK_DIALOG_DESTROY_WITH_PARENT
-                                            | GTK_DIALOG_MODAL,
-                                            GTK_MESSAGE_ERROR,
-                                            GTK_BUTTONS_NONE,
-                                            _("Failed to rename \"%s\" to \"%s\"."),
-                                            oldname, pair->name);
-
-          /* check if we should provide undo */
-          if (!renamer_progress->pairs_undo && renamer_progress->pairs_done != NULL)
-            {
-              gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (message),
-                                                        _("You can either choose to skip this file and continue to rename the "
-                                                          "remaining files, or revert the previously renamed files to their "
-                                                          "previous names, or cancel the operation without reverting previous "
-                                                          "changes."));
-              gtk_dialog_add_button (GTK_DIALOG (message), _("_Cancel"), GTK_RESPONSE_CANCEL);
-              gtk_dialog_add_button (GTK_DIALOG (message), _("_Revert Changes"), GTK_RESPONSE_REJECT);
-              gtk_dialog_add_button (GTK_DIALOG (message), _("_Skip This File"), GTK_RESPONSE_ACCEPT);
-              gtk_dialog_set_default_response (GTK_DIALOG (message), GTK_RESPONSE_ACCEPT);
-            }
-          else if (renamer_progress->pairs_todo != NULL)
+          if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED))
             {
-              gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (message),
-                                                        _("Do you want to skip this file and continue to rename the "
-                                                          "remaining files?"));
-              gtk_dialog_add_button (GTK_DIALOG (message), _("_Cancel"), GTK_RESPONSE_CANCEL);
-              gtk_dialog_add_button (GTK_DIALOG (message), _("_Skip This File"), GTK_RESPONSE_ACCEPT);
-              gtk_dialog_set_default_response (GTK_DIALOG (message), GTK_RESPONSE_ACCEPT);
-            }
-          else
-            {
-              gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (message), "%s.", error->message);
-              gtk_dialog_add_button (GTK_DIALOG (message), _("_Close"), GTK_RESPONSE_CANCEL);
+              thunar_renamer_step_free (step);
+              break;
             }
 
-          /* run the dialog */
-          response = gtk_dialog_run (GTK_DIALOG (message));
-          if (response == GTK_RESPONSE_REJECT)
-            {
-              /* undo previous changes */
-              renamer_progress->pairs_undo = TRUE;
+          /* let the main thread decide how to continue */
+          renamer_progress->pair_failed = step;
+          renamer_progress->pair_error = err;
+          err = NULL;
+          break;
+        }
 
-              /* release the todo pairs and use the done as todo */
-              thunar_renamer_pair_list_free (renamer_progress->pairs_todo);
-              renamer_progress->pairs_todo = renamer_progress->pairs_done;
-              renamer_progress->pairs_done = NULL;
+      /* record the change in the journal before anything else */
+      if (renamer_progress->journal != NULL)
+        {
+          uri = g_file_get_uri (thunar_file_get_file (step->file));
+          escaped = g_strescape (step->oldname, NULL);
+          fprintf (renamer_progress->journal, "%s\t%s\n", uri, escaped);
+          fflush (renamer_progress->journal);
+          g_free (escaped);
+          g_free (uri);
+        }
 
-              renamer_progress->n_pairs_done = 0;
-              renamer_progress->n_pairs_todo = g_list_length (renamer_progress->pairs_todo);
-            }
-          else if (response != GTK_RESPONSE_ACCEPT)
-            {
-              /* canceled, just exit the main loop */
-              g_main_loop_quit (renamer_progress->next_idle_loop);
-            }
+      /* move the step to the list of completed steps (-> undo) */
+      renamer_progress->pairs_done = g_list_prepend (renamer_progress->pairs_done, step);
+      renamer_progress->n_pairs_done++;
 
-          /* release the pair */
-          thunar_renamer_pair_free (pair);
+      renamed = g_list_prepend (renamed, g_object_ref (G_OBJECT (step->file)));
 
-          /* destroy the dialog */
-          gtk_widget_destroy (message);
+      /* report progress and renamed files at most every update interval */
+      now = g_get_monotonic_time ();
+      if (renamer_progress->pairs_todo == NULL
+          || now - last_update >= THUNAR_RENAMER_PROGRESS_UPDATE_INTERVAL)
+        {
+          last_update = now;
 
-          /* clear the error */
-          g_clear_error (&error);
+          n_total = renamer_progress->n_pairs_done + renamer_progress->n_pairs_todo;
+          exo_job_info_message (EXO_JOB (job), "%u/%u", renamer_progress->n_pairs_done, n_total);
+          exo_job_percent (EXO_JOB (job), (renamer_progress->n_pairs_done * 100.0) / MAX (n_total, 1));
 
-          /* release old name */
-          g_free (oldname);
+          exo_job_send_to_mainloop (EXO_JOB (job), thunar_renamer_progress_job_notify,
+                                    renamed, (GDestroyNotify) thunar_g_file_list_free);
+          renamed = NULL;
+        }
+    }
+
+  /* notify about the remaining renamed files */
+  if (renamed != NULL)
+    {
+      exo_job_send_to_mainloop (EXO_JOB (job), thunar_renamer_progress_job_notify,
+                                renamed, (GDestroyNotify) thunar_g_file_list_free);
+    }
+
+  /* abort on cancellation */
+  if (err != NULL)
+    {
+      g_propagate_error (error, err);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+
+
+static void
+thunar_renamer_progress_job_info_message (ThunarRenamerProgress *renamer_progress,
+                                          const gchar           *message,
+                                          ExoJob                *job)
+{
+  _thunar_return_if_fail (THUNAR_IS_RENAMER_PROGRESS (renamer_progress));
+  _thunar_return_if_fail (EXO_IS_JOB (job));
+
+  gtk_progress_bar_set_text (GTK_PROGRESS_BAR (renamer_progress->bar), message);
+}
+
+
+
+static void
+thunar_renamer_progress_job_percent (ThunarRenamerProgress *renamer_progress,
+                                     gdouble                percent,
+                                     ExoJob                *job)
+{
+  _thunar_return_if_fail (THUNAR_IS_RENAMER_PROGRESS (renamer_progress));
+  _thunar_return_if_fail (EXO_IS_JOB (job));
+
+  gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (renamer_progress->bar), CLAMP (percent / 100.0, 0.0, 1.0));
+}
+
+
+
+static void
+thunar_renamer_progress_job_finished (ThunarRenamerProgress *renamer_progress,
+                                      ExoJob                *job)
+{
+  ThunarRenamerStep *step;
+  ThunarRenamerStep *done;
+  GtkWindow         *toplevel;
+  GtkWidget         *message;
+  gboolean           cancelled;
+  gchar             *name;
+  GList             *lp;
+  gint               response;
+
+  _thunar_return_if_fail (THUNAR_IS_RENAMER_PROGRESS (renamer_progress));
+  _thunar_return_if_fail (THUNAR_JOB (job) == renamer_progress->job);
+
+  /* the pairs belong to us again */
+  cancelled = exo_job_is_cancelled (job);
+  g_signal_handlers_disconnect_matched (job, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, renamer_progress);
+  g_object_unref (job);
+  renamer_progress->job = NULL;
+
+  /* check if renaming a file failed */
+  if (G_UNLIKELY (renamer_progress->pair_failed != NULL))
+    {
+      step = renamer_progress->pair_failed;
+      renamer_progress->pair_failed = NULL;
+
+      /* determine the toplevel widget */
+      toplevel = (GtkWindow *) gtk_widget_get_toplevel (GTK_WIDGET (renamer_progress));
+
+      /* tell the user that we failed */
+      message = gtk_message_dialog_new (toplevel,
+                                        GTK_DIALOG_DESTROY_WITH_PARENT
+                                        | GTK_DIALOG_MODAL,
+                                        GTK_MESSAGE_ERROR,
+                                        GTK_BUTTONS_NONE,
+                                        _("Failed to rename \"%s\" to \"%s\"."),
+                                        step->oldname, step->name);
+
+      /* check if we should provide undo */
+      if (!renamer_progress->pairs_undo && renamer_progress->pairs_done != NULL)
+        {
+          gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (message),
+                                                    _("You can either choose to skip this file and continue to rename the "
+                                                      "remaining files, or revert the previously renamed files to their "
+                                                      "previous names, or cancel the operation without reverting previous "
+                                                      "changes."));
+          gtk_dialog_add_button (GTK_DIALOG (message), _("_Cancel"), GTK_RESPONSE_CANCEL);
+          gtk_dialog_add_button (GTK_DIALOG (message), _("_Revert Changes"), GTK_RESPONSE_REJECT);
+          gtk_dialog_add_button (GTK_DIALOG (message), _("_Skip This File"), GTK_RESPONSE_ACCEPT);
+          gtk_dialog_set_default_response (GTK_DIALOG (message), GTK_RESPONSE_ACCEPT);
+        }
+      else if (renamer_progress->pairs_todo != NULL)
+        {
+          gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (message),
+                                                    _("Do you want to skip this file and continue to rename the "
+                                                      "remaining files?"));
+          gtk_dialog_add_button (GTK_DIALOG (message), _("_Cancel"), GTK_RESPONSE_CANCEL);
+          gtk_dialog_add_button (GTK_DIALOG (message), _("_Skip This File"), GTK_RESPONSE_ACCEPT);
+          gtk_dialog_set_default_response (GTK_DIALOG (message), GTK_RESPONSE_ACCEPT);
         }
       else
         {
-          /* replace the newname with the oldname for the pair (-> undo) */
-          g_free (pair->name);
-          pair->name = oldname;
+          gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (message), "%s.",
+                                                    renamer_progress->pair_error->message);
+          gtk_dialog_add_button (GTK_DIALOG (message), _("_Close"), GTK_RESPONSE_CANCEL);
+        }
+
+      /* run the dialog */
+      response = gtk_dialog_run (GTK_DIALOG (message));
+      if (response == GTK_RESPONSE_REJECT)
+        {
+          /* undo previous changes, the completed steps are in reverse order already */
+          renamer_progress->pairs_undo = TRUE;
 
-          /* move the pair to the list of completed pairs */
-          renamer_progress->pairs_done = g_list_prepend (renamer_progress->pairs_done, pair);
+          /* release the todo pairs and use the done as todo */
+          g_list_free_full (renamer_progress->pairs_todo, thunar_renamer_step_free);
+          renamer_progress->pairs_todo = renamer_progress->pairs_done;
+          renamer_progress->pairs_done = NULL;
 
-          /* update counter */
-          renamer_progress->n_pairs_done++;
-          _thunar_assert (g_list_length (renamer_progress->pairs_done) == renamer_progress->n_pairs_done);
+          for (lp = renamer_progress->pairs_todo; lp != NULL; lp = lp->next)
+            {
+              done = lp->data;
+              name = done->name;
+              done->name = done->oldname;
+              done->oldname = name;
+            }
+
+          renamer_progress->n_pairs_todo = renamer_progress->n_pairs_done;
+          renamer_progress->n_pairs_done = 0;
         }
+      else if (response != GTK_RESPONSE_ACCEPT)
+        {
+          /* canceled, don't continue */
+          cancelled = TRUE;
+        }
+
+      /* release the step */
+      thunar_renamer_step_free (step);
+
+      /* destroy the dialog */
+      gtk_widget_destroy (message);
+
+      /* clear the error */
+      g_clear_error (&renamer_progress->pair_error);
     }
 
-  /* be sure to cancel the internal loop once we're done */
-  if (G_UNLIKELY (renamer_progress->pairs_todo == NULL))
-    g_main_loop_quit (renamer_progress->next_idle_loop);
+  /* continue with the remaining pairs, unless we were cancelled in the meantime */
+  if (!cancelled
+      && renamer_progress->pairs_todo != NULL
+      && g_main_loop_is_running (renamer_progress->job_loop))
+    thunar_renamer_progress_job_launch (renamer_progress);
+  else
+    g_main_loop_quit (renamer_progress->job_loop);
+}
+
 
-  GDK_THREADS_LEAVE ();
 
-  /* keep the idle source alive as long as we have anything to do */
-  return (renamer_progress->pairs_todo != NULL);
+static void
+thunar_renamer_progress_job_launch (ThunarRenamerProgress *renamer_progress)
+{
+  _thunar_return_if_fail (THUNAR_IS_RENAMER_PROGRESS (renamer_progress));
+  _thunar_return_if_fail (renamer_progress->job == NULL);
+
+  /* the undo steps are not journaled, they restore the journaled state */
+  if (renamer_progress->pairs_undo)
+    renamer_progress->journal = NULL;
+
+  renamer_progress->job = thunar_simple_job_launch (thunar_renamer_progress_job, 1,
+                                                    G_TYPE_POINTER, renamer_progress);
+  g_signal_connect_swapped (renamer_progress->job, "info-message",
+                            G_CALLBACK (thunar_renamer_progress_job_info_message), renamer_progress);
+  g_signal_connect_swapped (renamer_progress->job, "percent",
+                            G_CALLBACK (thunar_renamer_progress_job_percent), renamer_progress);
+  g_signal_connect_swapped (renamer_progress->job, "finished",
+                            G_CALLBACK (thunar_renamer_progress_job_finished), renamer_progress);
 }
 
 
 
 static void
-thunar_renamer_progress_next_idle_destroy (gpointer user_data)
+thunar_renamer_progress_execute (ThunarRenamerProgress *renamer_progress,
+                                 GList                 *steps,
+                                 gboolean               undo,
+                                 FILE                  *journal)
 {
-  THUNAR_RENAMER_PROGRESS (user_data)->next_idle_id = 0;
+  gchar text[128];
+
+  /* set the steps on the todo list */
+  renamer_progress->pairs_todo = steps;
+  renamer_progress->n_pairs_todo = g_list_length (steps);
+  renamer_progress->pairs_undo = undo;
+  renamer_progress->journal = journal;
+
+  /* reset the progress bar */
+  g_snprintf (text, sizeof (text), "0/%u", renamer_progress->n_pairs_todo);
+  gtk_progress_bar_set_text (GTK_PROGRESS_BAR (renamer_progress->bar), text);
+  gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (renamer_progress->bar), 0.0);
+
+  if (G_LIKELY (steps != NULL))
+    {
+      /* launch the rename job */
+      renamer_progress->job_loop = g_main_loop_new (NULL, FALSE);
+      thunar_renamer_progress_job_launch (renamer_progress);
+
+      /* run the inner main loop until the job is done */
+      g_main_loop_run (renamer_progress->job_loop);
+      g_main_loop_unref (renamer_progress->job_loop);
+      renamer_progress->job_loop = NULL;
+    }
+
+  _thunar_assert (renamer_progress->job == NULL);
+
+  /* release the list of completed items */
+  g_list_free_full (renamer_progress->pairs_done, thunar_renamer_step_free);
+  renamer_progress->pairs_done = NULL;
+  renamer_progress->n_pairs_done = 0;
+
+  /* release the list of todo items */
+  g_list_free_full (renamer_progress->pairs_todo, thunar_renamer_step_free);
+  renamer_progress->pairs_todo = NULL;
+  renamer_progress->n_pairs_todo = 0;
+
+  renamer_progress->journal = NULL;
+}
+
+
+
+static void
+thunar_renamer_progress_recover (ThunarRenamerProgress *renamer_progress)
+{
+  const gchar *name;
+  ThunarFile  *file;
+  GtkWindow   *toplevel;
+  GtkWidget   *message;
+  GSList      *journals = NULL;
+  GSList      *sp;
+  GList       *steps = NULL;
+  gchar      **lines;
+  gchar       *contents;
+  gchar       *directory;
+  gchar       *oldname;
+  gchar       *path;
+  gchar       *tab;
+  GDir        *dir;
+  guint        n_journal;
+  gint         response;
+  gint         pid;
+  guint        n;
+
+  /* look for journals left behind by crashed processes */
+  directory = xfce_resource_save_location (XFCE_RESOURCE_CACHE, "Thunar/", FALSE);
+  dir = (directory != NULL) ? g_dir_open (directory, 0, NULL) : NULL;
+  if (G_LIKELY (dir == NULL))
+    {
+      g_free (directory);
+      return;
+    }
+
+  while ((name = g_dir_read_name (dir)) != NULL)
+    {
+      if (sscanf (name, "renamer-%d-%u.journal", &pid, &n_journal) != 2)
+        continue;
+
+      /* skip journals of running processes */
+      if (pid == (gint) getpid () || kill (pid, 0) == 0 || errno != ESRCH)
+        continue;
+
+      path = g_build_filename (directory, name, NULL);
+      if (g_file_get_contents (path, &contents, NULL, NULL))
+        {
+          /* collect the undo steps, the latest change first */
+          lines = g_strsplit (contents, "\n", -1);
+          for (n = 0; lines[n] != NULL; ++n)
+            {
+              tab = strchr (lines[n], '\t');
+              if (G_UNLIKELY (tab == NULL))
+                continue;
+              *tab = '\0';
+
+              /* skip files that were moved or deleted meanwhile */
+              file = thunar_file_get_for_uri (lines[n], NULL);
+              if (G_UNLIKELY (file == NULL))
+                continue;
+
+              oldname = g_strcompress (tab + 1);
+              if (g_utf8_validate (oldname, -1, NULL))
+                steps = g_list_prepend (steps, thunar_renamer_step_new (file, oldname, thunar_file_get_display_name (file)));
+              g_object_unref (G_OBJECT (file));
+              g_free (oldname);
+            }
+          g_strfreev (lines);
+          g_free (contents);
+        }
+
+      journals = g_slist_prepend (journals, path);
+    }
+
+  g_dir_close (dir);
+  g_free (directory);
+
+  if (G_UNLIKELY (steps != NULL))
+    {
+      /* determine the toplevel widget */
+      toplevel = (GtkWindow *) gtk_widget_get_toplevel (GTK_WIDGET (renamer_progress));
+
+      /* ask the user whether to revert the interrupted operation */
+      message = gtk_message_dialog_new (toplevel,
+                                        GTK_DIALOG_DESTROY_WITH_PARENT
+                                        | GTK_DIALOG_MODAL,
+                                        GTK_MESSAGE_QUESTION,
+                                        GTK_BUTTONS_NONE,
+                                        _("A previous rename operation was interrupted."));
+      gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (message),
+                                                ngettext ("Do you want to revert the %u file renamed "
+                                                          "by the interrupted operation to its previous name?",
+                                                          "Do you want to revert the %u files renamed "
+                                                          "by the interrupted operation to their previous names?",
+                                                          g_list_length (steps)),
+                                                g_list_length (steps));
+      gtk_dialog_add_button (GTK_DIALOG (message), _("_Keep Changes"), GTK_RESPONSE_CANCEL);
+      gtk_dialog_add_button (GTK_DIALOG (message), _("_Revert Changes"), GTK_RESPONSE_REJECT);
+      gtk_dialog_set_default_response (GTK_DIALOG (message), GTK_RESPONSE_REJECT);
+      response = gtk_dialog_run (GTK_DIALOG (message));
+      gtk_widget_destroy (message);
+
+      /* perform the undo (returns when done) */
+      if (response == GTK_RESPONSE_REJECT)
+        thunar_renamer_progress_execute (renamer_progress, steps, TRUE, NULL);
+      else
+        g_list_free_full (steps, thunar_renamer_step_free);
+    }
+
+  /* the journals are handled now */
+  for (sp = journals; sp != NULL; sp = sp->next)
+    {
+      g_unlink (sp->data);
+      g_free (sp->data);
+    }
+  g_slist_free (journals);
 }
 
 
@@ -307,9 +812,13 @@ thunar_renamer_progress_cancel (ThunarRenamerProgress *renamer_progress)
 {
   _thunar_return_if_fail (THUNAR_IS_RENAMER_PROGRESS (renamer_progress));
 
-  /* exit the internal main loop (if any) */
-  if (G_UNLIKELY (renamer_progress->next_idle_loop != NULL))
-    g_main_loop_quit (renamer_progress->next_idle_loop);
+  /* the job quits the internal main loop once it finished,
+   * otherwise exit the internal main loop directly (if any)
+   */
+  if (renamer_progress->job != NULL)
+    exo_job_cancel (EXO_JOB (renamer_progress->job));
+  else if (G_UNLIKELY (renamer_progress->job_loop != NULL))
+    g_main_loop_quit (renamer_progress->job_loop);
 }
 
 
@@ -326,7 +835,7 @@ gboolean
 thunar_renamer_progress_running (ThunarRenamerProgress *renamer_progress)
 {
   _thunar_return_val_if_fail (THUNAR_IS_RENAMER_PROGRESS (renamer_progress), FALSE);
-  return (renamer_progress->next_idle_loop != NULL);
+  return (renamer_progress->job_loop != NULL);
 }
 
 
@@ -339,6 +848,12 @@ thunar_renamer_progress_running (ThunarRenamerProgress *renamer_progress)
  * Renames all #ThunarRenamePair<!---->s in the specified @pair_list
  * using the @renamer_progress.
  *
+ * The files are renamed by a #ThunarJob in the background, in an
+ * order that never renames a file to the current name of another
+ * file in @pair_list. Every completed rename is recorded in an undo
+ * journal, so the changes of an interrupted run can be reverted the
+ * next time this method is invoked.
+ *
  * This method starts a new main loop, and returns only after the
  * rename operation is done (or cancelled by a "destroy" signal).
  **/
@@ -346,49 +861,41 @@ void
 thunar_renamer_progress_run (ThunarRenamerProgress *renamer_progress,
                              GList                 *pairs)
 {
+  static guint n_journals = 0;
+  FILE        *journal;
+  gchar       *spec;
+  gchar       *path;
+
   _thunar_return_if_fail (THUNAR_IS_RENAMER_PROGRESS (renamer_progress));
 
   /* make sure we're not already renaming */
-  if (G_UNLIKELY (renamer_progress->next_idle_id != 0
-      || renamer_progress->next_idle_loop != NULL))
+  if (G_UNLIKELY (renamer_progress->job != NULL
+      || renamer_progress->job_loop != NULL))
     return;
 
   /* take an additional reference on the progress */
   g_object_ref (G_OBJECT (renamer_progress));
 
-  /* make sure to release the list of completed items first */
-  thunar_renamer_pair_list_free (renamer_progress->pairs_done);
-  renamer_progress->pairs_done = NULL;
-
-  /* set the pairs on the todo list */
-  thunar_renamer_pair_list_free (renamer_progress->pairs_todo);
-  renamer_progress->pairs_todo = thunar_renamer_pair_list_copy (pairs);
-  renamer_progress->n_pairs_todo = g_list_length (renamer_progress->pairs_todo);
-
-  /* schedule the idle source */
-  renamer_progress->next_idle_id = g_idle_add_full (G_PRIORITY_LOW, thunar_renamer_progress_next_idle,
-                                                    renamer_progress, thunar_renamer_progress_next_idle_destroy);
+  /* offer to revert renames of crashed runs first */
+  thunar_renamer_progress_recover (renamer_progress);
 
-  /* run the inner main loop */
-  renamer_progress->next_idle_loop = g_main_loop_new (NULL, FALSE);
-  g_main_loop_run (renamer_progress->next_idle_loop);
-  g_main_loop_unref (renamer_progress->next_idle_loop);
-  renamer_progress->next_idle_loop = NULL;
+  /* open a new undo journal for this run */
+  spec = g_strdup_printf ("Thunar/renamer-%d-%u.journal", (gint) getpid (), ++n_journals);
+  path = xfce_resource_save_location (XFCE_RESOURCE_CACHE, spec, TRUE);
+  journal = (path != NULL) ? g_fopen (path, "w") : NULL;
+  g_free (spec);
 
-  /* be sure to cancel any pending idle source */
-  if (G_UNLIKELY (renamer_progress->next_idle_id != 0))
-    g_source_remove (renamer_progress->next_idle_id);
-
-  /* release the list of completed items */
-  thunar_renamer_pair_list_free (renamer_progress->pairs_done);
-  renamer_progress->pairs_done = NULL;
+  /* perform the rename (returns when done) */
+  thunar_renamer_progress_execute (renamer_progress, thunar_renamer_progress_plan (pairs), FALSE, journal);
 
-  /* release the list of todo items */
-  thunar_renamer_pair_list_free (renamer_progress->pairs_todo);
-  renamer_progress->pairs_todo = NULL;
+  /* the run is complete, so the journal is obsolete now */
+  if (G_LIKELY (journal != NULL))
+    {
+      fclose (journal);
+      g_unlink (path);
+    }
+  g_free (path);
 
   /* release the additional reference on the progress */
   g_object_unref (G_OBJECT (renamer_progress));
 }
-
-
@@ -0,0 +1,241 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <thunar/thunar-private.h>
+#include <thunar/thunar-search-criteria.h>
+
+
+
+static ThunarSearchCriteria *thunar_search_criteria_copy (ThunarSearchCriteria *criteria) G_GNUC_MALLOC;
+
+
+
+GType
+thunar_search_criteria_get_type (void)
+{
+  static GType type = G_TYPE_INVALID;
+
+  if (G_UNLIKELY (type == G_TYPE_INVALID))
+    {
+      type = g_boxed_type_register_static (I_("ThunarSearchCriteria"),
+                                           (GBoxedCopyFunc) thunar_search_criteria_copy,
+                                           (GBoxedFreeFunc) thunar_search_criteria_free);
+    }
+
+  return type;
+}
+
+
+
+/**
+ * thunar_search_criteria_new:
+ * @pattern : the name pattern to search for, or %NULL
+ *            to match every name.
+ *
+ * Allocates new #ThunarSearchCriteria for @pattern, without
+ * size or date limits and with unlimited depth. The caller
+ * may adjust the public fields before starting the search.
+ *
+ * The caller is responsible to free the returned criteria
+ * using thunar_search_criteria_free() when no longer needed.
+ *
+ * Return value: the newly allocated #ThunarSearchCriteria.
+ **/
+ThunarSearchCriteria*
+thunar_search_criteria_new (const gchar *pattern)
+{
+  ThunarSearchCriteria *criteria;
+
+  _thunar_return_val_if_fail (pattern == NULL || g_utf8_validate (pattern, -1, NULL), NULL);
+
+  criteria = g_slice_new0 (ThunarSearchCriteria);
+  criteria->n_threads = 1;
+
+  if (pattern != NULL && *pattern != '\0')
+    {
+      criteria->pattern = g_strdup (pattern);
+      criteria->pattern_casefold = g_utf8_casefold (pattern, -1);
+
+      /* patterns with wildcards are matched as a whole */
+      if (strpbrk (pattern, "*?") != NULL)
+        criteria->pattern_spec = g_pattern_spec_new (criteria->pattern_casefold);
+    }
+
+  return criteria;
+}
+
+
+
+static ThunarSearchCriteria*
+thunar_search_criteria_copy (ThunarSearchCriteria *criteria)
+{
+  ThunarSearchCriteria *copy;
+
+  _thunar_return_val_if_fail (criteria != NULL, NULL);
+
+  copy = thunar_search_criteria_new (criteria->pattern);
+  copy->min_size = criteria->min_size;
+  copy->max_size = criteria->max_size;
+  copy->modified_after = criteria->modified_after;
+  copy->modified_before = criteria->modified_before;
+  copy->max_depth = criteria->max_depth;
+  copy->n_threads = criteria->n_threads;
+
+  return copy;
+}
+
+
+
+/**
+ * thunar_search_criteria_free:
+ * @data : a #ThunarSearchCriteria.
+ *
+ * Frees the specified #ThunarSearchCriteria.
+ **/
+void
+thunar_search_criteria_free (gpointer data)
+{
+  ThunarSearchCriteria *criteria = data;
+
+  if (G_LIKELY (criteria != NULL))
+    {
+      if (criteria->pattern_spec != NULL)
+        g_pattern_spec_free (criteria->pattern_spec);
+      g_free (criteria->pattern_casefold);
+      g_free (criteria->pattern);
+      g_slice_free (ThunarSearchCriteria, criteria);
+    }
+}
+
+
+
+/**
+ * thunar_search_criteria_matches:
+ * @criteria : a #ThunarSearchCriteria.
+ * @file     : a #ThunarFile.
+ *
+ * Checks whether @file matches the name pattern and the
+ * size and date limits of @criteria. This function may be
+ * called from multiple threads at the same time.
+ *
+ * Return value: %TRUE if @file matches @criteria.
+ **/
+gboolean
+thunar_search_criteria_matches (const ThunarSearchCriteria *criteria,
+                                const ThunarFile           *file)
+{
+  guint64 value;
+
+  _thunar_return_val_if_fail (criteria != NULL, FALSE);
+  _thunar_return_val_if_fail (THUNAR_IS_FILE (file), FALSE);
+
+  /* check the size limits, only regular files have a size */
+  if (criteria->min_size > 0 || criteria->max_size > 0)
+    {
+      if (!thunar_file_is_regular (file))
+        return FALSE;
+
+      value = thunar_file_get_size (file);
+      if (value < criteria->min_size
+          || (criteria->max_size > 0 && value > criteria->max_size))
+        return FALSE;
+    }
+
+  /* check the modification time limits */
+  if (criteria->modified_after > 0 || criteria->modified_before > 0)
+    {
+      value = thunar_file_get_date (file, THUNAR_FILE_DATE_MODIFIED);
+      if (value < criteria->modified_after
+          || (criteria->modified_before > 0 && value > criteria->modified_before))
+        return FALSE;
+    }
+
+  return thunar_search_criteria_matches_name (criteria, thunar_file_get_display_name (file));
+}
+
+
+
+/**
+ * thunar_search_criteria_matches_name:
+ * @criteria     : a #ThunarSearchCriteria.
+ * @display_name : the display name of a file.
+ *
+ * Checks whether @display_name matches the name pattern of
+ * @criteria, ignoring the size and date limits. Like
+ * thunar_search_criteria_matches(), this function may be
+ * called from multiple threads at the same time.
+ *
+ * Return value: %TRUE if @display_name matches @criteria.
+ **/
+gboolean
+thunar_search_criteria_matches_name (const ThunarSearchCriteria *criteria,
+                                     const gchar                *display_name)
+{
+  gboolean matches;
+  gchar   *name;
+
+  _thunar_return_val_if_fail (criteria != NULL, FALSE);
+  _thunar_return_val_if_fail (display_name != NULL, FALSE);
+
+  if (criteria->pattern_casefold == NULL)
+    return TRUE;
+
+  name = g_utf8_casefold (display_name, -1);
+  matches = thunar_search_criteria_matches_casefold (criteria, name);
+  g_free (name);
+
+  return matches;
+}
+
+
+
+/**
+ * thunar_search_criteria_matches_casefold:
+ * @criteria : a #ThunarSearchCriteria.
+ * @casefold : the display name of a file, casefolded
+ *             with g_utf8_casefold().
+ *
+ * Like thunar_search_criteria_matches_name(), for callers
+ * that already know the casefolded display name.
+ *
+ * Return value: %TRUE if @casefold matches @criteria.
+ **/
+gboolean
+thunar_search_criteria_matches_casefold (const ThunarSearchCriteria *criteria,
+                                         const gchar                *casefold)
+{
+  _thunar_return_val_if_fail (criteria != NULL, FALSE);
+  _thunar_return_val_if_fail (casefold != NULL, FALSE);
+
+  if (criteria->pattern_casefold == NULL)
+    return TRUE;
+  else if (criteria->pattern_spec != NULL)
+    return g_pattern_match_string (criteria->pattern_spec, casefold);
+  else
+    return (strstr (casefold, criteria->pattern_casefold) != NULL);
+}
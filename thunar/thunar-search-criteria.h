@@ -0,0 +1,75 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __THUNAR_SEARCH_CRITERIA_H__
+#define __THUNAR_SEARCH_CRITERIA_H__
+
+#include <thunar/thunar-file.h>
+
+G_BEGIN_DECLS;
+
+typedef struct _ThunarSearchCriteria ThunarSearchCriteria;
+
+#define THUNAR_TYPE_SEARCH_CRITERIA (thunar_search_criteria_get_type ())
+
+struct _ThunarSearchCriteria
+{
+  /* glob pattern if it contains wildcards, substring otherwise,
+   * both matched case-insensitively against the display name */
+  gchar        *pattern;
+
+  /* size limits in bytes, a maximum of 0 means no limit. files
+   * other than regular files don't match if a limit is set */
+  guint64       min_size;
+  guint64       max_size;
+
+  /* modification time limits in seconds since the epoch, 0 means no limit */
+  guint64       modified_after;
+  guint64       modified_before;
+
+  /* the maximum depth below the start folder, 0 means unlimited */
+  guint         max_depth;
+
+  /* number of threads scanning folders in parallel */
+  guint         n_threads;
+
+  /*< private >*/
+  GPatternSpec *pattern_spec;
+  gchar        *pattern_casefold;
+};
+
+GType                 thunar_search_criteria_get_type         (void) G_GNUC_CONST;
+
+ThunarSearchCriteria *thunar_search_criteria_new              (const gchar                *pattern) G_GNUC_MALLOC;
+
+void                  thunar_search_criteria_free             (gpointer                    data);
+
+gboolean              thunar_search_criteria_matches          (const ThunarSearchCriteria *criteria,
+                                                               const ThunarFile           *file);
+
+gboolean              thunar_search_criteria_matches_name     (const ThunarSearchCriteria *criteria,
+                                                               const gchar                *display_name);
+
+gboolean              thunar_search_criteria_matches_casefold (const ThunarSearchCriteria *criteria,
+                                                               const gchar                *casefold);
+
+G_END_DECLS;
+
+#endif /* !__THUNAR_SEARCH_CRITERIA_H__ */
@@ -0,0 +1,1759 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_SYS_SYSCALL_H
+#include <sys/syscall.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include <thunar/thunar-preferences.h>
+#include <thunar/thunar-private.h>
+#include <thunar/thunar-search-index.h>
+
+
+
+/* the index format on disk, followed by the records that added, updated
+ * and removed the entries in the order they were applied. a full build
+ * writes a new file, the changes of the changed folders are appended */
+#define SEARCH_INDEX_MAGIC   "ThunarSearchIndex2"
+#define SEARCH_INDEX_FILE    "Thunar/search-index"
+
+/* record types in the index on disk */
+#define SEARCH_INDEX_RECORD_ADD    ('a')
+#define SEARCH_INDEX_RECORD_UPDATE ('u')
+#define SEARCH_INDEX_RECORD_REMOVE ('r')
+
+/* the attributes needed to index a folder */
+#define SEARCH_INDEX_ATTRIBUTES "standard::name,standard::type,time::modified,time::modified-usec"
+
+/* delay before changes reported by the folder monitors are indexed */
+#define SEARCH_INDEX_CHANGED_DELAY (30)
+
+/* placeholders for missing entries and unknown modification times */
+#define SEARCH_INDEX_NONE          (G_MAXUINT32)
+#define SEARCH_INDEX_MTIME_UNKNOWN (G_MAXUINT64)
+
+/* entry flags */
+#define SEARCH_INDEX_DIRECTORY (1u << 0) /* the entry is a folder */
+#define SEARCH_INDEX_COMPLETE  (1u << 1) /* the folder and all folders below are indexed */
+#define SEARCH_INDEX_REMOVED   (1u << 2) /* the entry is gone, only in memory */
+
+/* the key of the trigram starting at p */
+#define SEARCH_INDEX_TRIGRAM(p) (((guint32) (guchar) (p)[0] << 16) | ((guint32) (guchar) (p)[1] << 8) | (guint32) (guchar) (p)[2])
+
+
+
+typedef struct _ThunarSearchIndexData    ThunarSearchIndexData;
+typedef struct _ThunarSearchIndexEntry   ThunarSearchIndexEntry;
+typedef struct _ThunarSearchIndexBuilder ThunarSearchIndexBuilder;
+
+
+
+static void                   thunar_search_index_finalize          (GObject                  *object);
+static void                   thunar_search_index_stop              (ThunarSearchIndex        *index);
+static ThunarSearchIndexData *thunar_search_index_data_new          (gsize                     max_memory);
+static ThunarSearchIndexData *thunar_search_index_data_ref          (ThunarSearchIndexData    *data);
+static void                   thunar_search_index_data_unref        (ThunarSearchIndexData    *data);
+static guint32                thunar_search_index_data_add          (ThunarSearchIndexData    *data,
+                                                                     guint32                   parent,
+                                                                     const gchar              *name,
+                                                                     guint64                   mtime,
+                                                                     guint                     flags);
+static void                   thunar_search_index_data_remove       (ThunarSearchIndexData    *data,
+                                                                     guint32                   id);
+static guint32                thunar_search_index_data_lookup       (ThunarSearchIndexData    *data,
+                                                                     const gchar              *path);
+static gboolean               thunar_search_index_data_write        (ThunarSearchIndexData    *data,
+                                                                     GDataOutputStream        *output,
+                                                                     gchar                     record,
+                                                                     guint32                   id,
+                                                                     GError                  **error);
+static ThunarSearchIndexData *thunar_search_index_data_load         (GFile                    *file,
+                                                                     gsize                     max_memory);
+static void                   thunar_search_index_data_save         (ThunarSearchIndexData    *data,
+                                                                     GFile                    *file);
+static void                   thunar_search_index_build_directory   (ThunarSearchIndexBuilder *builder,
+                                                                     GFile                    *directory,
+                                                                     guint32                   parent,
+                                                                     const gchar              *name,
+                                                                     guint64                   mtime,
+                                                                     guint32                   old_id);
+static void                   thunar_search_index_patch_directory   (ThunarSearchIndexBuilder *builder,
+                                                                     GFile                    *directory,
+                                                                     guint32                   id);
+static gpointer               thunar_search_index_thread            (gpointer                  user_data);
+static gboolean               thunar_search_index_start             (ThunarSearchIndex        *index);
+static gboolean               thunar_search_index_rescan_timeout    (gpointer                  user_data);
+static gboolean               thunar_search_index_changed_timeout   (gpointer                  user_data);
+static void                   thunar_search_index_schedule          (ThunarSearchIndex        *index);
+static void                   thunar_search_index_mounts_changed    (ThunarSearchIndex        *index);
+
+
+
+struct _ThunarSearchIndexClass
+{
+  GObjectClass __parent__;
+};
+
+struct _ThunarSearchIndex
+{
+  GObject                __parent__;
+
+  GVolumeMonitor        *volume_monitor;
+
+  /* the location of the index on disk */
+  GFile                 *file;
+
+  /* settings read from the preferences */
+  gchar                 *roots;
+  gsize                  max_memory;
+
+  guint                  rescan_id;
+  guint                  changed_id;
+
+  /* folders changed since the last build, or %TRUE
+   * in full_rescan if all folders must be checked */
+  GHashTable            *dirty;
+  gboolean               full_rescan;
+
+  /* set while a thread builds a new index, the thread holds
+   * a reference on the index until it is done */
+  volatile gint          building;
+
+  /* cancelled once the index is not the default anymore */
+  GCancellable          *cancellable;
+
+  /* protects the data pointer, queries take a reference on the
+   * data and hold its reader lock while they use it */
+  GMutex                 lock;
+  ThunarSearchIndexData *data;
+};
+
+struct _ThunarSearchIndexEntry
+{
+  guint64 mtime;
+  guint32 parent;
+  guint32 name;
+  guint32 casefold;
+  guint32 first_child;
+  guint32 next_sibling;
+  guint32 flags;
+};
+
+struct _ThunarSearchIndexData
+{
+  volatile gint ref_count;
+
+  /* only the builder thread modifies the data, when it patches
+   * the changed folders, queries hold the reader lock */
+  GRWLock       lock;
+
+  /* the path trie, entries only refer to entries added before them.
+   * removed entries keep their id until the next full build */
+  GArray       *entries;
+  GArray       *roots;
+
+  /* the names and the casefolded display names matched by queries,
+   * entries share them if they are the same */
+  GString      *names;
+
+  /* maps name trigrams to the ascending ids of the entries containing them */
+  GHashTable   *trigrams;
+
+  /* the estimated size and the ceiling it must stay below,
+   * truncated is set once an entry didn't fit anymore */
+  gsize         memory;
+  gsize         max_memory;
+  gboolean      truncated;
+};
+
+struct _ThunarSearchIndexBuilder
+{
+  ThunarSearchIndex     *index;
+  ThunarSearchIndexData *old;
+  ThunarSearchIndexData *data;
+  GHashTable            *dirty;
+  gchar                **roots;
+  GFile                 *file;
+
+  /* the changes appended to the file while patching */
+  GDataOutputStream     *log;
+};
+
+
+
+static ThunarSearchIndex *search_index_default = NULL;
+G_LOCK_DEFINE_STATIC (search_index_default);
+
+
+
+G_DEFINE_TYPE (ThunarSearchIndex, thunar_search_index, G_TYPE_OBJECT)
+
+
+
+static void
+thunar_search_index_class_init (ThunarSearchIndexClass *klass)
+{
+  GObjectClass *gobject_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  gobject_class->finalize = thunar_search_index_finalize;
+}
+
+
+
+static void
+thunar_search_index_init (ThunarSearchIndex *index)
+{
+  ThunarPreferences *preferences;
+  gchar             *path;
+  guint              max_memory;
+  guint              interval;
+
+  g_mutex_init (&index->lock);
+  index->cancellable = g_cancellable_new ();
+  index->dirty = g_hash_table_new_full (g_file_hash, (GEqualFunc) g_file_equal, g_object_unref, NULL);
+
+  /* the index is stored in the cache directory */
+  path = xfce_resource_save_location (XFCE_RESOURCE_CACHE, SEARCH_INDEX_FILE, TRUE);
+  if (G_LIKELY (path != NULL))
+    index->file = g_file_new_for_path (path);
+  g_free (path);
+
+  preferences = thunar_preferences_get ();
+  g_object_get (G_OBJECT (preferences),
+                "misc-search-index-roots", &index->roots,
+                "misc-search-index-max-memory", &max_memory,
+                "misc-search-index-rescan-interval", &interval,
+                NULL);
+  g_object_unref (G_OBJECT (preferences));
+
+  /* the old index is still used while a new one is built, and
+   * both must fit into the memory the user gave to the index */
+  index->max_memory = (gsize) max_memory * 1024 * 1024 / 2;
+
+  /* check the folders again from time to time, changes in
+   * folders nobody looks at are not reported by any monitor */
+  index->rescan_id = g_timeout_add_seconds (interval * 60, thunar_search_index_rescan_timeout, index);
+
+  /* mounted volumes are indexed too, unless the roots are set */
+  index->volume_monitor = g_volume_monitor_get ();
+  g_signal_connect_swapped (G_OBJECT (index->volume_monitor), "mount-added",
+                            G_CALLBACK (thunar_search_index_mounts_changed), index);
+  g_signal_connect_swapped (G_OBJECT (index->volume_monitor), "mount-removed",
+                            G_CALLBACK (thunar_search_index_mounts_changed), index);
+
+  /* load the index from disk and check it */
+  index->full_rescan = TRUE;
+  thunar_search_index_start (index);
+}
+
+
+
+static void
+thunar_search_index_finalize (GObject *object)
+{
+  ThunarSearchIndex *index = THUNAR_SEARCH_INDEX (object);
+
+  /* no builder is running anymore, it holds a reference */
+  _thunar_assert (!g_atomic_int_get (&index->building));
+
+  thunar_search_index_stop (index);
+  g_object_unref (G_OBJECT (index->volume_monitor));
+  g_object_unref (index->cancellable);
+
+  if (index->data != NULL)
+    thunar_search_index_data_unref (index->data);
+  g_mutex_clear (&index->lock);
+
+  g_hash_table_destroy (index->dirty);
+  if (index->file != NULL)
+    g_object_unref (index->file);
+  g_free (index->roots);
+
+  (*G_OBJECT_CLASS (thunar_search_index_parent_class)->finalize) (object);
+}
+
+
+
+static void
+thunar_search_index_stop (ThunarSearchIndex *index)
+{
+  /* stop a running builder, it checks between two files */
+  g_cancellable_cancel (index->cancellable);
+
+  /* don't start new builds */
+  g_signal_handlers_disconnect_by_func (G_OBJECT (index->volume_monitor), thunar_search_index_mounts_changed, index);
+
+  if (index->rescan_id != 0)
+    g_source_remove (index->rescan_id);
+  index->rescan_id = 0;
+
+  if (index->changed_id != 0)
+    g_source_remove (index->changed_id);
+  index->changed_id = 0;
+}
+
+
+
+static gboolean
+thunar_search_index_release_idle (gpointer user_data)
+{
+  g_object_unref (G_OBJECT (user_data));
+  return FALSE;
+}
+
+
+
+static ThunarSearchIndexData*
+thunar_search_index_data_new (gsize max_memory)
+{
+  ThunarSearchIndexData *data;
+
+  data = g_slice_new0 (ThunarSearchIndexData);
+  data->ref_count = 1;
+  g_rw_lock_init (&data->lock);
+  data->entries = g_array_new (FALSE, FALSE, sizeof (ThunarSearchIndexEntry));
+  data->roots = g_array_new (FALSE, FALSE, sizeof (guint32));
+  data->names = g_string_new (NULL);
+  data->trigrams = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, (GDestroyNotify) g_array_unref);
+  data->max_memory = max_memory;
+
+  return data;
+}
+
+
+
+static ThunarSearchIndexData*
+thunar_search_index_data_ref (ThunarSearchIndexData *data)
+{
+  g_atomic_int_inc (&data->ref_count);
+  return data;
+}
+
+
+
+static void
+thunar_search_index_data_unref (ThunarSearchIndexData *data)
+{
+  if (g_atomic_int_dec_and_test (&data->ref_count))
+    {
+      g_hash_table_destroy (data->trigrams);
+      g_string_free (data->names, TRUE);
+      g_array_free (data->roots, TRUE);
+      g_array_free (data->entries, TRUE);
+      g_rw_lock_clear (&data->lock);
+      g_slice_free (ThunarSearchIndexData, data);
+    }
+}
+
+
+
+static void
+thunar_search_index_data_add_trigrams (ThunarSearchIndexData *data,
+                                       guint32                id,
+                                       const gchar           *casefold)
+{
+  const gchar *p;
+  GArray      *ids;
+  gpointer     key;
+
+  for (p = casefold; p[0] != '\0' && p[1] != '\0' && p[2] != '\0'; ++p)
+    {
+      key = GUINT_TO_POINTER (SEARCH_INDEX_TRIGRAM (p));
+      ids = g_hash_table_lookup (data->trigrams, key);
+      if (G_UNLIKELY (ids == NULL))
+        {
+          ids = g_array_new (FALSE, FALSE, sizeof (guint32));
+          g_hash_table_insert (data->trigrams, key, ids);
+          data->memory += 64;
+        }
+      else if (g_array_index (ids, guint32, ids->len - 1) == id)
+        {
+          /* the trigram occurs more than once in the name */
+          continue;
+        }
+
+      g_array_append_val (ids, id);
+      data->memory += sizeof (guint32);
+    }
+}
+
+
+
+static guint32
+thunar_search_index_data_add (ThunarSearchIndexData *data,
+                              guint32                parent,
+                              const gchar           *name,
+                              guint64                mtime,
+                              guint                  flags)
+{
+  ThunarSearchIndexEntry  entry;
+  ThunarSearchIndexEntry *parent_entry;
+  guint32                 id = data->entries->len;
+  gsize                   length = strlen (name);
+  gsize                   casefold_length;
+  gchar                  *display_name;
+  gchar                  *casefold;
+
+  /* queries match against the display name, ignoring case */
+  display_name = g_filename_display_name (name);
+  casefold = g_utf8_casefold (display_name, -1);
+  g_free (display_name);
+
+  /* most names are their own casefolded display name */
+  casefold_length = (strcmp (casefold, name) != 0) ? strlen (casefold) + 1 : 0;
+
+  /* stop at the memory ceiling, the data is incomplete from here on */
+  if (G_UNLIKELY (data->memory + sizeof (entry) + length + 1 + casefold_length > data->max_memory
+                  || (guint64) data->names->len + length + 1 + casefold_length >= SEARCH_INDEX_NONE))
+    {
+      data->truncated = TRUE;
+      g_free (casefold);
+      return SEARCH_INDEX_NONE;
+    }
+
+  entry.parent = parent;
+  entry.name = data->names->len;
+  entry.casefold = entry.name;
+  entry.first_child = SEARCH_INDEX_NONE;
+  entry.next_sibling = SEARCH_INDEX_NONE;
+  entry.mtime = mtime;
+  entry.flags = flags;
+
+  /* names are stored with their terminating nul byte */
+  g_string_append_len (data->names, name, length + 1);
+  if (casefold_length > 0)
+    {
+      entry.casefold = data->names->len;
+      g_string_append_len (data->names, casefold, casefold_length);
+    }
+
+  if (G_LIKELY (parent != SEARCH_INDEX_NONE))
+    {
+      parent_entry = &g_array_index (data->entries, ThunarSearchIndexEntry, parent);
+      entry.next_sibling = parent_entry->first_child;
+      parent_entry->first_child = id;
+    }
+  else
+    {
+      g_array_append_val (data->roots, id);
+    }
+
+  g_array_append_val (data->entries, entry);
+  data->memory += sizeof (entry) + length + 1 + casefold_length;
+
+  /* roots are found by their path, not by their name */
+  if (G_LIKELY (parent != SEARCH_INDEX_NONE))
+    thunar_search_index_data_add_trigrams (data, id, casefold);
+
+  g_free (casefold);
+
+  return id;
+}
+
+
+
+static inline ThunarSearchIndexEntry*
+thunar_search_index_data_get (ThunarSearchIndexData *data,
+                              guint32                id)
+{
+  return &g_array_index (data->entries, ThunarSearchIndexEntry, id);
+}
+
+
+
+static inline const gchar*
+thunar_search_index_data_get_name (ThunarSearchIndexData *data,
+                                   guint32                id)
+{
+  return data->names->str + thunar_search_index_data_get (data, id)->name;
+}
+
+
+
+static inline const gchar*
+thunar_search_index_data_get_casefold (ThunarSearchIndexData *data,
+                                       guint32                id)
+{
+  return data->names->str + thunar_search_index_data_get (data, id)->casefold;
+}
+
+
+
+static void
+thunar_search_index_data_remove (ThunarSearchIndexData *data,
+                                 guint32                id)
+{
+  ThunarSearchIndexEntry *entry = thunar_search_index_data_get (data, id);
+  guint32                *link;
+
+  /* unlink the entry from the children of its parent, the entries
+   * below it are not reachable anymore, and the trigrams of the
+   * removed entries are skipped by the queries */
+  for (link = &thunar_search_index_data_get (data, entry->parent)->first_child;
+       *link != SEARCH_INDEX_NONE;
+       link = &thunar_search_index_data_get (data, *link)->next_sibling)
+    if (*link == id)
+      {
+        *link = entry->next_sibling;
+        break;
+      }
+
+  entry->next_sibling = SEARCH_INDEX_NONE;
+  entry->flags |= SEARCH_INDEX_REMOVED;
+}
+
+
+
+static guint32
+thunar_search_index_data_lookup_child (ThunarSearchIndexData *data,
+                                       guint32                parent,
+                                       const gchar           *name)
+{
+  guint32 id;
+
+  for (id = thunar_search_index_data_get (data, parent)->first_child;
+       id != SEARCH_INDEX_NONE;
+       id = thunar_search_index_data_get (data, id)->next_sibling)
+    if (strcmp (thunar_search_index_data_get_name (data, id), name) == 0)
+      break;
+
+  return id;
+}
+
+
+
+static guint32
+thunar_search_index_data_lookup_root (ThunarSearchIndexData *data,
+                                      const gchar           *path)
+{
+  guint32 id;
+  guint   n;
+
+  for (n = 0; n < data->roots->len; ++n)
+    {
+      id = g_array_index (data->roots, guint32, n);
+      if (strcmp (thunar_search_index_data_get_name (data, id), path) == 0)
+        return id;
+    }
+
+  return SEARCH_INDEX_NONE;
+}
+
+
+
+static guint32
+thunar_search_index_data_lookup (ThunarSearchIndexData *data,
+                                 const gchar           *path)
+{
+  const gchar *root;
+  guint32      id = SEARCH_INDEX_NONE;
+  gchar      **components;
+  gsize        length;
+  guint        n, i;
+
+  for (n = 0; n < data->roots->len && id == SEARCH_INDEX_NONE; ++n)
+    {
+      id = g_array_index (data->roots, guint32, n);
+      root = thunar_search_index_data_get_name (data, id);
+      length = strlen (root);
+
+      /* check if the path is the root or below it */
+      if (strncmp (path, root, length) != 0)
+        {
+          id = SEARCH_INDEX_NONE;
+        }
+      else if (path[length] != '\0')
+        {
+          if (path[length] != G_DIR_SEPARATOR && root[length - 1] != G_DIR_SEPARATOR)
+            {
+              id = SEARCH_INDEX_NONE;
+              continue;
+            }
+
+          /* walk down to the folder */
+          components = g_strsplit (path + length, G_DIR_SEPARATOR_S, -1);
+          for (i = 0; components[i] != NULL && id != SEARCH_INDEX_NONE; ++i)
+            if (*components[i] != '\0')
+              id = thunar_search_index_data_lookup_child (data, id, components[i]);
+          g_strfreev (components);
+          break;
+        }
+    }
+
+  return id;
+}
+
+
+
+static ThunarSearchIndexData*
+thunar_search_index_data_load (GFile *file,
+                               gsize  max_memory)
+{
+  ThunarSearchIndexEntry *entry;
+  ThunarSearchIndexData  *data = NULL;
+  GFileInputStream       *stream;
+  GDataInputStream       *input;
+  GError                 *error = NULL;
+  gboolean                damaged = FALSE;
+  gchar                   magic[sizeof (SEARCH_INDEX_MAGIC)];
+  gchar                   name[G_MAXUINT16 + 1];
+  gchar                   record;
+  guint32                 parent;
+  guint32                 id;
+  guint64                 mtime;
+  guint16                 length;
+  guint8                  flags;
+
+  stream = g_file_read (file, NULL, NULL);
+  if (G_UNLIKELY (stream == NULL))
+    return NULL;
+
+  input = g_data_input_stream_new (G_INPUT_STREAM (stream));
+  g_object_unref (stream);
+
+  if (!g_input_stream_read_all (G_INPUT_STREAM (input), magic, sizeof (magic), NULL, NULL, &error)
+      || memcmp (magic, SEARCH_INDEX_MAGIC, sizeof (magic)) != 0)
+    goto out;
+
+  /* replay the records until the end of the file */
+  data = thunar_search_index_data_new (max_memory);
+  while (!damaged && g_input_stream_read (G_INPUT_STREAM (input), &record, 1, NULL, &error) == 1)
+    {
+      switch (record)
+        {
+        case SEARCH_INDEX_RECORD_ADD:
+          parent = g_data_input_stream_read_uint32 (input, NULL, &error);
+          mtime = g_data_input_stream_read_uint64 (input, NULL, &error);
+          flags = g_data_input_stream_read_byte (input, NULL, &error);
+          length = g_data_input_stream_read_uint16 (input, NULL, &error);
+          if (error != NULL
+              || !g_input_stream_read_all (G_INPUT_STREAM (input), name, length, NULL, NULL, &error))
+            break;
+          name[length] = '\0';
+
+          /* parents come first, otherwise the file is damaged */
+          damaged = (parent != SEARCH_INDEX_NONE && parent >= data->entries->len)
+                 || thunar_search_index_data_add (data, parent, name, mtime, flags & ~SEARCH_INDEX_REMOVED) == SEARCH_INDEX_NONE;
+          break;
+
+        case SEARCH_INDEX_RECORD_UPDATE:
+          id = g_data_input_stream_read_uint32 (input, NULL, &error);
+          mtime = g_data_input_stream_read_uint64 (input, NULL, &error);
+          flags = g_data_input_stream_read_byte (input, NULL, &error);
+          damaged = (id >= data->entries->len);
+          if (error == NULL && !damaged)
+            {
+              entry = thunar_search_index_data_get (data, id);
+              entry->mtime = mtime;
+              entry->flags = (flags & ~SEARCH_INDEX_REMOVED) | (entry->flags & SEARCH_INDEX_REMOVED);
+            }
+          break;
+
+        case SEARCH_INDEX_RECORD_REMOVE:
+          id = g_data_input_stream_read_uint32 (input, NULL, &error);
+          damaged = (id >= data->entries->len
+                     || thunar_search_index_data_get (data, id)->parent == SEARCH_INDEX_NONE);
+          if (error == NULL && !damaged)
+            thunar_search_index_data_remove (data, id);
+          break;
+
+        default:
+          damaged = TRUE;
+          break;
+        }
+
+      if (error != NULL)
+        break;
+    }
+
+  /* a record cut short is damage too, the index is built again */
+  if (error != NULL || damaged)
+    {
+      thunar_search_index_data_unref (data);
+      data = NULL;
+    }
+
+out:
+  g_clear_error (&error);
+  g_object_unref (input);
+
+  return data;
+}
+
+
+
+static gboolean
+thunar_search_index_data_write (ThunarSearchIndexData *data,
+                                GDataOutputStream     *output,
+                                gchar                  record,
+                                guint32                id,
+                                GError               **error)
+{
+  ThunarSearchIndexEntry *entry = thunar_search_index_data_get (data, id);
+  const gchar            *name;
+  gsize                   length;
+
+  if (!g_data_output_stream_put_byte (output, record, NULL, error))
+    return FALSE;
+
+  switch (record)
+    {
+    case SEARCH_INDEX_RECORD_ADD:
+      name = thunar_search_index_data_get_name (data, id);
+      length = strlen (name);
+      return g_data_output_stream_put_uint32 (output, entry->parent, NULL, error)
+          && g_data_output_stream_put_uint64 (output, entry->mtime, NULL, error)
+          && g_data_output_stream_put_byte (output, entry->flags & ~SEARCH_INDEX_REMOVED, NULL, error)
+          && g_data_output_stream_put_uint16 (output, length, NULL, error)
+          && g_output_stream_write_all (G_OUTPUT_STREAM (output), name, length, NULL, NULL, error);
+
+    case SEARCH_INDEX_RECORD_UPDATE:
+      return g_data_output_stream_put_uint32 (output, id, NULL, error)
+          && g_data_output_stream_put_uint64 (output, entry->mtime, NULL, error)
+          && g_data_output_stream_put_byte (output, entry->flags & ~SEARCH_INDEX_REMOVED, NULL, error);
+
+    case SEARCH_INDEX_RECORD_REMOVE:
+      return g_data_output_stream_put_uint32 (output, id, NULL, error);
+
+    default:
+      _thunar_assert_not_reached ();
+      return FALSE;
+    }
+}
+
+
+
+static void
+thunar_search_index_data_save (ThunarSearchIndexData *data,
+                               GFile                 *file)
+{
+  GFileOutputStream *stream;
+  GDataOutputStream *output;
+  GOutputStream     *buffered;
+  GCancellable      *cancellable;
+  GError            *error = NULL;
+  guint32            id;
+
+  /* the file is replaced once everything is written */
+  stream = g_file_replace (file, NULL, FALSE, G_FILE_CREATE_PRIVATE | G_FILE_CREATE_REPLACE_DESTINATION, NULL, &error);
+  if (G_UNLIKELY (stream == NULL))
+    {
+      g_warning ("Failed to save the search index: %s", error->message);
+      g_error_free (error);
+      return;
+    }
+
+  buffered = g_buffered_output_stream_new_sized (G_OUTPUT_STREAM (stream), 64 * 1024);
+  output = g_data_output_stream_new (buffered);
+  g_object_unref (buffered);
+
+  g_output_stream_write_all (G_OUTPUT_STREAM (output), SEARCH_INDEX_MAGIC, sizeof (SEARCH_INDEX_MAGIC), NULL, NULL, &error);
+
+  /* removed entries are written too, so the ids stay the same */
+  for (id = 0; id < data->entries->len && error == NULL; ++id)
+    if (thunar_search_index_data_write (data, output, SEARCH_INDEX_RECORD_ADD, id, &error)
+        && (thunar_search_index_data_get (data, id)->flags & SEARCH_INDEX_REMOVED) != 0)
+      thunar_search_index_data_write (data, output, SEARCH_INDEX_RECORD_REMOVE, id, &error);
+
+  /* closing with a cancelled cancellable keeps the old index */
+  cancellable = g_cancellable_new ();
+  if (G_UNLIKELY (error != NULL))
+    {
+      g_warning ("Failed to save the search index: %s", error->message);
+      g_cancellable_cancel (cancellable);
+      g_error_free (error);
+    }
+
+  g_output_stream_close (G_OUTPUT_STREAM (output), cancellable, NULL);
+  g_object_unref (cancellable);
+  g_object_unref (output);
+  g_object_unref (stream);
+}
+
+
+
+static guint64
+thunar_search_index_get_mtime (GFileInfo *info)
+{
+  return g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED) * G_USEC_PER_SEC
+       + g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+}
+
+
+
+static inline gboolean
+thunar_search_index_build_stopped (ThunarSearchIndexBuilder *builder)
+{
+  return g_cancellable_is_cancelled (builder->index->cancellable) || builder->data->truncated;
+}
+
+
+
+static void
+thunar_search_index_build_copy (ThunarSearchIndexBuilder *builder,
+                                GFile                    *directory,
+                                guint32                   id,
+                                guint32                   old_id)
+{
+  ThunarSearchIndexEntry *old_entry;
+  const gchar            *name;
+  guint32                 child;
+  GFile                  *file;
+
+  /* the folder didn't change, so take its children from the old index */
+  for (child = thunar_search_index_data_get (builder->old, old_id)->first_child;
+       child != SEARCH_INDEX_NONE && !thunar_search_index_build_stopped (builder);
+       child = old_entry->next_sibling)
+    {
+      old_entry = thunar_search_index_data_get (builder->old, child);
+      name = thunar_search_index_data_get_name (builder->old, child);
+
+      if ((old_entry->flags & SEARCH_INDEX_DIRECTORY) != 0)
+        {
+          /* sub folders may have changed nevertheless */
+          file = g_file_get_child (directory, name);
+          thunar_search_index_build_directory (builder, file, id, name, SEARCH_INDEX_MTIME_UNKNOWN, child);
+          g_object_unref (file);
+        }
+      else
+        {
+          thunar_search_index_data_add (builder->data, id, name, 0, 0);
+        }
+    }
+}
+
+
+
+static void
+thunar_search_index_build_enumerate (ThunarSearchIndexBuilder *builder,
+                                     GFile                    *directory,
+                                     guint32                   id,
+                                     guint32                   old_id)
+{
+  GFileEnumerator *enumerator;
+  GHashTable      *old_children = NULL;
+  const gchar     *name;
+  GFileInfo       *info;
+  gpointer         child;
+  guint32          old_child;
+  GFile           *file;
+
+  enumerator = g_file_enumerate_children (directory, SEARCH_INDEX_ATTRIBUTES,
+                                          G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                          builder->index->cancellable, NULL);
+  if (G_UNLIKELY (enumerator == NULL))
+    return;
+
+  /* remember the old sub folders, their children may be reused */
+  if (old_id != SEARCH_INDEX_NONE)
+    {
+      old_children = g_hash_table_new (g_str_hash, g_str_equal);
+      for (old_child = thunar_search_index_data_get (builder->old, old_id)->first_child;
+           old_child != SEARCH_INDEX_NONE;
+           old_child = thunar_search_index_data_get (builder->old, old_child)->next_sibling)
+        if ((thunar_search_index_data_get (builder->old, old_child)->flags & SEARCH_INDEX_DIRECTORY) != 0)
+          g_hash_table_insert (old_children, (gpointer) thunar_search_index_data_get_name (builder->old, old_child),
+                               GUINT_TO_POINTER (old_child));
+    }
+
+  while (!thunar_search_index_build_stopped (builder))
+    {
+      info = g_file_enumerator_next_file (enumerator, builder->index->cancellable, NULL);
+      if (info == NULL)
+        break;
+
+      name = g_file_info_get_name (info);
+
+      /* symlinks are not followed, like the search does */
+      if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY)
+        {
+          if (old_children == NULL || !g_hash_table_lookup_extended (old_children, name, NULL, &child))
+            child = GUINT_TO_POINTER (SEARCH_INDEX_NONE);
+
+          file = g_file_get_child (directory, name);
+          thunar_search_index_build_directory (builder, file, id, name,
+                                               thunar_search_index_get_mtime (info),
+                                               GPOINTER_TO_UINT (child));
+          g_object_unref (file);
+        }
+      else
+        {
+          thunar_search_index_data_add (builder->data, id, name, 0, 0);
+        }
+
+      g_object_unref (info);
+    }
+
+  if (old_children != NULL)
+    g_hash_table_destroy (old_children);
+  g_object_unref (enumerator);
+}
+
+
+
+static void
+thunar_search_index_build_directory (ThunarSearchIndexBuilder *builder,
+                                     GFile                    *directory,
+                                     guint32                   parent,
+                                     const gchar              *name,
+                                     guint64                   mtime,
+                                     guint32                   old_id)
+{
+  ThunarSearchIndexEntry *old_entry = NULL;
+  GFileInfo              *info;
+  guint32                 id;
+
+  if (old_id != SEARCH_INDEX_NONE)
+    old_entry = thunar_search_index_data_get (builder->old, old_id);
+
+  if (mtime == SEARCH_INDEX_MTIME_UNKNOWN)
+    {
+      info = g_file_query_info (directory, SEARCH_INDEX_ATTRIBUTES,
+                                G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                builder->index->cancellable, NULL);
+      if (G_UNLIKELY (info == NULL))
+        return;
+
+      if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY)
+        mtime = thunar_search_index_get_mtime (info);
+      g_object_unref (info);
+
+      if (G_UNLIKELY (mtime == SEARCH_INDEX_MTIME_UNKNOWN))
+        return;
+    }
+
+  id = thunar_search_index_data_add (builder->data, parent, name, mtime, SEARCH_INDEX_DIRECTORY);
+  if (G_UNLIKELY (id == SEARCH_INDEX_NONE))
+    return;
+
+  /* the list of children is unchanged as long as the modification
+   * time is, but incomplete folders must be read again */
+  if (old_entry != NULL
+      && old_entry->mtime == mtime
+      && (old_entry->flags & SEARCH_INDEX_COMPLETE) != 0)
+    thunar_search_index_build_copy (builder, directory, id, old_id);
+  else
+    thunar_search_index_build_enumerate (builder, directory, id, old_id);
+
+  if (!thunar_search_index_build_stopped (builder))
+    thunar_search_index_data_get (builder->data, id)->flags |= SEARCH_INDEX_COMPLETE;
+}
+
+
+
+static void
+thunar_search_index_patch_log (ThunarSearchIndexBuilder *builder,
+                               gchar                     record,
+                               guint32                   id)
+{
+  GError *error = NULL;
+
+  if (builder->log != NULL
+      && !thunar_search_index_data_write (builder->data, builder->log, record, id, &error))
+    {
+      g_warning ("Failed to save the search index: %s", error->message);
+      g_error_free (error);
+
+      /* the file doesn't match the index anymore, drop it
+       * until the next full build writes a new one */
+      g_object_unref (builder->log);
+      builder->log = NULL;
+      g_file_delete (builder->file, NULL, NULL);
+    }
+}
+
+
+
+static void
+thunar_search_index_patch_directory (ThunarSearchIndexBuilder *builder,
+                                     GFile                    *directory,
+                                     guint32                   id)
+{
+  ThunarSearchIndexEntry *entry;
+  ThunarSearchIndexData  *data = builder->data;
+  GFileEnumerator        *enumerator;
+  GHashTableIter          iter;
+  GHashTable             *present;
+  const gchar            *name;
+  GFileInfo              *info;
+  GError                 *error = NULL;
+  GFile                  *file;
+  GSList                 *new_folders = NULL;
+  GSList                 *lp;
+  GList                  *infos = NULL;
+  guint64                 mtime;
+  guint32                 child;
+  guint32                 next;
+  gboolean                is_directory;
+  gboolean                complete;
+
+  /* read the folder without holding the lock, a folder
+   * that is gone is removed with its parent folder */
+  info = g_file_query_info (directory, SEARCH_INDEX_ATTRIBUTES,
+                            G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                            builder->index->cancellable, NULL);
+  if (G_UNLIKELY (info == NULL))
+    return;
+  mtime = thunar_search_index_get_mtime (info);
+  g_object_unref (info);
+
+  enumerator = g_file_enumerate_children (directory, SEARCH_INDEX_ATTRIBUTES,
+                                          G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                          builder->index->cancellable, NULL);
+  if (G_UNLIKELY (enumerator == NULL))
+    return;
+
+  present = g_hash_table_new (g_str_hash, g_str_equal);
+  while ((info = g_file_enumerator_next_file (enumerator, builder->index->cancellable, &error)) != NULL)
+    {
+      infos = g_list_prepend (infos, info);
+      g_hash_table_insert (present, (gpointer) g_file_info_get_name (info), info);
+    }
+  g_object_unref (enumerator);
+
+  /* a folder read only in part stays incomplete */
+  complete = (error == NULL);
+  g_clear_error (&error);
+
+  g_rw_lock_writer_lock (&data->lock);
+
+  /* the folder is incomplete until all new folders below are read */
+  entry = thunar_search_index_data_get (data, id);
+  entry->mtime = mtime;
+  entry->flags &= ~SEARCH_INDEX_COMPLETE;
+  thunar_search_index_patch_log (builder, SEARCH_INDEX_RECORD_UPDATE, id);
+
+  /* remove the children that are gone, keep the others */
+  for (child = entry->first_child; child != SEARCH_INDEX_NONE; child = next)
+    {
+      next = thunar_search_index_data_get (data, child)->next_sibling;
+      name = thunar_search_index_data_get_name (data, child);
+      info = g_hash_table_lookup (present, name);
+
+      is_directory = (thunar_search_index_data_get (data, child)->flags & SEARCH_INDEX_DIRECTORY) != 0;
+      if (info != NULL && (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY) == is_directory)
+        {
+          g_hash_table_remove (present, name);
+        }
+      else if (complete)
+        {
+          thunar_search_index_data_remove (data, child);
+          thunar_search_index_patch_log (builder, SEARCH_INDEX_RECORD_REMOVE, child);
+        }
+    }
+
+  /* add the new children, symlinks are not followed */
+  g_hash_table_iter_init (&iter, present);
+  while (g_hash_table_iter_next (&iter, (gpointer) &name, (gpointer) &info))
+    {
+      is_directory = (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY);
+      child = thunar_search_index_data_add (data, id, name,
+                                            is_directory ? thunar_search_index_get_mtime (info) : 0,
+                                            is_directory ? SEARCH_INDEX_DIRECTORY : 0);
+      if (G_UNLIKELY (child == SEARCH_INDEX_NONE))
+        break;
+
+      thunar_search_index_patch_log (builder, SEARCH_INDEX_RECORD_ADD, child);
+      if (is_directory)
+        new_folders = g_slist_prepend (new_folders, GUINT_TO_POINTER (child));
+    }
+
+  g_rw_lock_writer_unlock (&data->lock);
+
+  g_hash_table_destroy (present);
+  g_list_free_full (infos, g_object_unref);
+
+  /* read the new folders, the builder is the only writer, so
+   * it doesn't need the lock to read the data */
+  for (lp = new_folders; lp != NULL && !thunar_search_index_build_stopped (builder); lp = lp->next)
+    {
+      child = GPOINTER_TO_UINT (lp->data);
+      file = g_file_get_child (directory, thunar_search_index_data_get_name (data, child));
+      thunar_search_index_patch_directory (builder, file, child);
+      g_object_unref (file);
+
+      if ((thunar_search_index_data_get (data, child)->flags & SEARCH_INDEX_COMPLETE) == 0)
+        complete = FALSE;
+    }
+  g_slist_free (new_folders);
+
+  if (complete && !thunar_search_index_build_stopped (builder))
+    {
+      g_rw_lock_writer_lock (&data->lock);
+      thunar_search_index_data_get (data, id)->flags |= SEARCH_INDEX_COMPLETE;
+      thunar_search_index_patch_log (builder, SEARCH_INDEX_RECORD_UPDATE, id);
+      g_rw_lock_writer_unlock (&data->lock);
+    }
+}
+
+
+
+static void
+thunar_search_index_patch (ThunarSearchIndexBuilder *builder)
+{
+  ThunarSearchIndexEntry *entry;
+  GFileOutputStream      *stream;
+  GHashTableIter          iter;
+  GOutputStream          *buffered;
+  GError                 *error = NULL;
+  GFile                  *directory;
+  gchar                  *path;
+  guint32                 id;
+
+  /* append the changes to the index on disk */
+  if (builder->file != NULL)
+    {
+      stream = g_file_append_to (builder->file, G_FILE_CREATE_PRIVATE, NULL, &error);
+      if (G_LIKELY (stream != NULL))
+        {
+          buffered = g_buffered_output_stream_new_sized (G_OUTPUT_STREAM (stream), 64 * 1024);
+          builder->log = g_data_output_stream_new (buffered);
+          g_object_unref (buffered);
+          g_object_unref (stream);
+        }
+      else
+        {
+          g_warning ("Failed to save the search index: %s", error->message);
+          g_clear_error (&error);
+        }
+    }
+
+  g_hash_table_iter_init (&iter, builder->dirty);
+  while (!thunar_search_index_build_stopped (builder)
+         && g_hash_table_iter_next (&iter, (gpointer) &directory, NULL))
+    {
+      path = g_file_get_path (directory);
+      id = (path != NULL) ? thunar_search_index_data_lookup (builder->data, path) : SEARCH_INDEX_NONE;
+      g_free (path);
+
+      /* folders that are not completely indexed are read by the next full build */
+      if (id == SEARCH_INDEX_NONE)
+        continue;
+      entry = thunar_search_index_data_get (builder->data, id);
+      if ((entry->flags & SEARCH_INDEX_DIRECTORY) != 0
+          && (entry->flags & SEARCH_INDEX_COMPLETE) != 0)
+        thunar_search_index_patch_directory (builder, directory, id);
+    }
+
+  if (builder->log != NULL)
+    {
+      if (!g_output_stream_close (G_OUTPUT_STREAM (builder->log), NULL, &error))
+        {
+          g_warning ("Failed to save the search index: %s", error->message);
+          g_error_free (error);
+          g_file_delete (builder->file, NULL, NULL);
+        }
+      g_object_unref (builder->log);
+      builder->log = NULL;
+    }
+}
+
+
+
+static gpointer
+thunar_search_index_thread (gpointer user_data)
+{
+  ThunarSearchIndexBuilder *builder = user_data;
+  ThunarSearchIndex        *index = builder->index;
+  guint32                   old_id;
+  GFile                    *file;
+  guint                     n;
+
+#if defined (HAVE_SYS_SYSCALL_H) && defined (SYS_ioprio_set)
+  /* use the idle I/O class for this thread (IOPRIO_WHO_PROCESS
+   * with id 0 is the calling thread), so the indexer doesn't
+   * slow down other disk access */
+  syscall (SYS_ioprio_set, 1, 0, 3 << 13);
+#endif
+
+  /* start from the index on disk the first time */
+  if (builder->old == NULL && builder->file != NULL)
+    {
+      builder->old = thunar_search_index_data_load (builder->file, index->max_memory);
+      if (builder->old != NULL)
+        {
+          g_mutex_lock (&index->lock);
+          index->data = thunar_search_index_data_ref (builder->old);
+          g_mutex_unlock (&index->lock);
+        }
+    }
+
+  if (builder->dirty != NULL)
+    {
+      /* only folders reported by the monitors changed, so patch them
+       * in the index in use, the others are checked by the next full
+       * build, which also drops the removed entries */
+      builder->data = thunar_search_index_data_ref (builder->old);
+      thunar_search_index_patch (builder);
+    }
+  else
+    {
+      builder->data = thunar_search_index_data_new (index->max_memory);
+
+      for (n = 0; builder->roots[n] != NULL && !thunar_search_index_build_stopped (builder); ++n)
+        {
+          old_id = SEARCH_INDEX_NONE;
+          if (builder->old != NULL)
+            old_id = thunar_search_index_data_lookup_root (builder->old, builder->roots[n]);
+
+          file = g_file_new_for_path (builder->roots[n]);
+          thunar_search_index_build_directory (builder, file, SEARCH_INDEX_NONE, builder->roots[n],
+                                               SEARCH_INDEX_MTIME_UNKNOWN, old_id);
+          g_object_unref (file);
+        }
+    }
+
+  /* a build stopped at the memory ceiling is still usable, only
+   * the folders marked complete are used to answer queries */
+  if (builder->dirty == NULL && !g_cancellable_is_cancelled (index->cancellable))
+    {
+      g_mutex_lock (&index->lock);
+      if (index->data != NULL)
+        thunar_search_index_data_unref (index->data);
+      index->data = thunar_search_index_data_ref (builder->data);
+      g_mutex_unlock (&index->lock);
+
+      if (builder->file != NULL)
+        thunar_search_index_data_save (builder->data, builder->file);
+    }
+
+  if (builder->old != NULL)
+    thunar_search_index_data_unref (builder->old);
+  thunar_search_index_data_unref (builder->data);
+  if (builder->dirty != NULL)
+    g_hash_table_destroy (builder->dirty);
+  if (builder->file != NULL)
+    g_object_unref (builder->file);
+  g_strfreev (builder->roots);
+  g_slice_free (ThunarSearchIndexBuilder, builder);
+
+  g_atomic_int_set (&index->building, FALSE);
+  thunar_search_index_release (index);
+
+  return NULL;
+}
+
+
+
+static gboolean
+thunar_search_index_path_is_below (const gchar *path,
+                                   const gchar *root)
+{
+  gsize length = strlen (root);
+
+  return strncmp (path, root, length) == 0
+      && (path[length] == G_DIR_SEPARATOR || (length > 0 && root[length - 1] == G_DIR_SEPARATOR));
+}
+
+
+
+static gchar**
+thunar_search_index_get_roots (ThunarSearchIndex *index)
+{
+  GPtrArray *roots;
+  GList     *mounts;
+  GList     *lp;
+  GFile     *location;
+  gchar    **paths;
+  gchar     *path;
+  guint      n, m;
+
+  roots = g_ptr_array_new ();
+
+  if (index->roots != NULL && *index->roots != '\0')
+    {
+      /* the roots set by the user, relative paths are ignored */
+      paths = g_strsplit (index->roots, ";", -1);
+      for (n = 0; paths[n] != NULL; ++n)
+        if (g_path_is_absolute (paths[n]))
+          g_ptr_array_add (roots, g_strdup (paths[n]));
+      g_strfreev (paths);
+    }
+  else
+    {
+      /* the home folder and the mounted volumes */
+      g_ptr_array_add (roots, g_strdup (g_get_home_dir ()));
+
+      mounts = g_volume_monitor_get_mounts (index->volume_monitor);
+      for (lp = mounts; lp != NULL; lp = lp->next)
+        {
+          if (!g_mount_is_shadowed (lp->data))
+            {
+              location = g_mount_get_root (lp->data);
+              path = g_file_get_path (location);
+              if (path != NULL && strcmp (path, G_DIR_SEPARATOR_S) != 0)
+                g_ptr_array_add (roots, path);
+              else
+                g_free (path);
+              g_object_unref (location);
+            }
+          g_object_unref (lp->data);
+        }
+      g_list_free (mounts);
+    }
+
+  /* drop duplicates and roots below other roots */
+  for (n = roots->len; n-- > 0; )
+    for (m = 0; m < roots->len; ++m)
+      if (m != n
+          && ((m < n && strcmp (roots->pdata[n], roots->pdata[m]) == 0)
+              || thunar_search_index_path_is_below (roots->pdata[n], roots->pdata[m])))
+        {
+          g_free (g_ptr_array_remove_index (roots, n));
+          break;
+        }
+
+  g_ptr_array_add (roots, NULL);
+
+  return (gchar **) g_ptr_array_free (roots, FALSE);
+}
+
+
+
+static gboolean
+thunar_search_index_start (ThunarSearchIndex *index)
+{
+  ThunarSearchIndexBuilder *builder;
+
+  _thunar_return_val_if_fail (THUNAR_IS_SEARCH_INDEX (index), FALSE);
+
+  /* try again later if a build is running */
+  if (g_atomic_int_get (&index->building))
+    return FALSE;
+
+  builder = g_slice_new0 (ThunarSearchIndexBuilder);
+  builder->index = g_object_ref (G_OBJECT (index));
+  builder->roots = thunar_search_index_get_roots (index);
+  if (index->file != NULL)
+    builder->file = g_object_ref (index->file);
+
+  g_mutex_lock (&index->lock);
+  if (index->data != NULL)
+    builder->old = thunar_search_index_data_ref (index->data);
+  g_mutex_unlock (&index->lock);
+
+  /* check only the changed folders, unless everything must be checked */
+  if (!index->full_rescan && builder->old != NULL)
+    {
+      builder->dirty = index->dirty;
+      index->dirty = g_hash_table_new_full (g_file_hash, (GEqualFunc) g_file_equal, g_object_unref, NULL);
+    }
+  else
+    {
+      g_hash_table_remove_all (index->dirty);
+    }
+  index->full_rescan = FALSE;
+
+  g_atomic_int_set (&index->building, TRUE);
+  g_thread_unref (g_thread_new ("thunar-search-index", thunar_search_index_thread, builder));
+
+  return TRUE;
+}
+
+
+
+static gboolean
+thunar_search_index_rescan_timeout (gpointer user_data)
+{
+  ThunarSearchIndex *index = THUNAR_SEARCH_INDEX (user_data);
+
+  /* a running build is not interrupted, the next rescan checks everything */
+  index->full_rescan = TRUE;
+  thunar_search_index_start (index);
+
+  return TRUE;
+}
+
+
+
+static gboolean
+thunar_search_index_changed_timeout (gpointer user_data)
+{
+  ThunarSearchIndex *index = THUNAR_SEARCH_INDEX (user_data);
+
+  /* keep the timeout until the build is started */
+  if (!thunar_search_index_start (index))
+    return TRUE;
+
+  index->changed_id = 0;
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_search_index_schedule (ThunarSearchIndex *index)
+{
+  /* collect the changes for a while, and index them at once */
+  if (index->changed_id == 0)
+    index->changed_id = g_timeout_add_seconds (SEARCH_INDEX_CHANGED_DELAY, thunar_search_index_changed_timeout, index);
+}
+
+
+
+static void
+thunar_search_index_mounts_changed (ThunarSearchIndex *index)
+{
+  _thunar_return_if_fail (THUNAR_IS_SEARCH_INDEX (index));
+
+  /* the roots depend on the mounted volumes */
+  if (index->roots == NULL || *index->roots == '\0')
+    {
+      index->full_rescan = TRUE;
+      thunar_search_index_schedule (index);
+    }
+}
+
+
+
+/**
+ * thunar_search_index_new:
+ *
+ * Allocates a new #ThunarSearchIndex. The index is loaded from
+ * disk and kept up to date by a background thread until it is
+ * replaced as the default index.
+ *
+ * Return value: the newly allocated #ThunarSearchIndex.
+ **/
+ThunarSearchIndex*
+thunar_search_index_new (void)
+{
+  return g_object_new (THUNAR_TYPE_SEARCH_INDEX, NULL);
+}
+
+
+
+/**
+ * thunar_search_index_set_default:
+ * @index : a #ThunarSearchIndex or %NULL.
+ *
+ * Makes @index the index returned by thunar_search_index_get_default(),
+ * or unsets the default index if @index is %NULL. The caller must hold
+ * a reference on @index until it is not the default anymore.
+ *
+ * The previous default index stops indexing, so the references of
+ * the threads using it are released soon. This function must be
+ * called from the main thread.
+ **/
+void
+thunar_search_index_set_default (ThunarSearchIndex *index)
+{
+  ThunarSearchIndex *old_index;
+
+  _thunar_return_if_fail (index == NULL || THUNAR_IS_SEARCH_INDEX (index));
+
+  /* no thread can take a new reference on the old index after this */
+  G_LOCK (search_index_default);
+  old_index = search_index_default;
+  search_index_default = index;
+  G_UNLOCK (search_index_default);
+
+  if (old_index != NULL && old_index != index)
+    thunar_search_index_stop (old_index);
+}
+
+
+
+/**
+ * thunar_search_index_get_default:
+ *
+ * Returns a reference on the default #ThunarSearchIndex, or
+ * %NULL if indexing is disabled. This function may be called
+ * from any thread.
+ *
+ * The caller is responsible to free the returned object using
+ * thunar_search_index_release() when no longer needed.
+ *
+ * Return value: the default #ThunarSearchIndex or %NULL.
+ **/
+ThunarSearchIndex*
+thunar_search_index_get_default (void)
+{
+  ThunarSearchIndex *index = NULL;
+
+  G_LOCK (search_index_default);
+  if (search_index_default != NULL)
+    index = g_object_ref (search_index_default);
+  G_UNLOCK (search_index_default);
+
+  return index;
+}
+
+
+
+/**
+ * thunar_search_index_release:
+ * @index : a #ThunarSearchIndex.
+ *
+ * Releases a reference on @index from any thread. The reference
+ * is dropped in the main thread, so the index is always finalized
+ * there.
+ **/
+void
+thunar_search_index_release (ThunarSearchIndex *index)
+{
+  _thunar_return_if_fail (THUNAR_IS_SEARCH_INDEX (index));
+
+  /* runs right away if called from the main thread */
+  g_main_context_invoke (NULL, thunar_search_index_release_idle, index);
+}
+
+
+
+static GFile*
+thunar_search_index_data_get_file (ThunarSearchIndexData *data,
+                                   guint32                id)
+{
+  GPtrArray *components;
+  GFile     *file;
+  gchar     *path;
+
+  /* collect the names up to the root, which holds the full path */
+  components = g_ptr_array_new ();
+  for (; id != SEARCH_INDEX_NONE; id = thunar_search_index_data_get (data, id)->parent)
+    g_ptr_array_add (components, (gpointer) thunar_search_index_data_get_name (data, id));
+
+  /* reverse them in place, and join them */
+  for (id = 0; id < components->len / 2; ++id)
+    {
+      path = components->pdata[id];
+      components->pdata[id] = components->pdata[components->len - id - 1];
+      components->pdata[components->len - id - 1] = path;
+    }
+  g_ptr_array_add (components, NULL);
+
+  path = g_build_filenamev ((gchar **) components->pdata);
+  file = g_file_new_for_path (path);
+  g_ptr_array_free (components, TRUE);
+  g_free (path);
+
+  return file;
+}
+
+
+
+static gboolean
+thunar_search_index_data_is_below (ThunarSearchIndexData *data,
+                                   guint32                id,
+                                   guint32                ancestor,
+                                   guint                  max_depth)
+{
+  guint depth;
+
+  for (depth = 1;; ++depth)
+    {
+      /* entries below a removed folder are removed too */
+      if ((thunar_search_index_data_get (data, id)->flags & SEARCH_INDEX_REMOVED) != 0)
+        return FALSE;
+
+      id = thunar_search_index_data_get (data, id)->parent;
+      if (id == ancestor)
+        return (max_depth == 0 || depth <= max_depth + 1);
+      else if (id == SEARCH_INDEX_NONE)
+        return FALSE;
+    }
+}
+
+
+
+static GList*
+thunar_search_index_data_match_below (ThunarSearchIndexData      *data,
+                                      guint32                     ancestor,
+                                      const ThunarSearchCriteria *criteria)
+{
+  ThunarSearchIndexEntry *entry;
+  GList                  *files = NULL;
+  guint32                 id;
+  guint                   depth = 1;
+
+  /* walk the entries below the folder, removed entries are not linked */
+  for (id = thunar_search_index_data_get (data, ancestor)->first_child; id != SEARCH_INDEX_NONE; )
+    {
+      entry = thunar_search_index_data_get (data, id);
+      if (thunar_search_criteria_matches_casefold (criteria, thunar_search_index_data_get_casefold (data, id)))
+        files = g_list_prepend (files, thunar_search_index_data_get_file (data, id));
+
+      if (entry->first_child != SEARCH_INDEX_NONE
+          && (criteria->max_depth == 0 || depth <= criteria->max_depth))
+        {
+          /* descend into the folder */
+          id = entry->first_child;
+          depth++;
+        }
+      else
+        {
+          /* continue with the next sibling of the folder or its parents */
+          for (; id != ancestor && thunar_search_index_data_get (data, id)->next_sibling == SEARCH_INDEX_NONE; depth--)
+            id = thunar_search_index_data_get (data, id)->parent;
+
+          id = (id != ancestor) ? thunar_search_index_data_get (data, id)->next_sibling : SEARCH_INDEX_NONE;
+        }
+    }
+
+  return files;
+}
+
+
+
+/**
+ * thunar_search_index_query:
+ * @index        : a #ThunarSearchIndex.
+ * @directory    : the folder to search in.
+ * @criteria     : the #ThunarSearchCriteria.
+ * @files_return : return location for the matching #GFile<!---->s.
+ *
+ * Looks up the files below @directory whose names match the
+ * pattern and depth of @criteria. The size and date limits are
+ * not checked, and the results are as recent as the index, so
+ * the caller should check them on the files themselves.
+ *
+ * Substring patterns of at least three characters are answered
+ * from the trigrams of the names, other patterns check the names
+ * below @directory.
+ *
+ * If @directory is not completely indexed, %FALSE is returned
+ * and the caller has to search the file system instead. This
+ * function may be called from any thread.
+ *
+ * Return value: %TRUE if @files_return was set.
+ **/
+gboolean
+thunar_search_index_query (ThunarSearchIndex          *index,
+                           GFile                      *directory,
+                           const ThunarSearchCriteria *criteria,
+                           GList                     **files_return)
+{
+  ThunarSearchIndexData *data;
+  const gchar           *p;
+  GArray                *candidates = NULL;
+  GArray                *ids;
+  gboolean               found = TRUE;
+  gchar                 *path;
+  guint32                dir_id;
+  guint32                id;
+  guint                  n;
+
+  _thunar_return_val_if_fail (THUNAR_IS_SEARCH_INDEX (index), FALSE);
+  _thunar_return_val_if_fail (G_IS_FILE (directory), FALSE);
+  _thunar_return_val_if_fail (criteria != NULL, FALSE);
+  _thunar_return_val_if_fail (files_return != NULL, FALSE);
+
+  g_mutex_lock (&index->lock);
+  data = (index->data != NULL) ? thunar_search_index_data_ref (index->data) : NULL;
+  g_mutex_unlock (&index->lock);
+
+  if (data == NULL)
+    return FALSE;
+
+  path = g_file_get_path (directory);
+  g_rw_lock_reader_lock (&data->lock);
+
+  dir_id = (path != NULL) ? thunar_search_index_data_lookup (data, path) : SEARCH_INDEX_NONE;
+  g_free (path);
+
+  if (dir_id == SEARCH_INDEX_NONE
+      || (thunar_search_index_data_get (data, dir_id)->flags & SEARCH_INDEX_COMPLETE) == 0)
+    {
+      g_rw_lock_reader_unlock (&data->lock);
+      thunar_search_index_data_unref (data);
+      return FALSE;
+    }
+
+  /* take the shortest list of entries sharing a trigram with the pattern */
+  if (criteria->pattern_spec == NULL
+      && criteria->pattern_casefold != NULL
+      && strlen (criteria->pattern_casefold) >= 3)
+    {
+      for (p = criteria->pattern_casefold; p[2] != '\0' && found; ++p)
+        {
+          ids = g_hash_table_lookup (data->trigrams, GUINT_TO_POINTER (SEARCH_INDEX_TRIGRAM (p)));
+          if (ids == NULL)
+            found = FALSE;
+          else if (candidates == NULL || ids->len < candidates->len)
+            candidates = ids;
+        }
+    }
+
+  *files_return = NULL;
+
+  if (candidates != NULL)
+    {
+      for (n = 0; n < candidates->len && found; ++n)
+        {
+          id = g_array_index (candidates, guint32, n);
+          if (thunar_search_index_data_is_below (data, id, dir_id, criteria->max_depth)
+              && thunar_search_criteria_matches_casefold (criteria, thunar_search_index_data_get_casefold (data, id)))
+            *files_return = g_list_prepend (*files_return, thunar_search_index_data_get_file (data, id));
+        }
+    }
+  else if (found)
+    {
+      /* globs and short patterns only check the names below the folder */
+      *files_return = thunar_search_index_data_match_below (data, dir_id, criteria);
+    }
+
+  g_rw_lock_reader_unlock (&data->lock);
+  thunar_search_index_data_unref (data);
+
+  return TRUE;
+}
+
+
+
+/**
+ * thunar_search_index_folder_changed:
+ * @directory : a folder whose children changed.
+ *
+ * Called by the folder monitors when files were added to or
+ * removed from @directory. The folder is indexed again a little
+ * later together with the other changed folders.
+ **/
+void
+thunar_search_index_folder_changed (GFile *directory)
+{
+  ThunarSearchIndex *index;
+
+  _thunar_return_if_fail (G_IS_FILE (directory));
+
+  index = thunar_search_index_get_default ();
+  if (index == NULL)
+    return;
+
+  if (g_file_is_native (directory)
+      && !g_hash_table_contains (index->dirty, directory))
+    {
+      g_hash_table_add (index->dirty, g_object_ref (directory));
+      thunar_search_index_schedule (index);
+    }
+
+  thunar_search_index_release (index);
+}
@@ -0,0 +1,56 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 The Xfce Development Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __THUNAR_SEARCH_INDEX_H__
+#define __THUNAR_SEARCH_INDEX_H__
+
+#include <thunar/thunar-search-criteria.h>
+
+G_BEGIN_DECLS;
+
+typedef struct _ThunarSearchIndexClass ThunarSearchIndexClass;
+typedef struct _ThunarSearchIndex      ThunarSearchIndex;
+
+#define THUNAR_TYPE_SEARCH_INDEX            (thunar_search_index_get_type ())
+#define THUNAR_SEARCH_INDEX(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), THUNAR_TYPE_SEARCH_INDEX, ThunarSearchIndex))
+#define THUNAR_SEARCH_INDEX_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), THUNAR_TYPE_SEARCH_INDEX, ThunarSearchIndexClass))
+#define THUNAR_IS_SEARCH_INDEX(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), THUNAR_TYPE_SEARCH_INDEX))
+#define THUNAR_IS_SEARCH_INDEX_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), THUNAR_TYPE_SEARCH_INDEX))
+#define THUNAR_SEARCH_INDEX_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), THUNAR_TYPE_SEARCH_INDEX, ThunarSearchIndexClass))
+
+GType              thunar_search_index_get_type       (void) G_GNUC_CONST;
+
+ThunarSearchIndex *thunar_search_index_new            (void) G_GNUC_MALLOC;
+
+void               thunar_search_index_set_default    (ThunarSearchIndex          *index);
+ThunarSearchIndex *thunar_search_index_get_default    (void);
+
+void               thunar_search_index_release        (ThunarSearchIndex          *index);
+
+gboolean           thunar_search_index_query          (ThunarSearchIndex          *index,
+                                                       GFile                      *directory,
+                                                       const ThunarSearchCriteria *criteria,
+                                                       GList                     **files_return);
+
+void               thunar_search_index_folder_changed (GFile                      *directory);
+
+G_END_DECLS;
+
+#endif /* !__THUNAR_SEARCH_INDEX_H__ */
@@ -87,6 +87,14 @@ static void          thunar_shortcuts_pane_drag_perform_drop     (GtkPlacesSideb
                                                                   GList                    *source_file_list,
                                                                   GdkDragAction             action,
                                                                   ThunarShortcutsPane      *shortcuts_pane);
+static void          thunar_shortcuts_pane_drag_dest_file_ready  (GFile                    *location,
+                                                                  ThunarFile               *file,
+                                                                  GError                   *error,
+                                                                  gpointer                  user_data);
+static void          thunar_shortcuts_pane_drag_drop_file_ready  (GFile                    *location,
+                                                                  ThunarFile               *file,
+                                                                  GError                   *error,
+                                                                  gpointer                  user_data);
 static gint          thunar_shortcuts_pane_drag_action_ask       (GtkPlacesSidebar         *sidebar,
                                                                   GdkDragAction             actions,
                                                                   ThunarShortcutsPane      *shortcuts_pane);
@@ -113,8 +121,24 @@ struct _ThunarShortcutsPane
   GtkWidget        *places;
 
   guint             idle_select_directory;
+
+  /* the destination of the drag motion, loaded without blocking */
+  GFile            *drag_dest_location;
+  ThunarFile       *drag_dest_file;
+
+  /* cancelled when the pane is disposed, for drags and
+   * drops waiting on the destination file */
+  GCancellable     *drop_cancellable;
 };
 
+typedef struct
+{
+  ThunarShortcutsPane *shortcuts_pane;
+  GCancellable        *cancellable;
+  GList               *source_file_list;
+  GdkDragAction        action;
+} ThunarShortcutsPaneDrop;
+
 
 
 static const GtkActionEntry action_entries[] =
@@ -193,6 +217,8 @@ thunar_shortcuts_pane_init (ThunarShortcutsPane *shortcuts_pane)
   gtk_action_group_set_translation_domain (shortcuts_pane->action_group, GETTEXT_PACKAGE);
   gtk_action_group_add_actions (shortcuts_pane->action_group, action_entries, G_N_ELEMENTS (action_entries), shortcuts_pane);
 
+  shortcuts_pane->drop_cancellable = g_cancellable_new ();
+
   /* configure the places sidebar */
   shortcuts_pane->places = gtk_places_sidebar_new ();
   gtk_places_sidebar_set_open_flags (GTK_PLACES_SIDEBAR (shortcuts_pane->places), GTK_PLACES_OPEN_NORMAL|GTK_PLACES_OPEN_NEW_TAB|GTK_PLACES_OPEN_NEW_WINDOW);
@@ -217,6 +243,20 @@ thunar_shortcuts_pane_dispose (GObject *object)
   thunar_component_set_selected_files (THUNAR_COMPONENT (shortcuts_pane), NULL);
   thunar_component_set_ui_manager (THUNAR_COMPONENT (shortcuts_pane), NULL);
 
+  /* drop nothing once the destination file is loaded */
+  g_cancellable_cancel (shortcuts_pane->drop_cancellable);
+
+  if (shortcuts_pane->drag_dest_file != NULL)
+    {
+      g_object_unref (shortcuts_pane->drag_dest_file);
+      shortcuts_pane->drag_dest_file = NULL;
+    }
+  if (shortcuts_pane->drag_dest_location != NULL)
+    {
+      g_object_unref (shortcuts_pane->drag_dest_location);
+      shortcuts_pane->drag_dest_location = NULL;
+    }
+
   (*G_OBJECT_CLASS (thunar_shortcuts_pane_parent_class)->dispose) (object);
 }
 
@@ -230,6 +270,8 @@ thunar_shortcuts_pane_finalize (GObject *object)
   /* release our action group */
   g_object_unref (G_OBJECT (shortcuts_pane->action_group));
 
+  g_object_unref (shortcuts_pane->drop_cancellable);
+
   (*G_OBJECT_CLASS (thunar_shortcuts_pane_parent_class)->finalize) (object);
 }
 
@@ -685,10 +727,24 @@ static gint thunar_shortcuts_pane_drag_action_requested (GtkPlacesSidebar    *si
   ThunarFile *th_dest_file;
   GdkDragAction suggested_action;
 
-  /* create ThunarFile* instances for the given file */
-  th_dest_file = thunar_file_get (dest_file, NULL);
+  /* this is called for every motion, so don't block on the file; if it
+   * is not cached yet, load it for the next motions and refuse for now */
+  th_dest_file = thunar_file_cache_lookup (dest_file);
+  if (G_UNLIKELY (th_dest_file == NULL))
+    {
+      if (shortcuts_pane->drag_dest_location == NULL
+          || !g_file_equal (shortcuts_pane->drag_dest_location, dest_file))
+        {
+          if (shortcuts_pane->drag_dest_location != NULL)
+            g_object_unref (shortcuts_pane->drag_dest_location);
+          shortcuts_pane->drag_dest_location = g_object_ref (dest_file);
 
-  _thunar_return_val_if_fail (th_dest_file != NULL, 0);
+          thunar_file_get_async (dest_file, shortcuts_pane->drop_cancellable,
+                                 thunar_shortcuts_pane_drag_dest_file_ready, shortcuts_pane);
+        }
+
+      return 0;
+    }
 
   /* check for allowed drop actions */
   thunar_file_accepts_drop (th_dest_file, source_file_list, context, &suggested_action);
@@ -707,21 +763,67 @@ void thunar_shortcuts_pane_drag_perform_drop (GtkPlacesSidebar    *sidebar,
                                               GdkDragAction        action,
                                               ThunarShortcutsPane *shortcuts_pane)
 {
-  ThunarFile *th_dest_file;
+  ThunarShortcutsPaneDrop *drop;
 
   if (G_UNLIKELY ((action & (GDK_ACTION_COPY | GDK_ACTION_MOVE | GDK_ACTION_LINK)) == 0))
     return;
 
-  /* get the thunar file */
-  th_dest_file = thunar_file_get (dest_file, NULL);
+  /* perform the drop once the thunar file is loaded */
+  drop = g_slice_new0 (ThunarShortcutsPaneDrop);
+  drop->shortcuts_pane = shortcuts_pane;
+  drop->cancellable = g_object_ref (shortcuts_pane->drop_cancellable);
+  drop->source_file_list = thunar_g_file_list_copy (source_file_list);
+  drop->action = action;
+
+  thunar_file_get_async (dest_file, drop->cancellable,
+                         thunar_shortcuts_pane_drag_drop_file_ready, drop);
+}
+
+
+
+static void
+thunar_shortcuts_pane_drag_dest_file_ready (GFile      *location,
+                                            ThunarFile *file,
+                                            GError     *error,
+                                            gpointer    user_data)
+{
+  ThunarShortcutsPane *shortcuts_pane = user_data;
+
+  /* the pane is gone */
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    return;
+
+  /* keep the file in the cache while the drag is over it */
+  if (shortcuts_pane->drag_dest_location != NULL
+      && g_file_equal (shortcuts_pane->drag_dest_location, location))
+    {
+      if (shortcuts_pane->drag_dest_file != NULL)
+        g_object_unref (shortcuts_pane->drag_dest_file);
+      shortcuts_pane->drag_dest_file = g_object_ref (file);
+    }
+}
+
 
-  _thunar_return_if_fail (th_dest_file != NULL);
 
-  /* perform the drop */
-  thunar_dnd_perform (GTK_WIDGET (shortcuts_pane), th_dest_file, source_file_list, action, NULL);
+static void
+thunar_shortcuts_pane_drag_drop_file_ready (GFile      *location,
+                                            ThunarFile *file,
+                                            GError     *error,
+                                            gpointer    user_data)
+{
+  ThunarShortcutsPaneDrop *drop = user_data;
+
+  /* perform the drop, unless the pane is gone */
+  if (error == NULL && !g_cancellable_is_cancelled (drop->cancellable))
+    {
+      thunar_dnd_perform (GTK_WIDGET (drop->shortcuts_pane), file,
+                          drop->source_file_list, drop->action, NULL);
+    }
 
   /* cleanup */
-  g_object_unref (th_dest_file);
+  thunar_g_file_list_free (drop->source_file_list);
+  g_object_unref (drop->cancellable);
+  g_slice_free (ThunarShortcutsPaneDrop, drop);
 }
 
 static void drag_ask_menu_copy_activated (GtkMenuItem   *menuitem,
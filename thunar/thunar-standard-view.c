@@ -98,6 +98,10 @@ enum
 
 
 
+typedef struct _ThunarStandardViewThumbnailBatch ThunarStandardViewThumbnailBatch;
+
+
+
 static void                 thunar_standard_view_component_init             (ThunarComponentIface     *iface);
 static void                 thunar_standard_view_navigator_init             (ThunarNavigatorIface     *iface);
 static void                 thunar_standard_view_view_init                  (ThunarViewIface          *iface);
@@ -128,6 +132,10 @@ static void                 thunar_standard_view_set_ui_manager             (Thu
 static ThunarFile          *thunar_standard_view_get_current_directory      (ThunarNavigator          *navigator);
 static void                 thunar_standard_view_set_current_directory      (ThunarNavigator          *navigator,
                                                                              ThunarFile               *current_directory);
+static void                 thunar_standard_view_set_folder                 (ThunarStandardView       *standard_view,
+                                                                             ThunarFolder             *folder);
+static void                 thunar_standard_view_show_folder                (ThunarStandardView       *standard_view,
+                                                                             ThunarFolder             *folder);
 static gboolean             thunar_standard_view_get_loading                (ThunarView               *view);
 static void                 thunar_standard_view_set_loading                (ThunarStandardView       *standard_view,
                                                                              gboolean                  loading);
@@ -193,6 +201,8 @@ static void                 thunar_standard_view_action_select_all_files    (Gtk
                                                                              ThunarStandardView       *standard_view);
 static void                 thunar_standard_view_action_select_by_pattern   (GtkAction                *action,
                                                                              ThunarStandardView       *standard_view);
+static void                 thunar_standard_view_action_search_files        (GtkAction                *action,
+                                                                             ThunarStandardView       *standard_view);
 static void                 thunar_standard_view_action_selection_invert    (GtkAction                *action,
                                                                              ThunarStandardView       *standard_view);
 static void                 thunar_standard_view_action_duplicate           (GtkAction                *action,
@@ -216,6 +226,15 @@ static gboolean             thunar_standard_view_motion_notify_event        (Gtk
 static gboolean             thunar_standard_view_key_press_event            (GtkWidget                *view,
                                                                              GdkEventKey              *event,
                                                                              ThunarStandardView       *standard_view);
+static gboolean             thunar_standard_view_filter_key_press_event     (ThunarStandardView       *standard_view,
+                                                                             GdkEventKey              *event);
+static void                 thunar_standard_view_filter_changed             (GtkEditable              *editable,
+                                                                             ThunarStandardView       *standard_view);
+static void                 thunar_standard_view_filter_hide                (ThunarStandardView       *standard_view,
+                                                                             gboolean                  clear);
+static gboolean             thunar_standard_view_filter_focus_out_event     (GtkWidget                *view,
+                                                                             GdkEventFocus            *event,
+                                                                             ThunarStandardView       *standard_view);
 static gboolean             thunar_standard_view_scroll_event               (GtkWidget                *view,
                                                                              GdkEventScroll           *event,
                                                                              ThunarStandardView       *standard_view);
@@ -292,6 +311,17 @@ static void                 thunar_standard_view_finished_thumbnailing      (Thu
                                                                              ThunarStandardView       *standard_view);
 static void                 thunar_standard_view_thumbnailing_destroyed     (gpointer                  data);
 static void                 thunar_standard_view_cancel_thumbnailing        (ThunarStandardView       *standard_view);
+static void                 thunar_standard_view_rows_moved                 (ThunarStandardView       *standard_view);
+static void                 thunar_standard_view_cancel_thumbnail_batches   (ThunarStandardView       *standard_view,
+                                                                             gint                      first_row,
+                                                                             gint                      last_row);
+static gboolean             thunar_standard_view_thumbnail_row_queued       (ThunarStandardView       *standard_view,
+                                                                             gint                      row);
+static void                 thunar_standard_view_queue_thumbnail_rows       (ThunarStandardView       *standard_view,
+                                                                             gint                      first_row,
+                                                                             gint                      last_row,
+                                                                             gboolean                  lazy_request,
+                                                                             gboolean                  visible);
 static void                 thunar_standard_view_schedule_thumbnail_timeout (ThunarStandardView       *standard_view);
 static void                 thunar_standard_view_schedule_thumbnail_idle    (ThunarStandardView       *standard_view);
 static gboolean             thunar_standard_view_request_thumbnails         (gpointer                  data);
@@ -384,7 +414,8 @@ struct _ThunarStandardViewPrivate
 
   /* support for generating thumbnails */
   ThunarThumbnailer      *thumbnailer;
-  guint                   thumbnail_request;
+  GSList                 *thumbnail_batches;
+  gint                    thumbnail_last_row;
   guint                   thumbnail_source_id;
   gboolean                thumbnailing_scheduled;
 
@@ -394,6 +425,26 @@ struct _ThunarStandardViewPrivate
   /* Tree path for restoring the selection after selecting and
    * deleting an item */
   GtkTreePath            *selection_before_delete;
+
+  /* type-to-filter support */
+  GtkWidget              *filter_window;
+  GtkWidget              *filter_entry;
+};
+
+struct _ThunarStandardViewThumbnailBatch
+{
+  /* request id returned by the thumbnailer */
+  guint    request;
+
+  /* range of rows covered by this request */
+  gint     first_row;
+  gint     last_row;
+
+  /* whether the rows were visible when the request was queued */
+  gboolean visible;
+
+  /* monotonic time when the request was queued */
+  gint64   queue_time;
 };
 
 
@@ -412,6 +463,7 @@ static const GtkActionEntry action_entries[] =
   { "paste-into-folder", "edit-paste", N_ ("Paste Into Folder"), NULL, N_ ("Move or copy files previously selected by a Cut or Copy command into the selected folder"), G_CALLBACK (thunar_standard_view_action_paste_into_folder), },
   { "select-all-files", NULL, N_ ("Select _all Files"), NULL, N_ ("Select all files in this window"), G_CALLBACK (thunar_standard_view_action_select_all_files), },
   { "select-by-pattern", NULL, N_ ("Select _by Pattern..."), "<control>S", N_ ("Select all files that match a certain pattern"), G_CALLBACK (thunar_standard_view_action_select_by_pattern), },
+  { "search-files", "edit-find", N_ ("_Search Files..."), "<control>F", N_ ("Search the current folder and its sub folders for files"), G_CALLBACK (thunar_standard_view_action_search_files), },
   { "invert-selection", NULL, N_ ("_Invert Selection"), NULL, N_ ("Select all and only the items that are not currently selected"), G_CALLBACK (thunar_standard_view_action_selection_invert), },
   { "duplicate", NULL, N_ ("Du_plicate"), NULL, NULL, G_CALLBACK (thunar_standard_view_action_duplicate), },
   { "make-link", NULL, N_ ("Ma_ke Link"), NULL, NULL, G_CALLBACK (thunar_standard_view_action_make_link), },
@@ -700,6 +752,12 @@ thunar_standard_view_init (ThunarStandardView *standard_view)
   standard_view->priv->row_changed_id = g_signal_connect (G_OBJECT (standard_view->model), "row-changed", G_CALLBACK (thunar_standard_view_row_changed), standard_view);
   g_signal_connect (G_OBJECT (standard_view->model), "rows-reordered", G_CALLBACK (thunar_standard_view_rows_reordered), standard_view);
   g_signal_connect (G_OBJECT (standard_view->model), "error", G_CALLBACK (thunar_standard_view_error), standard_view);
+
+  /* the thumbnail requests are tracked by row */
+  g_signal_connect_swapped (G_OBJECT (standard_view->model), "row-inserted", G_CALLBACK (thunar_standard_view_rows_moved), standard_view);
+  g_signal_connect_swapped (G_OBJECT (standard_view->model), "row-deleted", G_CALLBACK (thunar_standard_view_rows_moved), standard_view);
+  g_signal_connect_swapped (G_OBJECT (standard_view->model), "rows-reordered", G_CALLBACK (thunar_standard_view_rows_moved), standard_view);
+
   exo_binding_new (G_OBJECT (standard_view->preferences), "misc-case-sensitive", G_OBJECT (standard_view->model), "case-sensitive");
   exo_binding_new (G_OBJECT (standard_view->preferences), "misc-date-style", G_OBJECT (standard_view->model), "date-style");
   exo_binding_new (G_OBJECT (standard_view->preferences), "misc-folders-first", G_OBJECT (standard_view->model), "folders-first");
@@ -731,6 +789,9 @@ thunar_standard_view_init (ThunarStandardView *standard_view)
   /* be sure to update the statusbar text whenever the file-size-binary property changes */
   g_signal_connect_swapped (G_OBJECT (standard_view->model), "notify::file-size-binary", G_CALLBACK (thunar_standard_view_update_statusbar_text), standard_view);
 
+  /* the free space of the volume is determined asynchronously */
+  g_signal_connect_swapped (G_OBJECT (standard_view->model), "notify::free-space", G_CALLBACK (thunar_standard_view_update_statusbar_text), standard_view);
+
   /* connect to size allocation signals for generating thumbnail requests */
   g_signal_connect_after (G_OBJECT (standard_view), "size-allocate",
                           G_CALLBACK (thunar_standard_view_size_allocate), NULL);
@@ -791,6 +852,7 @@ thunar_standard_view_constructor (GType                  type,
 
   /* need to catch certain keys for the internal view widget */
   g_signal_connect (G_OBJECT (view), "key-press-event", G_CALLBACK (thunar_standard_view_key_press_event), object);
+  g_signal_connect (G_OBJECT (view), "focus-out-event", G_CALLBACK (thunar_standard_view_filter_focus_out_event), object);
 
   /* setup the real view as drop site */
   gtk_drag_dest_set (view, 0, drop_targets, G_N_ELEMENTS (drop_targets), GDK_ACTION_ASK | GDK_ACTION_COPY | GDK_ACTION_LINK | GDK_ACTION_MOVE);
@@ -843,6 +905,14 @@ thunar_standard_view_dispose (GObject *object)
   /* reset the UI manager property */
   thunar_component_set_ui_manager (THUNAR_COMPONENT (standard_view), NULL);
 
+  /* destroy the filter popup */
+  if (standard_view->priv->filter_window != NULL)
+    {
+      gtk_widget_destroy (standard_view->priv->filter_window);
+      standard_view->priv->filter_window = NULL;
+      standard_view->priv->filter_entry = NULL;
+    }
+
   /* disconnect from file */
   if (standard_view->priv->current_directory != NULL)
     {
@@ -1390,6 +1460,65 @@ thunar_standard_view_restore_selection_from_history (ThunarStandardView *standar
 
 
 
+static void
+thunar_standard_view_set_folder (ThunarStandardView *standard_view,
+                                 ThunarFolder       *folder)
+{
+  /* the selection handling on "row-deleted" is pointless when the whole
+   * folder is replaced, block it so the model can drop its rows at once */
+  g_signal_handlers_block_by_func (G_OBJECT (standard_view->model), thunar_standard_view_row_deleted, standard_view);
+  g_signal_handlers_block_by_func (G_OBJECT (standard_view->model), thunar_standard_view_select_after_row_deleted, standard_view);
+
+  thunar_list_model_set_folder (standard_view->model, folder);
+
+  g_signal_handlers_unblock_by_func (G_OBJECT (standard_view->model), thunar_standard_view_select_after_row_deleted, standard_view);
+  g_signal_handlers_unblock_by_func (G_OBJECT (standard_view->model), thunar_standard_view_row_deleted, standard_view);
+}
+
+
+
+static void
+thunar_standard_view_show_folder (ThunarStandardView *standard_view,
+                                  ThunarFolder       *folder)
+{
+  gboolean same_folder;
+
+  /* disconnect any previous "loading" binding */
+  if (G_LIKELY (standard_view->loading_binding != NULL))
+    exo_binding_unbind (standard_view->loading_binding);
+
+  /* We drop the model from the view as a simple optimization to speed up
+   * the process of disconnecting the model data from the view.
+   */
+  g_object_set (G_OBJECT (gtk_bin_get_child (GTK_BIN (standard_view))), "model", NULL, NULL);
+
+  /* connect the "loading" binding */
+  standard_view->loading_binding = exo_binding_new_full (G_OBJECT (folder), "loading",
+                                                         G_OBJECT (standard_view), "loading",
+                                                         NULL, thunar_standard_view_loading_unbound,
+                                                         standard_view);
+
+  /* the filter was typed for the previous folder; the model drops it
+   * together with the filtered rows when the folder changes, so clear
+   * the entry without moving those rows back into the model first */
+  same_folder = (thunar_list_model_get_folder (standard_view->model) == folder);
+  thunar_standard_view_filter_hide (standard_view, same_folder);
+  if (!same_folder && standard_view->priv->filter_entry != NULL)
+    {
+      g_signal_handlers_block_by_func (G_OBJECT (standard_view->priv->filter_entry), thunar_standard_view_filter_changed, standard_view);
+      gtk_entry_set_text (GTK_ENTRY (standard_view->priv->filter_entry), "");
+      g_signal_handlers_unblock_by_func (G_OBJECT (standard_view->priv->filter_entry), thunar_standard_view_filter_changed, standard_view);
+    }
+
+  /* apply the new folder */
+  thunar_standard_view_set_folder (standard_view, folder);
+
+  /* reconnect our model to the view */
+  g_object_set (G_OBJECT (gtk_bin_get_child (GTK_BIN (standard_view))), "model", standard_view->model, NULL);
+}
+
+
+
 static void
 thunar_standard_view_set_current_directory (ThunarNavigator *navigator,
                                             ThunarFile      *current_directory)
@@ -1437,7 +1566,7 @@ thunar_standard_view_set_current_directory (ThunarNavigator *navigator,
       g_object_set (G_OBJECT (gtk_bin_get_child (GTK_BIN (standard_view))), "model", NULL, NULL);
 
       /* reset the folder for the model */
-      thunar_list_model_set_folder (standard_view->model, NULL);
+      thunar_standard_view_set_folder (standard_view, NULL);
 
       /* reconnect the model to the view */
       g_object_set (G_OBJECT (gtk_bin_get_child (GTK_BIN (standard_view))), "model", standard_view->model, NULL);
@@ -1458,27 +1587,12 @@ thunar_standard_view_set_current_directory (ThunarNavigator *navigator,
   /* store the directory in the history */
   thunar_navigator_set_current_directory (THUNAR_NAVIGATOR (standard_view->priv->history), current_directory);
 
-  /* We drop the model from the view as a simple optimization to speed up
-   * the process of disconnecting the model data from the view.
-   */
-  g_object_set (G_OBJECT (gtk_bin_get_child (GTK_BIN (standard_view))), "model", NULL, NULL);
-
-  /* open the new directory as folder */
+  /* open the new directory as folder and keep it loaded for a while */
   folder = thunar_folder_get_for_file (current_directory);
-
-  /* connect the "loading" binding */
-  standard_view->loading_binding = exo_binding_new_full (G_OBJECT (folder), "loading",
-                                                         G_OBJECT (standard_view), "loading",
-                                                         NULL, thunar_standard_view_loading_unbound,
-                                                         standard_view);
-
-  /* apply the new folder */
-  thunar_list_model_set_folder (standard_view->model, folder);
+  thunar_folder_touch (folder);
+  thunar_standard_view_show_folder (standard_view, folder);
   g_object_unref (G_OBJECT (folder));
 
-  /* reconnect our model to the view */
-  g_object_set (G_OBJECT (gtk_bin_get_child (GTK_BIN (standard_view))), "model", standard_view->model, NULL);
-
   /* check if the new directory is in the trash */
   trashed = thunar_file_is_trashed (current_directory);
 
@@ -2674,6 +2788,144 @@ thunar_standard_view_action_select_by_pattern (GtkAction          *action,
 
 
 
+static void
+thunar_standard_view_action_search_files (GtkAction          *action,
+                                          ThunarStandardView *standard_view)
+{
+  ThunarSearchCriteria *criteria;
+  ThunarFolder         *folder;
+  const gchar          *pattern;
+  GtkWidget            *window;
+  GtkWidget            *dialog;
+  GtkWidget            *table;
+  GtkWidget            *label;
+  GtkWidget            *entry;
+  GtkWidget            *min_button;
+  GtkWidget            *max_button;
+  GtkWidget            *days_button;
+  guint64               min_size;
+  guint64               max_size;
+  guint64               days;
+  gint                  response;
+
+  _thunar_return_if_fail (GTK_IS_ACTION (action));
+  _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
+
+  /* we need a folder to search in */
+  if (G_UNLIKELY (standard_view->priv->current_directory == NULL))
+    return;
+
+  window = gtk_widget_get_toplevel (GTK_WIDGET (standard_view));
+  dialog = gtk_dialog_new_with_buttons (_("Search Files"),
+                                        GTK_WINDOW (window),
+                                        GTK_DIALOG_MODAL
+                                        | GTK_DIALOG_DESTROY_WITH_PARENT,
+                                        _("_Cancel"), GTK_RESPONSE_CANCEL,
+                                        _("_Search"), GTK_RESPONSE_OK,
+                                        NULL);
+  gtk_dialog_set_default_response (GTK_DIALOG (dialog), GTK_RESPONSE_OK);
+  gtk_window_set_default_size (GTK_WINDOW (dialog), 290, -1);
+
+  table = gtk_table_new (4, 2, FALSE);
+  gtk_table_set_row_spacings (GTK_TABLE (table), 6);
+  gtk_table_set_col_spacings (GTK_TABLE (table), 12);
+  gtk_container_set_border_width (GTK_CONTAINER (table), 6);
+  gtk_box_pack_start (GTK_BOX (gtk_dialog_get_content_area (GTK_DIALOG (dialog))), table, TRUE, TRUE, 0);
+  gtk_widget_show (table);
+
+  label = gtk_label_new_with_mnemonic (_("_Name:"));
+  gtk_misc_set_alignment (GTK_MISC (label), 0.0f, 0.5f);
+  gtk_table_attach (GTK_TABLE (table), label, 0, 1, 0, 1, GTK_FILL, GTK_FILL, 0, 0);
+  gtk_widget_show (label);
+
+  entry = gtk_entry_new ();
+  gtk_entry_set_activates_default (GTK_ENTRY (entry), TRUE);
+  gtk_widget_set_tooltip_text (entry, _("Part of the file name, or a pattern with * and ? wildcards. "
+                                        "Search with empty fields to show the folder contents again."));
+  gtk_table_attach (GTK_TABLE (table), entry, 1, 2, 0, 1, GTK_EXPAND | GTK_FILL, GTK_FILL, 0, 0);
+  gtk_label_set_mnemonic_widget (GTK_LABEL (label), entry);
+  gtk_widget_show (entry);
+
+  label = gtk_label_new_with_mnemonic (_("Size at _least (KiB):"));
+  gtk_misc_set_alignment (GTK_MISC (label), 0.0f, 0.5f);
+  gtk_table_attach (GTK_TABLE (table), label, 0, 1, 1, 2, GTK_FILL, GTK_FILL, 0, 0);
+  gtk_widget_show (label);
+
+  min_button = gtk_spin_button_new_with_range (0.0, G_MAXINT, 1.0);
+  gtk_entry_set_activates_default (GTK_ENTRY (min_button), TRUE);
+  gtk_table_attach (GTK_TABLE (table), min_button, 1, 2, 1, 2, GTK_EXPAND | GTK_FILL, GTK_FILL, 0, 0);
+  gtk_label_set_mnemonic_widget (GTK_LABEL (label), min_button);
+  gtk_widget_show (min_button);
+
+  label = gtk_label_new_with_mnemonic (_("Size at _most (KiB):"));
+  gtk_misc_set_alignment (GTK_MISC (label), 0.0f, 0.5f);
+  gtk_table_attach (GTK_TABLE (table), label, 0, 1, 2, 3, GTK_FILL, GTK_FILL, 0, 0);
+  gtk_widget_show (label);
+
+  max_button = gtk_spin_button_new_with_range (0.0, G_MAXINT, 1.0);
+  gtk_entry_set_activates_default (GTK_ENTRY (max_button), TRUE);
+  gtk_widget_set_tooltip_text (max_button, _("0 means no limit"));
+  gtk_table_attach (GTK_TABLE (table), max_button, 1, 2, 2, 3, GTK_EXPAND | GTK_FILL, GTK_FILL, 0, 0);
+  gtk_label_set_mnemonic_widget (GTK_LABEL (label), max_button);
+  gtk_widget_show (max_button);
+
+  label = gtk_label_new_with_mnemonic (_("Modified in the last _days:"));
+  gtk_misc_set_alignment (GTK_MISC (label), 0.0f, 0.5f);
+  gtk_table_attach (GTK_TABLE (table), label, 0, 1, 3, 4, GTK_FILL, GTK_FILL, 0, 0);
+  gtk_widget_show (label);
+
+  days_button = gtk_spin_button_new_with_range (0.0, 36500.0, 1.0);
+  gtk_entry_set_activates_default (GTK_ENTRY (days_button), TRUE);
+  gtk_widget_set_tooltip_text (days_button, _("0 means no limit"));
+  gtk_table_attach (GTK_TABLE (table), days_button, 1, 2, 3, 4, GTK_EXPAND | GTK_FILL, GTK_FILL, 0, 0);
+  gtk_label_set_mnemonic_widget (GTK_LABEL (label), days_button);
+  gtk_widget_show (days_button);
+
+  response = gtk_dialog_run (GTK_DIALOG (dialog));
+  if (response == GTK_RESPONSE_OK)
+    {
+      pattern = gtk_entry_get_text (GTK_ENTRY (entry));
+      min_size = gtk_spin_button_get_value_as_int (GTK_SPIN_BUTTON (min_button));
+      max_size = gtk_spin_button_get_value_as_int (GTK_SPIN_BUTTON (max_button));
+      days = gtk_spin_button_get_value_as_int (GTK_SPIN_BUTTON (days_button));
+
+      if (*pattern == '\0' && min_size == 0 && max_size == 0 && days == 0)
+        {
+          /* nothing to search for, show the folder contents again */
+          folder = thunar_folder_get_for_file (standard_view->priv->current_directory);
+        }
+      else
+        {
+          criteria = thunar_search_criteria_new (pattern);
+          criteria->min_size = min_size * 1024;
+          criteria->max_size = max_size * 1024;
+          if (days > 0)
+            criteria->modified_after = g_get_real_time () / G_USEC_PER_SEC - days * 24 * 60 * 60;
+
+          /* the depth and the number of threads are hidden settings */
+          g_object_get (G_OBJECT (standard_view->preferences),
+                        "misc-search-max-depth", &criteria->max_depth,
+                        "misc-search-threads", &criteria->n_threads,
+                        NULL);
+
+          /* show the matches while the folder is searched */
+          folder = thunar_folder_new_for_search (standard_view->priv->current_directory, criteria);
+          thunar_search_criteria_free (criteria);
+        }
+
+      if (G_LIKELY (folder != NULL))
+        {
+          thunar_standard_view_cancel_thumbnailing (standard_view);
+          thunar_standard_view_show_folder (standard_view, folder);
+          g_object_unref (G_OBJECT (folder));
+        }
+    }
+
+  gtk_widget_destroy (dialog);
+}
+
+
+
 static void
 thunar_standard_view_action_selection_invert (GtkAction          *action,
                                               ThunarStandardView *standard_view)
@@ -3123,6 +3375,10 @@ thunar_standard_view_key_press_event (GtkWidget          *view,
 {
   _thunar_return_val_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view), FALSE);
 
+  /* the filter popup gets the keys while it's shown */
+  if (thunar_standard_view_filter_key_press_event (standard_view, event))
+    return TRUE;
+
   /* need to catch "/" and "~" first, as the views would otherwise start interactive search */
   if ((event->keyval == GDK_KEY_slash || event->keyval == GDK_KEY_asciitilde || event->keyval == GDK_KEY_dead_tilde) && !(event->state & (~GDK_SHIFT_MASK & gtk_accelerator_get_default_mod_mask ())))
     {
@@ -3140,6 +3396,163 @@ thunar_standard_view_key_press_event (GtkWidget          *view,
 
 
 
+static gboolean
+thunar_standard_view_filter_key_press_event (ThunarStandardView *standard_view,
+                                             GdkEventKey        *event)
+{
+  GtkWidget      *toplevel;
+  GtkWidget      *frame;
+  GtkAllocation   allocation;
+  GtkRequisition  requisition;
+  GdkEvent       *focus_event;
+  gboolean        misc_type_to_filter;
+  gunichar        c;
+  gint            x, y;
+
+  if (standard_view->priv->filter_window == NULL
+      || !gtk_widget_get_visible (standard_view->priv->filter_window))
+    {
+      /* start filtering with a printable character, unless disabled */
+      c = gdk_keyval_to_unicode (event->keyval);
+      if (!g_unichar_isgraph (c)
+          || (event->state & (GDK_CONTROL_MASK | GDK_MOD1_MASK)) != 0
+          || event->keyval == GDK_KEY_slash
+          || event->keyval == GDK_KEY_asciitilde)
+        return FALSE;
+
+      g_object_get (G_OBJECT (standard_view->preferences), "misc-type-to-filter", &misc_type_to_filter, NULL);
+      if (!misc_type_to_filter)
+        return FALSE;
+
+      if (standard_view->priv->filter_window == NULL)
+        {
+          standard_view->priv->filter_window = gtk_window_new (GTK_WINDOW_POPUP);
+          gtk_window_set_screen (GTK_WINDOW (standard_view->priv->filter_window),
+                                 gtk_widget_get_screen (GTK_WIDGET (standard_view)));
+
+          toplevel = gtk_widget_get_toplevel (GTK_WIDGET (standard_view));
+          if (GTK_IS_WINDOW (toplevel))
+            gtk_window_group_add_window (gtk_window_get_group (GTK_WINDOW (toplevel)),
+                                         GTK_WINDOW (standard_view->priv->filter_window));
+
+          frame = gtk_frame_new (NULL);
+          gtk_frame_set_shadow_type (GTK_FRAME (frame), GTK_SHADOW_ETCHED_IN);
+          gtk_container_add (GTK_CONTAINER (standard_view->priv->filter_window), frame);
+          gtk_widget_show (frame);
+
+          standard_view->priv->filter_entry = gtk_entry_new ();
+          g_signal_connect (G_OBJECT (standard_view->priv->filter_entry), "changed",
+                            G_CALLBACK (thunar_standard_view_filter_changed), standard_view);
+          gtk_container_add (GTK_CONTAINER (frame), standard_view->priv->filter_entry);
+          gtk_widget_show (standard_view->priv->filter_entry);
+        }
+
+      /* place the popup in the bottom right corner of the view */
+      gtk_widget_realize (standard_view->priv->filter_window);
+      gtk_widget_get_preferred_size (standard_view->priv->filter_window, NULL, &requisition);
+      gtk_widget_get_allocation (GTK_WIDGET (standard_view), &allocation);
+      gdk_window_get_origin (gtk_widget_get_window (GTK_WIDGET (standard_view)), &x, &y);
+      gtk_window_move (GTK_WINDOW (standard_view->priv->filter_window),
+                       x + allocation.x + MAX (allocation.width - requisition.width, 0),
+                       y + allocation.y + MAX (allocation.height - requisition.height, 0));
+      gtk_widget_show (standard_view->priv->filter_window);
+
+      /* the view keeps the focus, so fake it for the entry cursor */
+      focus_event = gdk_event_new (GDK_FOCUS_CHANGE);
+      focus_event->focus_change.window = g_object_ref (gtk_widget_get_window (standard_view->priv->filter_entry));
+      focus_event->focus_change.in = TRUE;
+      gtk_widget_send_focus_change (standard_view->priv->filter_entry, focus_event);
+      gdk_event_free (focus_event);
+    }
+
+  switch (event->keyval)
+    {
+    case GDK_KEY_Escape:
+      /* show all files again */
+      thunar_standard_view_filter_hide (standard_view, TRUE);
+      return TRUE;
+
+    case GDK_KEY_Return:
+    case GDK_KEY_KP_Enter:
+      /* keep the filter and continue in the view */
+      thunar_standard_view_filter_hide (standard_view, FALSE);
+      return TRUE;
+
+    case GDK_KEY_Up:
+    case GDK_KEY_Down:
+    case GDK_KEY_Page_Up:
+    case GDK_KEY_Page_Down:
+    case GDK_KEY_Home:
+    case GDK_KEY_End:
+      /* let the view move the cursor */
+      return FALSE;
+
+    default:
+      /* everything else edits the filter */
+      gtk_widget_event (standard_view->priv->filter_entry, (GdkEvent *) event);
+      return TRUE;
+    }
+}
+
+
+
+static void
+thunar_standard_view_filter_changed (GtkEditable        *editable,
+                                     ThunarStandardView *standard_view)
+{
+  _thunar_return_if_fail (GTK_IS_ENTRY (editable));
+  _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
+
+  /* the model only tests the rows affected by the change */
+  thunar_list_model_set_filter (standard_view->model, gtk_entry_get_text (GTK_ENTRY (editable)));
+}
+
+
+
+static void
+thunar_standard_view_filter_hide (ThunarStandardView *standard_view,
+                                  gboolean            clear)
+{
+  GdkEvent *focus_event;
+
+  _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
+
+  if (standard_view->priv->filter_window == NULL)
+    return;
+
+  if (gtk_widget_get_visible (standard_view->priv->filter_window))
+    {
+      focus_event = gdk_event_new (GDK_FOCUS_CHANGE);
+      focus_event->focus_change.window = g_object_ref (gtk_widget_get_window (standard_view->priv->filter_entry));
+      focus_event->focus_change.in = FALSE;
+      gtk_widget_send_focus_change (standard_view->priv->filter_entry, focus_event);
+      gdk_event_free (focus_event);
+
+      gtk_widget_hide (standard_view->priv->filter_window);
+    }
+
+  /* clearing the entry resets the filter of the model */
+  if (clear)
+    gtk_entry_set_text (GTK_ENTRY (standard_view->priv->filter_entry), "");
+}
+
+
+
+static gboolean
+thunar_standard_view_filter_focus_out_event (GtkWidget          *view,
+                                             GdkEventFocus      *event,
+                                             ThunarStandardView *standard_view)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view), FALSE);
+
+  /* keep the filter, but stop typing into it */
+  thunar_standard_view_filter_hide (standard_view, FALSE);
+
+  return FALSE;
+}
+
+
+
 static gboolean
 thunar_standard_view_drag_drop (GtkWidget          *view,
                                 GdkDragContext     *context,
@@ -3593,19 +4006,14 @@ thunar_standard_view_drag_begin (GtkWidget          *view,
   standard_view->priv->drag_g_file_list = thunar_file_list_to_thunar_g_file_list (standard_view->priv->selected_files);
   if (G_LIKELY (standard_view->priv->drag_g_file_list != NULL))
     {
-      /* determine the first selected file */
-      file = thunar_file_get (standard_view->priv->drag_g_file_list->data, NULL);
-      if (G_LIKELY (file != NULL))
-        {
-          /* generate an icon based on that file */
-          g_object_get (G_OBJECT (standard_view->icon_renderer), "size", &size, NULL);
-          icon = thunar_icon_factory_load_file_icon (standard_view->icon_factory, file, THUNAR_FILE_ICON_STATE_DEFAULT, size);
-          gtk_drag_set_icon_pixbuf (context, icon, 0, 0);
-          g_object_unref (G_OBJECT (icon));
+      /* determine the first selected file, without looking it up again */
+      file = THUNAR_FILE (standard_view->priv->selected_files->data);
 
-          /* release the file */
-          g_object_unref (G_OBJECT (file));
-        }
+      /* generate an icon based on that file */
+      g_object_get (G_OBJECT (standard_view->icon_renderer), "size", &size, NULL);
+      icon = thunar_icon_factory_load_file_icon (standard_view->icon_factory, file, THUNAR_FILE_ICON_STATE_DEFAULT, size);
+      gtk_drag_set_icon_pixbuf (context, icon, 0, 0);
+      g_object_unref (G_OBJECT (icon));
     }
 }
 
@@ -3766,28 +4174,27 @@ thunar_standard_view_row_changed (ThunarListModel    *model,
                                   ThunarStandardView *standard_view)
 {
   ThunarFile *file;
+  gint        row;
 
   _thunar_return_if_fail (THUNAR_IS_LIST_MODEL (model));
   _thunar_return_if_fail (path != NULL);
   _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
   _thunar_return_if_fail (standard_view->model == model);
 
-  if (standard_view->priv->thumbnail_request != 0)
-    return;
-
   /* leave if this view is not suitable for generating thumbnails */
   if (!thunar_icon_factory_get_show_thumbnail (standard_view->icon_factory,
                                                standard_view->priv->current_directory))
     return;
 
-  /* queue a thumbnail request */
+  /* nothing to do if the row is already part of a pending request */
+  row = gtk_tree_path_get_indices (path)[0];
+  if (thunar_standard_view_thumbnail_row_queued (standard_view, row))
+    return;
+
+  /* queue a thumbnail request for this row, in addition to the pending ones */
   file = thunar_list_model_get_file (standard_view->model, iter);
   if (thunar_file_get_thumb_state (file) == THUNAR_FILE_THUMB_STATE_UNKNOWN)
-    {
-      thunar_standard_view_cancel_thumbnailing (standard_view);
-      thunar_thumbnailer_queue_file (standard_view->priv->thumbnailer, file,
-                                     &standard_view->priv->thumbnail_request);
-    }
+    thunar_standard_view_queue_thumbnail_rows (standard_view, row, row, FALSE, FALSE);
   g_object_unref (G_OBJECT (file));
 }
 
@@ -3996,10 +4403,33 @@ thunar_standard_view_finished_thumbnailing (ThunarThumbnailer  *thumbnailer,
                                             guint               request,
                                             ThunarStandardView *standard_view)
 {
+  ThunarStandardViewThumbnailBatch *batch;
+  GSList                           *lp;
+
   _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
 
-  if (standard_view->priv->thumbnail_request == request)
-    standard_view->priv->thumbnail_request = 0;
+  for (lp = standard_view->priv->thumbnail_batches; lp != NULL; lp = lp->next)
+    {
+      batch = lp->data;
+      if (batch->request == request)
+        {
+#ifdef G_ENABLE_DEBUG
+          if (batch->visible)
+            {
+              g_debug ("thumbnails for visible rows %d-%d ready after %.1f ms "
+                       "(%u requests outstanding)",
+                       batch->first_row, batch->last_row,
+                       (g_get_monotonic_time () - batch->queue_time) / 1000.0,
+                       g_slist_length (standard_view->priv->thumbnail_batches) - 1);
+            }
+#endif
+
+          standard_view->priv->thumbnail_batches =
+            g_slist_delete_link (standard_view->priv->thumbnail_batches, lp);
+          g_slice_free (ThunarStandardViewThumbnailBatch, batch);
+          break;
+        }
+    }
 }
 
 
@@ -4025,14 +4455,138 @@ thunar_standard_view_cancel_thumbnailing (ThunarStandardView *standard_view)
   if (standard_view->priv->thumbnail_source_id > 0)
     g_source_remove (standard_view->priv->thumbnail_source_id);
 
-  /* check if we have a pending thumbnail request */
-  if (standard_view->priv->thumbnail_request > 0)
+  /* cancel all pending thumbnail requests */
+  thunar_standard_view_cancel_thumbnail_batches (standard_view, -1, -1);
+}
+
+
+
+static void
+thunar_standard_view_rows_moved (ThunarStandardView *standard_view)
+{
+  _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
+
+  /* the rows of the queued requests don't match the files anymore,
+   * so queue the requests again for the rows now in view */
+  if (standard_view->priv->thumbnail_batches != NULL)
+    {
+      thunar_standard_view_cancel_thumbnail_batches (standard_view, -1, -1);
+      thunar_standard_view_schedule_thumbnail_timeout (standard_view);
+    }
+}
+
+
+
+static void
+thunar_standard_view_cancel_thumbnail_batches (ThunarStandardView *standard_view,
+                                               gint                first_row,
+                                               gint                last_row)
+{
+  ThunarStandardViewThumbnailBatch *batch;
+  GSList                           *lp, *lnext;
+
+  _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
+
+  /* dequeue every request that does not overlap the given row range,
+   * or all requests if the range is empty */
+  for (lp = standard_view->priv->thumbnail_batches; lp != NULL; lp = lnext)
+    {
+      lnext = lp->next;
+      batch = lp->data;
+
+      if (first_row <= last_row
+          && batch->last_row >= first_row
+          && batch->first_row <= last_row)
+        continue;
+
+      thunar_thumbnailer_dequeue (standard_view->priv->thumbnailer, batch->request);
+
+#ifdef G_ENABLE_DEBUG
+      if (batch->visible)
+        {
+          g_debug ("thumbnails for visible rows %d-%d cancelled after %.1f ms",
+                   batch->first_row, batch->last_row,
+                   (g_get_monotonic_time () - batch->queue_time) / 1000.0);
+        }
+#endif
+
+      standard_view->priv->thumbnail_batches =
+        g_slist_delete_link (standard_view->priv->thumbnail_batches, lp);
+      g_slice_free (ThunarStandardViewThumbnailBatch, batch);
+    }
+}
+
+
+
+static gboolean
+thunar_standard_view_thumbnail_row_queued (ThunarStandardView *standard_view,
+                                           gint                row)
+{
+  ThunarStandardViewThumbnailBatch *batch;
+  GSList                           *lp;
+
+  for (lp = standard_view->priv->thumbnail_batches; lp != NULL; lp = lp->next)
+    {
+      batch = lp->data;
+      if (row >= batch->first_row && row <= batch->last_row)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+
+
+static void
+thunar_standard_view_queue_thumbnail_rows (ThunarStandardView *standard_view,
+                                           gint                first_row,
+                                           gint                last_row,
+                                           gboolean            lazy_request,
+                                           gboolean            visible)
+{
+  ThunarStandardViewThumbnailBatch *batch;
+  GtkTreeIter                       iter;
+  gboolean                          valid_iter;
+  GList                            *files = NULL;
+  guint                             request = 0;
+  gint                              row;
+
+  _thunar_return_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view));
+
+  if (first_row > last_row)
+    return;
+
+  /* collect all files in the range that are not part of a pending request */
+  valid_iter = gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (standard_view->model),
+                                              &iter, NULL, first_row);
+  for (row = first_row; valid_iter && row <= last_row; ++row)
     {
-      /* cancel the request */
-      thunar_thumbnailer_dequeue (standard_view->priv->thumbnailer,
-                                  standard_view->priv->thumbnail_request);
-      standard_view->priv->thumbnail_request = 0;
+      if (!thunar_standard_view_thumbnail_row_queued (standard_view, row))
+        files = g_list_prepend (files, thunar_list_model_get_file (standard_view->model, &iter));
+
+      valid_iter = gtk_tree_model_iter_next (GTK_TREE_MODEL (standard_view->model), &iter);
     }
+
+  if (files == NULL)
+    return;
+
+  /* visible rows use the foreground scheduler of the thumbnailer, the
+   * prefetched ones are generated when there is nothing else to do */
+  if (thunar_thumbnailer_queue_files (standard_view->priv->thumbnailer,
+                                      lazy_request, !visible, files, &request)
+      && request != 0)
+    {
+      batch = g_slice_new0 (ThunarStandardViewThumbnailBatch);
+      batch->request = request;
+      batch->first_row = first_row;
+      batch->last_row = last_row;
+      batch->visible = visible;
+      batch->queue_time = g_get_monotonic_time ();
+      standard_view->priv->thumbnail_batches =
+        g_slist_prepend (standard_view->priv->thumbnail_batches, batch);
+    }
+
+  g_list_free_full (files, g_object_unref);
 }
 
 
@@ -4052,8 +4606,11 @@ thunar_standard_view_schedule_thumbnail_timeout (ThunarStandardView *standard_vi
       return;
     }
 
-  /* cancel any pending thumbnail sources and requests */
-  thunar_standard_view_cancel_thumbnailing (standard_view);
+  /* reschedule the pending timeout, but keep the outstanding requests,
+   * the ones that are too far away from the new visible range are
+   * dropped once the timeout fires */
+  if (standard_view->priv->thumbnail_source_id > 0)
+    g_source_remove (standard_view->priv->thumbnail_source_id);
 
   /* schedule the timeout handler */
   g_assert (standard_view->priv->thumbnail_source_id == 0);
@@ -4097,11 +4654,15 @@ thunar_standard_view_request_thumbnails_real (ThunarStandardView *standard_view,
 {
   GtkTreePath *start_path;
   GtkTreePath *end_path;
-  GtkTreePath *path;
-  GtkTreeIter  iter;
-  ThunarFile  *file;
-  gboolean     valid_iter;
-  GList       *visible_files = NULL;
+  gint         first_row;
+  gint         last_row;
+  gint         n_rows;
+  gint         n_visible;
+  gint         n_ahead;
+  gint         n_behind;
+  gint         margin;
+  guint        prefetch_pages;
+  gboolean     scrolling_up;
 
   _thunar_return_val_if_fail (THUNAR_IS_STANDARD_VIEW (standard_view), FALSE);
   _thunar_return_val_if_fail (THUNAR_IS_ICON_FACTORY (standard_view->icon_factory), FALSE);
@@ -4120,41 +4681,47 @@ thunar_standard_view_request_thumbnails_real (ThunarStandardView *standard_view,
                                                                             &start_path,
                                                                             &end_path))
     {
-      /* iterate over the range to collect all files */
-      valid_iter = gtk_tree_model_get_iter (GTK_TREE_MODEL (standard_view->model),
-                                            &iter, start_path);
-
-      while (valid_iter)
+      first_row = gtk_tree_path_get_indices (start_path)[0];
+      last_row = gtk_tree_path_get_indices (end_path)[0];
+      n_rows = gtk_tree_model_iter_n_children (GTK_TREE_MODEL (standard_view->model), NULL);
+      n_visible = last_row - first_row + 1;
+
+      /* the prefetch ring extends mostly in the scroll direction */
+      g_object_get (G_OBJECT (standard_view->preferences), "misc-thumbnail-prefetch-pages", &prefetch_pages, NULL);
+      scrolling_up = (first_row < standard_view->priv->thumbnail_last_row);
+      n_ahead = prefetch_pages * n_visible;
+      n_behind = n_ahead / 2;
+      standard_view->priv->thumbnail_last_row = first_row;
+
+      /* drop the requests that are far out of the new range */
+      margin = n_ahead + n_visible;
+      thunar_standard_view_cancel_thumbnail_batches (standard_view,
+                                                     MAX (first_row - margin, 0),
+                                                     last_row + margin);
+
+      /* visible rows first */
+      thunar_standard_view_queue_thumbnail_rows (standard_view, first_row, last_row,
+                                                 lazy_request, TRUE);
+
+      /* then the rows ahead and behind the viewport */
+      if (scrolling_up)
         {
-          /* prepend the file to the visible items list */
-          file = thunar_list_model_get_file (standard_view->model, &iter);
-          visible_files = g_list_prepend (visible_files, file);
-
-          /* check if we've reached the end of the visible range */
-          path = gtk_tree_model_get_path (GTK_TREE_MODEL (standard_view->model), &iter);
-          if (gtk_tree_path_compare (path, end_path) != 0)
-            {
-              /* try to compute the next visible item */
-              valid_iter =
-                gtk_tree_model_iter_next (GTK_TREE_MODEL (standard_view->model), &iter);
-            }
-          else
-            {
-              /* we have reached the end, terminate the loop */
-              valid_iter = FALSE;
-            }
-
-          /* release the tree path */
-          gtk_tree_path_free (path);
+          thunar_standard_view_queue_thumbnail_rows (standard_view,
+                                                     MAX (first_row - n_ahead, 0),
+                                                     first_row - 1, TRUE, FALSE);
+          thunar_standard_view_queue_thumbnail_rows (standard_view, last_row + 1,
+                                                     MIN (last_row + n_behind, n_rows - 1),
+                                                     TRUE, FALSE);
+        }
+      else
+        {
+          thunar_standard_view_queue_thumbnail_rows (standard_view, last_row + 1,
+                                                     MIN (last_row + n_ahead, n_rows - 1),
+                                                     TRUE, FALSE);
+          thunar_standard_view_queue_thumbnail_rows (standard_view,
+                                                     MAX (first_row - n_behind, 0),
+                                                     first_row - 1, TRUE, FALSE);
         }
-
-      /* queue a thumbnail request */
-      thunar_thumbnailer_queue_files (standard_view->priv->thumbnailer,
-                                      lazy_request, visible_files,
-                                      &standard_view->priv->thumbnail_request);
-
-      /* release the file list */
-      g_list_free_full (visible_files, g_object_unref);
 
       /* release the start and end path */
       gtk_tree_path_free (start_path);
@@ -697,6 +697,49 @@ thunar_thumbnail_cache_cleanup_file (ThunarThumbnailCache *cache,
 
 
 
+void
+thunar_thumbnail_cache_cleanup_files (ThunarThumbnailCache *cache,
+                                      GList                *files)
+{
+  GList *lp;
+
+  _thunar_return_if_fail (THUNAR_IS_THUMBNAIL_CACHE (cache));
+
+  if (G_UNLIKELY (files == NULL))
+    return;
+
+  /* acquire a cache lock */
+  _thumbnail_cache_lock (cache);
+
+  /* check if we have a valid proxy for the cache service */
+  if (cache->proxy_state != THUNAR_THUMBNAIL_CACHE_PROXY_FAILED)
+    {
+      /* add the files to the cleanup queue */
+      for (lp = files; lp != NULL; lp = lp->next)
+        cache->cleanup_queue = g_list_prepend (cache->cleanup_queue, g_object_ref (lp->data));
+    }
+
+  if (cache->proxy_state == THUNAR_THUMBNAIL_CACHE_PROXY_AVAILABLE)
+    {
+      /* cancel any pending timeout to process the cleanup queue */
+      if (cache->cleanup_queue_idle_id > 0)
+        {
+          g_source_remove (cache->cleanup_queue_idle_id);
+          cache->cleanup_queue_idle_id = 0;
+        }
+
+      /* process the cleanup queue in a 1000ms timeout */
+      cache->cleanup_queue_idle_id =
+        g_timeout_add (1000, (GSourceFunc) thunar_thumbnail_cache_process_cleanup_queue,
+                       cache);
+    }
+
+  /* release the cache lock */
+  _thumbnail_cache_unlock (cache);
+}
+
+
+
 static void
 thunar_thumbnail_cache_proxy_created (GObject      *source,
                                       GAsyncResult *res,
@@ -183,6 +183,9 @@ struct _ThunarThumbnailerJob
 
   guint              lazy_checks : 1;
 
+  /* if this job should use the tumbler background scheduler */
+  guint              background : 1;
+
   /* data is saved here in case the queueing is delayed */
   /* If this is NULL, the request has been sent off. */
   GList             *files; /* element type: ThunarFile */
@@ -410,7 +413,9 @@ thunar_thumbnailer_begin_job (ThunarThumbnailer *thumbnailer,
       thunar_thumbnailer_dbus_call_queue (thumbnailer->thumbnailer_proxy,
                                           (const gchar *const *)uris,
                                           (const gchar *const *)mime_hints,
-                                          "normal", "foreground", 0,
+                                          "normal",
+                                          job->background ? "background" : "foreground",
+                                          0,
                                           NULL,
                                           thunar_thumbnailer_queue_async_reply,
                                           job);
@@ -994,7 +999,7 @@ thunar_thumbnailer_queue_file (ThunarThumbnailer *thumbnailer,
   files.prev = NULL;
 
   /* queue a thumbnail request for the file */
-  return thunar_thumbnailer_queue_files (thumbnailer, FALSE, &files, request);
+  return thunar_thumbnailer_queue_files (thumbnailer, FALSE, FALSE, &files, request);
 }
 
 
@@ -1002,6 +1007,7 @@ thunar_thumbnailer_queue_file (ThunarThumbnailer *thumbnailer,
 gboolean
 thunar_thumbnailer_queue_files (ThunarThumbnailer *thumbnailer,
                                 gboolean           lazy_checks,
+                                gboolean           background,
                                 GList             *files,
                                 guint             *request)
 {
@@ -1019,12 +1025,13 @@ thunar_thumbnailer_queue_files (ThunarThumbnailer *thumbnailer,
   job->thumbnailer = thumbnailer;
   job->files = g_list_copy_deep (files, (GCopyFunc)g_object_ref, NULL);
   job->lazy_checks = lazy_checks ? 1 : 0;
+  job->background = background ? 1 : 0;
 
   success = thunar_thumbnailer_begin_job (thumbnailer, job);
   if (success)
     {
       thumbnailer->jobs = g_slist_prepend (thumbnailer->jobs, job);
-      if (*request)
+      if (request != NULL)
         *request = job->request;
     }
   else
@@ -44,6 +44,7 @@ gboolean           thunar_thumbnailer_queue_file      (ThunarThumbnailer
                                                        guint                    *request);
 gboolean           thunar_thumbnailer_queue_files     (ThunarThumbnailer        *thumbnailer,
                                                        gboolean                  lazy_checks,
+                                                       gboolean                  background,
                                                        GList                    *files,
                                                        guint                    *request);
 void               thunar_thumbnailer_dequeue         (ThunarThumbnailer        *thumbnailer,
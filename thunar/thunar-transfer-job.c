@@ -497,7 +497,7 @@ thunar_transfer_job_copy_file (ThunarTransferJob *job,
   ThunarJobResponse response;
   GFileCopyFlags    copy_flags = G_FILE_COPY_NOFOLLOW_SYMLINKS;
   GError           *err = NULL;
-  gint              n;
+  guint             n;
 
   _thunar_return_val_if_fail (THUNAR_IS_TRANSFER_JOB (job), NULL);
   _thunar_return_val_if_fail (G_IS_FILE (source_file), NULL);
@@ -526,7 +526,7 @@ thunar_transfer_job_copy_file (ThunarTransferJob *job,
             {
               GFile *duplicate_file = thunar_io_jobs_util_next_duplicate_file (THUNAR_JOB (job),
                                                                                source_file,
-                                                                               TRUE, n,
+                                                                               TRUE, &n,
                                                                                &err);
 
               if (err == NULL)
@@ -1732,6 +1732,7 @@ thunar_window_notebook_insert (ThunarWindow *window,
                                ThunarFile   *directory)
 {
   ThunarHistory  *history = NULL;
+  GtkAction      *action;
   GtkWidget      *view;
   gint            page_num;
   GtkWidget      *label;
@@ -1752,8 +1753,12 @@ thunar_window_notebook_insert (ThunarWindow *window,
   if (THUNAR_IS_STANDARD_VIEW (window->view))
     history = thunar_standard_view_copy_history (THUNAR_STANDARD_VIEW (window->view));
 
-  /* allocate and setup a new view */
-  view = g_object_new (window->view_type, "current-directory", directory, NULL);
+  /* allocate and setup a new view, apply the hidden files setting before
+   * the directory, so the model can take over the rows of another view */
+  action = gtk_action_group_get_action (window->action_group, "show-hidden");
+  view = g_object_new (window->view_type,
+                       "show-hidden", gtk_toggle_action_get_active (GTK_TOGGLE_ACTION (action)),
+                       "current-directory", directory, NULL);
   gtk_widget_show (view);
 
   /* use the history of the origin view if available */
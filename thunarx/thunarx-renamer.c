@@ -37,6 +37,7 @@
 enum
 {
   PROP_0,
+  PROP_BUSY,
   PROP_HELP_URL,
   PROP_NAME,
 };
@@ -78,8 +79,9 @@ static GList   *thunarx_renamer_real_get_actions  (ThunarxRenamer         *renam
 
 struct _ThunarxRenamerPrivate
 {
-  gchar *help_url;
-  gchar *name;
+  gchar   *help_url;
+  gchar   *name;
+  gboolean busy;
 };
 
 
@@ -111,6 +113,25 @@ thunarx_renamer_class_init (ThunarxRenamerClass *klass)
   klass->save = thunarx_renamer_real_save;
   klass->get_actions = thunarx_renamer_real_get_actions;
 
+  /**
+   * ThunarxRenamer:busy:
+   *
+   * %TRUE while the renamer is still collecting data in the
+   * background and the names it returns are not final yet.
+   * The file manager will not rename files while the renamer
+   * is busy. Derived classes should emit the
+   * ThunarxRenamer::changed signal once they are done.
+   *
+   * Since: 1.6.12
+   **/
+  g_object_class_install_property (gobject_class,
+                                   PROP_BUSY,
+                                   g_param_spec_boolean ("busy",
+                                                         _("Busy"),
+                                                         _("Whether the renamer is still collecting data"),
+                                                         FALSE,
+                                                         G_PARAM_READWRITE));
+
   /**
    * ThunarxRenamer:help-url:
    *
@@ -227,6 +248,10 @@ thunarx_renamer_get_property (GObject    *object,
 
   switch (prop_id)
     {
+    case PROP_BUSY:
+      g_value_set_boolean (value, thunarx_renamer_get_busy (renamer));
+      break;
+
     case PROP_HELP_URL:
       g_value_set_string (value, thunarx_renamer_get_help_url (renamer));
       break;
@@ -253,6 +278,10 @@ thunarx_renamer_set_property (GObject      *object,
 
   switch (prop_id)
     {
+    case PROP_BUSY:
+      thunarx_renamer_set_busy (renamer, g_value_get_boolean (value));
+      break;
+
     case PROP_HELP_URL:
       thunarx_renamer_set_help_url (renamer, g_value_get_string (value));
       break;
@@ -389,6 +418,57 @@ thunarx_renamer_real_get_actions (ThunarxRenamer *renamer,
 
 
 
+/**
+ * thunarx_renamer_get_busy:
+ * @renamer : a #ThunarxRenamer.
+ *
+ * Returns %TRUE if @renamer is still collecting data
+ * in the background, see thunarx_renamer_set_busy().
+ *
+ * Return value: %TRUE if @renamer is busy.
+ *
+ * Since: 1.6.12
+ **/
+gboolean
+thunarx_renamer_get_busy (ThunarxRenamer *renamer)
+{
+  g_return_val_if_fail (THUNARX_IS_RENAMER (renamer), FALSE);
+  return renamer->priv->busy;
+}
+
+
+
+/**
+ * thunarx_renamer_set_busy:
+ * @renamer : a #ThunarxRenamer.
+ * @busy    : %TRUE if @renamer is collecting data.
+ *
+ * Derived classes that determine the new names in the
+ * background should set @busy to %TRUE while the names
+ * returned from thunarx_renamer_process() are not final,
+ * and reset it to %FALSE afterwards. The file manager will
+ * not rename files while the @renamer is busy.
+ *
+ * Since: 1.6.12
+ **/
+void
+thunarx_renamer_set_busy (ThunarxRenamer *renamer,
+                          gboolean        busy)
+{
+  g_return_if_fail (THUNARX_IS_RENAMER (renamer));
+
+  if (renamer->priv->busy != !!busy)
+    {
+      /* apply the new value */
+      renamer->priv->busy = !!busy;
+
+      /* notify listeners */
+      g_object_notify (G_OBJECT (renamer), "busy");
+    }
+}
+
+
+
 /**
  * thunarx_renamer_get_help_url:
  * @renamer : a #ThunarxRenamer.